@@ -15,6 +15,7 @@
 #ifndef DOM_PARSER_DOM_LEXER
 #define DOM_PARSER_DOM_LEXER
 
+#include <map>
 #include <string>
 #include <queue>
 #include <memory>
@@ -230,6 +231,119 @@ namespace dom_parser
 #endif
             return token_buffer.front().get();
         }
+
+        /**
+         *  @brief  Scans a tag, after its T_OPENTAG token has been read.
+         *  @param  tag_name    name of the tag, not set for closing tags
+         *  @param  attributes  attributes of the tag
+         *  @return 0   fail
+         *          1   success
+         *          -1  closing tag
+         *          -2  self closing tag
+         * */
+        int scan_tag(std::string &tag_name,
+                     std::map<std::string, std::string> &attributes)
+        {
+            auto _T = next();
+            // everytime we use lexer::next() we will check for file-end token
+            // if we get abrupt file end, error value will be returned
+
+            switch (_T->token)
+            {
+            case lexer_token_values::T_FILEEND: // found file end
+                return 0;
+
+            case lexer_token_values::T_BKSLASH: // closing tag
+                _T = next();
+                if (_T->token != lexer_token_values::T_IDNTIFR)
+                    return 0;
+                _T = next();
+                if (_T->token != lexer_token_values::T_CLOSTAG)
+                    return 0;
+                return -1;
+
+            case lexer_token_values::T_IDNTIFR: // found identifier
+
+                tag_name = std::move(_T->value); // set tagname
+
+                _T = next();
+                if (_T->token == lexer_token_values::T_FILEEND)
+                    return 0;
+
+                // scan attributes till closing tag
+                while (_T->token != lexer_token_values::T_CLOSTAG &&
+                       _T->token != lexer_token_values::T_BKSLASH)
+                {
+                    // error: not identifier
+                    if (_T->token != lexer_token_values::T_IDNTIFR)
+                        return 0;
+
+                    std::string attribute, value;
+                    // get attribute name
+                    attribute = _T->value;
+
+                    // check next token for equal sign
+                    _T = next();
+                    // either token should be equal sign or an identifier or > or /
+                    // > for tag closing, and / for /> type tag closing
+                    // otherwise error
+                    if (_T->token == lexer_token_values::T_IDNTIFR ||
+                        _T->token == lexer_token_values::T_BKSLASH ||
+                        _T->token == lexer_token_values::T_CLOSTAG) // no value attribute
+                    {
+                        attributes[attribute] = "";
+                        continue;
+                    }
+                    else if (_T->token != lexer_token_values::T_EQLSIGN) // error
+                        return 0;
+
+                    // scan attribute value
+                    // next token is either double/single quote or an identifier
+                    _T = next();
+                    if (_T->token == lexer_token_values::T_IDNTIFR) // identifier
+                    {
+                        attributes[attribute] = _T->value;
+                    }
+                    else if (_T->token == lexer_token_values::T_DBLQUOT ||
+                             _T->token == lexer_token_values::T_SINQUOT) // quote
+                    {
+                        auto T_QUOTE = _T->token;
+                        _T = next();
+                        // scan till we encounter that quote or file-end
+                        while (_T->token != T_QUOTE)
+                        {
+                            if (_T->token == lexer_token_values::T_FILEEND)
+                                return 0;
+                            value += _T->value + " ";
+
+                            _T = next();
+                        }
+                        value.erase(value.length() - 1, 1); // trim the last space
+                        attributes[attribute] = value;
+                    }
+                    else
+                        return 0;
+
+                    _T = next(); // next token
+                }
+
+                // check if element opening tag or self closing tag
+                if (_T->token == lexer_token_values::T_BKSLASH)
+                {
+                    _T = next();
+                    if (_T->token == lexer_token_values::T_CLOSTAG)
+                        return -2; // self closing
+                    else
+                        return 0; // error
+                }
+                else if (_T->token == lexer_token_values::T_CLOSTAG)
+                    return 1; // success
+                else
+                    return 0; // error
+            }
+
+            return 0;
+        }
     };
 }; // namespace dom_parser
 
@@ -0,0 +1,306 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_ARENA
+#define DOM_PARSER_DOM_ARENA
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "DOMsymbols.hpp"
+
+namespace dom_parser
+{
+    class DOMnode;
+
+    /**
+     *  @brief  Notified of the changes of the attributes and inner-data of
+     *          the nodes of a tree, see DOMarena::addObserver().
+     * */
+    class DOMattributeObserver
+    {
+    public:
+        /**
+         *  @brief  Called when an attribute of the node is set or removed.
+         *  @param  previous    value before the change, empty if none
+         *  @param  value       value as stored in the arena, empty if the
+         *                      attribute was removed
+         * */
+        virtual void attributeChanged(DOMnode &node, DOMsymbol name, std::string_view previous,
+                                      std::string_view value) = 0;
+
+        /**
+         *  @brief  Called when the inner-data of the node is replaced, maybe
+         *          by several threads at once for different nodes.
+         *  @param  previous    inner-data before the change
+         *  @param  data        inner-data as stored in the arena
+         * */
+        virtual void innerDataChanged(DOMnode & /*node*/, std::string_view /*previous*/, std::string_view /*data*/) {}
+
+    protected:
+        ~DOMattributeObserver() = default;
+    };
+
+    /**
+     *  @brief  Observers of the nodes of a tree, notified in the order they
+     *          were added. Shared by the arenas holding nodes of the tree.
+     * */
+    class DOMobserverList : public DOMattributeObserver
+    {
+    private:
+        std::vector<DOMattributeObserver *> observers;
+
+    public:
+        inline void add(DOMattributeObserver *observer)
+        {
+            observers.push_back(observer);
+        }
+
+        inline void remove(DOMattributeObserver *observer)
+        {
+            observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+        }
+
+        inline bool empty() const
+        {
+            return observers.empty();
+        }
+
+        void attributeChanged(DOMnode &node, DOMsymbol name, std::string_view previous,
+                              std::string_view value) override
+        {
+            for (DOMattributeObserver *observer : observers)
+                observer->attributeChanged(node, name, previous, value);
+        }
+
+        void innerDataChanged(DOMnode &node, std::string_view previous, std::string_view data) override
+        {
+            for (DOMattributeObserver *observer : observers)
+                observer->innerDataChanged(node, previous, data);
+        }
+    };
+
+    /**
+     *  @brief  Memory source of a DOMtree. Nodes, attributes and inner-data
+     *          of a tree are all allocated from the arena of the tree.
+     *
+     *          By default the arena is a bump allocator owned by the tree
+     *          (std::pmr::monotonic_buffer_resource), memory is taken in large
+     *          blocks and the whole tree is freed in one go without running
+     *          destructors of the individual nodes. A user supplied
+     *          std::pmr::memory_resource can be plugged in instead, in which
+     *          case objects are destroyed one by one when the arena dies.
+     *
+     *          The arena also carries the symbol table in which the names
+     *          used by the tree are interned, and the observer notified of
+     *          the changes of the attributes of its nodes.
+     * */
+    class DOMarena
+    {
+    private:
+        typedef void (*destructor_t)(void *, std::pmr::memory_resource *);
+
+        std::pmr::monotonic_buffer_resource monotonic;
+        std::pmr::memory_resource *resource;
+        bool trivialTeardown;
+
+        // objects which need destruction, used only with user supplied resource
+        std::vector<std::pair<void *, destructor_t>> objects;
+        std::vector<std::pair<char *, std::size_t>> strings;
+
+        std::shared_ptr<DOMsymbolTable> symbols;
+
+        // shared by the arenas holding nodes of the same tree
+        std::shared_ptr<DOMobserverList> observer;
+
+        // arenas whose strings are referred to by objects of this arena
+        std::vector<std::shared_ptr<DOMarena>> shared;
+
+        template <class T>
+        static void destroy(void *object, std::pmr::memory_resource *resource)
+        {
+            static_cast<T *>(object)->~T();
+            resource->deallocate(object, sizeof(T), alignof(T));
+        }
+
+    public:
+        /// @brief   Size of the first block requested by the default arena.
+        static constexpr std::size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+
+        /**
+         *  @brief  Constructor
+         *  @param  upstream    memory resource to allocate from, nullptr for
+         *                      the default per-tree bump arena.
+         *  @param  symbols     symbol table to intern names in, nullptr for a
+         *                      table of its own.
+         * */
+        explicit DOMarena(std::pmr::memory_resource *upstream = nullptr,
+                          std::shared_ptr<DOMsymbolTable> symbols = nullptr)
+            : monotonic(INITIAL_BLOCK_SIZE),
+              resource(upstream ? upstream : &monotonic),
+              trivialTeardown(upstream == nullptr),
+              symbols(symbols ? std::move(symbols) : std::make_shared<DOMsymbolTable>()),
+              observer(std::make_shared<DOMobserverList>()) {}
+
+        DOMarena(const DOMarena &) = delete;
+        DOMarena &operator=(const DOMarena &) = delete;
+
+        ~DOMarena()
+        {
+            for (auto it = objects.rbegin(); it != objects.rend(); ++it)
+                it->second(it->first, resource);
+            for (const auto &string : strings)
+                resource->deallocate(string.first, string.second, 1);
+            // the monotonic resource releases all of its blocks on its own
+        }
+
+        /**
+         *  @brief  Returns the memory resource backing the arena.
+         * */
+        inline std::pmr::memory_resource *getResource() const
+        {
+            return resource;
+        }
+
+        /**
+         *  @brief  Checks if the arena frees everything in bulk, that is,
+         *          destructors of objects created in it are never run.
+         * */
+        inline bool hasTrivialTeardown() const
+        {
+            return trivialTeardown;
+        }
+
+        /**
+         *  @brief  Returns the symbol table of the arena.
+         * */
+        inline DOMsymbolTable &getSymbols() const
+        {
+            return *symbols;
+        }
+
+        /**
+         *  @brief  Returns the shared pointer to the symbol table, so that it
+         *          can be handed to other trees.
+         * */
+        inline const std::shared_ptr<DOMsymbolTable> &shareSymbols() const
+        {
+            return symbols;
+        }
+
+        /**
+         *  @brief  Returns the observers of the nodes of the arena, nullptr
+         *          if there are none.
+         * */
+        inline DOMattributeObserver *getObserver() const
+        {
+            return (observer->empty() ? nullptr : observer.get());
+        }
+
+        /**
+         *  @brief  Adds an observer of the nodes of the arena and of the
+         *          arenas sharing its observers.
+         * */
+        inline void addObserver(DOMattributeObserver *attributeObserver)
+        {
+            observer->add(attributeObserver);
+        }
+
+        /**
+         *  @brief  Removes an observer added by addObserver().
+         * */
+        inline void removeObserver(DOMattributeObserver *attributeObserver)
+        {
+            observer->remove(attributeObserver);
+        }
+
+        /**
+         *  @brief  Makes the arena use the observer of other arena, for
+         *          arenas holding nodes of the same tree.
+         * */
+        inline void shareObserver(const DOMarena &other)
+        {
+            observer = other.observer;
+        }
+
+        /**
+         *  @brief  Returns the observers, shared with the arenas which share
+         *          them.
+         * */
+        inline const std::shared_ptr<DOMobserverList> &shareObserverSlot() const
+        {
+            return observer;
+        }
+
+        /**
+         *  @brief  Keeps another arena alive as long as this one, so that
+         *          strings stored there can be referred to from this arena.
+         * */
+        inline void share(std::shared_ptr<DOMarena> other)
+        {
+            if (other.get() != this)
+                shared.push_back(std::move(other));
+        }
+
+        /**
+         *  @brief  Returns the resource supplied by the user, nullptr if the
+         *          arena is the default bump arena.
+         * */
+        inline std::pmr::memory_resource *getUserResource() const
+        {
+            return (trivialTeardown ? nullptr : resource);
+        }
+
+        /**
+         *  @brief  Copies the string into the arena. The returned view stays
+         *          valid as long as the arena.
+         *  @param  string  the string to be copied
+         * */
+        std::string_view storeString(std::string_view string)
+        {
+            if (string.empty())
+                return std::string_view();
+            char *chars = static_cast<char *>(resource->allocate(string.size(), 1));
+            std::memcpy(chars, string.data(), string.size());
+            if (!trivialTeardown)
+                strings.emplace_back(chars, string.size());
+            return std::string_view(chars, string.size());
+        }
+
+        /**
+         *  @brief  Constructs an object of type T in the arena. The object
+         *          lives as long as the arena itself.
+         *  @param  args    arguments forwarded to the constructor of T
+         * */
+        template <class T, class... Args>
+        T *create(Args &&...args)
+        {
+            void *memory = resource->allocate(sizeof(T), alignof(T));
+            T *object = new (memory) T(std::forward<Args>(args)...);
+            if (!trivialTeardown)
+                objects.emplace_back(object, &destroy<T>);
+            return object;
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
@@ -0,0 +1,315 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_ATTRIBUTES
+#define DOM_PARSER_DOM_ATTRIBUTES
+
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "DOMarena.hpp"
+#include "DOMsymbols.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Attribute storage of a node. Attributes are kept as pairs of
+     *          interned name and a view of the value stored in the arena of
+     *          the tree, in the order they were added.
+     *
+     *          Up to INLINE_CAPACITY attributes are stored inline in the node
+     *          and looked up by a linear scan over the contiguous key ids.
+     *          Elements with more attributes spill to arena allocated arrays
+     *          indexed by a hash table.
+     * */
+    class DOMattributes
+    {
+    public:
+        /// @brief   Number of attributes stored without any allocation.
+        static constexpr std::uint32_t INLINE_CAPACITY = 3;
+
+    private:
+        struct spill_t
+        {
+            std::pmr::vector<DOMsymbol> keys;
+            std::pmr::vector<std::string_view> values;
+            std::pmr::unordered_map<DOMsymbol, std::uint32_t> index;
+
+            explicit spill_t(std::pmr::memory_resource *resource)
+                : keys(resource), values(resource), index(resource) {}
+        };
+
+        DOMsymbol keys[INLINE_CAPACITY];
+        std::uint32_t count = 0;
+        std::string_view values[INLINE_CAPACITY];
+        spill_t *spill = nullptr;
+
+        /**
+         *  @brief  Returns position of the key, count if not present.
+         * */
+        inline std::uint32_t position(DOMsymbol key) const
+        {
+            if (spill)
+            {
+                auto i = spill->index.find(key);
+                return (i != spill->index.end() ? i->second : count);
+            }
+            for (std::uint32_t i = 0; i < count; ++i)
+                if (keys[i] == key)
+                    return i;
+            return count;
+        }
+
+    public:
+        /**
+         *  @brief  Returns number of attributes.
+         * */
+        inline std::uint32_t size() const
+        {
+            return count;
+        }
+
+        /**
+         *  @brief  Checks if there are no attributes.
+         * */
+        inline bool empty() const
+        {
+            return count == 0;
+        }
+
+        /**
+         *  @brief  Returns the name id of the i-th attribute.
+         * */
+        inline DOMsymbol keyAt(std::uint32_t i) const
+        {
+            return (spill ? spill->keys[i] : keys[i]);
+        }
+
+        /**
+         *  @brief  Returns the value of the i-th attribute.
+         * */
+        inline std::string_view valueAt(std::uint32_t i) const
+        {
+            return (spill ? spill->values[i] : values[i]);
+        }
+
+        /**
+         *  @brief  Returns pointer to the value of the attribute, nullptr
+         *          if the attribute does not exist.
+         *  @param  key     name id of the attribute
+         * */
+        inline const std::string_view *find(DOMsymbol key) const
+        {
+            std::uint32_t i = position(key);
+            if (i == count)
+                return nullptr;
+            return (spill ? &spill->values[i] : &values[i]);
+        }
+
+        /**
+         *  @brief  Sets value of an existing attribute or appends a new one.
+         *  @param  key     name id of the attribute
+         *  @param  value   value, must already be stored in the arena
+         *  @param  arena   arena used if the storage has to spill
+         * */
+        void set(DOMsymbol key, std::string_view value, DOMarena &arena)
+        {
+            std::uint32_t i = position(key);
+            if (i != count)
+            {
+                (spill ? spill->values[i] : values[i]) = value;
+                return;
+            }
+
+            if (!spill && count < INLINE_CAPACITY)
+            {
+                keys[count] = key;
+                values[count] = value;
+                ++count;
+                return;
+            }
+
+            if (!spill) // move inline attributes out to the spill storage
+            {
+                spill = arena.create<spill_t>(arena.getResource());
+                for (std::uint32_t j = 0; j < count; ++j)
+                {
+                    spill->keys.push_back(keys[j]);
+                    spill->values.push_back(values[j]);
+                    spill->index.emplace(keys[j], j);
+                }
+            }
+            spill->keys.push_back(key);
+            spill->values.push_back(value);
+            spill->index.emplace(key, count);
+            ++count;
+        }
+
+        /**
+         *  @brief  Removes the attribute if it exists, order of the rest
+         *          of the attributes is preserved.
+         *  @param  key     name id of the attribute
+         *  @return true if attribute was removed
+         * */
+        bool remove(DOMsymbol key)
+        {
+            std::uint32_t i = position(key);
+            if (i == count)
+                return false;
+
+            --count;
+            if (spill)
+            {
+                spill->keys.erase(spill->keys.begin() + i);
+                spill->values.erase(spill->values.begin() + i);
+                spill->index.erase(key);
+                for (std::uint32_t j = i; j < count; ++j)
+                    spill->index[spill->keys[j]] = j;
+                return true;
+            }
+            for (std::uint32_t j = i; j < count; ++j)
+            {
+                keys[j] = keys[j + 1];
+                values[j] = values[j + 1];
+            }
+            return true;
+        }
+
+        /**
+         *  @brief  Replaces the attributes with the ones of other storage.
+         *          The values are not copied, both storages refer to the
+         *          same strings, which are never modified in place.
+         *  @param  other   storage to copy from
+         *  @param  arena   arena used if the storage has to spill
+         * */
+        void copyFrom(const DOMattributes &other, DOMarena &arena)
+        {
+            clear();
+            for (std::uint32_t i = 0; i < other.size(); ++i)
+                set(other.keyAt(i), other.valueAt(i), arena);
+        }
+
+        /**
+         *  @brief  Removes all the attributes.
+         * */
+        inline void clear()
+        {
+            if (spill)
+            {
+                spill->keys.clear();
+                spill->values.clear();
+                spill->index.clear();
+            }
+            count = 0;
+        }
+    };
+
+    /**
+     *  @brief  Iterable view over attributes of a node which yields pairs of
+     *          {name, value}, in the order the attributes were added.
+     * */
+    class DOMattributeRange
+    {
+    private:
+        const DOMattributes *attributes;
+        const DOMsymbolTable *symbols;
+
+    public:
+        class iterator
+        {
+        private:
+            const DOMattributes *attributes;
+            const DOMsymbolTable *symbols;
+            std::uint32_t i;
+
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef std::pair<std::string_view, std::string_view> value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const value_type *pointer;
+            typedef value_type reference;
+
+            iterator(const DOMattributes *attributes, const DOMsymbolTable *symbols, std::uint32_t i)
+                : attributes(attributes), symbols(symbols), i(i) {}
+
+            inline value_type operator*() const
+            {
+                return value_type(symbols->name(attributes->keyAt(i)), attributes->valueAt(i));
+            }
+            inline iterator &operator++()
+            {
+                ++i;
+                return *this;
+            }
+            inline iterator operator++(int)
+            {
+                iterator old = *this;
+                ++i;
+                return old;
+            }
+            inline bool operator==(const iterator &other) const
+            {
+                return i == other.i;
+            }
+            inline bool operator!=(const iterator &other) const
+            {
+                return i != other.i;
+            }
+        };
+
+        DOMattributeRange(const DOMattributes &attributes, const DOMsymbolTable &symbols)
+            : attributes(&attributes), symbols(&symbols) {}
+
+        inline iterator begin() const
+        {
+            return iterator(attributes, symbols, 0);
+        }
+        inline iterator end() const
+        {
+            return iterator(attributes, symbols, attributes->size());
+        }
+        inline std::uint32_t size() const
+        {
+            return attributes->size();
+        }
+        inline bool empty() const
+        {
+            return attributes->empty();
+        }
+
+        /**
+         *  @brief  Returns the interned name of the i-th attribute.
+         * */
+        inline DOMsymbol symbolAt(std::uint32_t i) const
+        {
+            return attributes->keyAt(i);
+        }
+
+        /**
+         *  @brief  Returns the value of the i-th attribute.
+         * */
+        inline std::string_view valueAt(std::uint32_t i) const
+        {
+            return attributes->valueAt(i);
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
@@ -0,0 +1,822 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_COLUMNS
+#define DOM_PARSER_DOM_COLUMNS
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "DOMthreads.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Types of the values of a column.
+     * */
+    enum class DOMcolumnType
+    {
+        INT64,
+        DOUBLE,
+        STRING // dictionary encoded
+    };
+
+    /**
+     *  @brief  Values of one field of the records, one per record, stored
+     *          contiguously by type: integers, reals, or codes of the strings
+     *          of the dictionary of the column. Rows whose field is missing,
+     *          or not a number for a numeric column, are null.
+     * */
+    class DOMcolumn
+    {
+        friend class DOMcolumnReader;
+
+    private:
+        std::string path;
+        DOMcolumnType type;
+
+        std::vector<std::int64_t> integers;
+        std::vector<double> reals;
+        std::vector<std::uint32_t> codes;
+        std::vector<std::string> dictionary; // in order of first occurrence
+        std::vector<std::uint8_t> present;
+
+    public:
+        DOMcolumn(std::string path, DOMcolumnType type) : path(std::move(path)), type(type) {}
+
+        /**
+         *  @brief  Returns the path of the field, relative to the record.
+         * */
+        inline const std::string &getPath() const
+        {
+            return path;
+        }
+
+        inline DOMcolumnType getType() const
+        {
+            return type;
+        }
+
+        /**
+         *  @brief  Returns the number of rows.
+         * */
+        inline std::size_t size() const
+        {
+            return present.size();
+        }
+
+        /**
+         *  @brief  Checks if the field of the row was missing or, for a
+         *          numeric column, not a number.
+         * */
+        inline bool isNull(std::size_t row) const
+        {
+            return !present[row];
+        }
+
+        /**
+         *  @brief  Returns the values of an INT64 column, 0 for null rows.
+         * */
+        inline const std::vector<std::int64_t> &getIntegers() const
+        {
+            return integers;
+        }
+
+        /**
+         *  @brief  Returns the values of a DOUBLE column, 0 for null rows.
+         * */
+        inline const std::vector<double> &getReals() const
+        {
+            return reals;
+        }
+
+        /**
+         *  @brief  Returns the dictionary codes of a STRING column, 0 for
+         *          null rows.
+         * */
+        inline const std::vector<std::uint32_t> &getCodes() const
+        {
+            return codes;
+        }
+
+        /**
+         *  @brief  Returns the distinct strings of a STRING column.
+         * */
+        inline const std::vector<std::string> &getDictionary() const
+        {
+            return dictionary;
+        }
+
+        inline std::int64_t getInt64(std::size_t row) const
+        {
+            return integers[row];
+        }
+
+        inline double getDouble(std::size_t row) const
+        {
+            return reals[row];
+        }
+
+        /**
+         *  @brief  Returns the string of the row, empty for null rows.
+         * */
+        inline std::string_view getString(std::size_t row) const
+        {
+            return (present[row] ? std::string_view(dictionary[codes[row]]) : std::string_view());
+        }
+    };
+
+    /**
+     *  @brief  Columns extracted from the records of a document.
+     * */
+    class DOMcolumnTable
+    {
+        friend class DOMcolumnReader;
+
+    private:
+        std::size_t rows = 0;
+        std::vector<DOMcolumn> columns;
+
+    public:
+        inline std::size_t getRowCount() const
+        {
+            return rows;
+        }
+
+        inline std::size_t getColumnCount() const
+        {
+            return columns.size();
+        }
+
+        /**
+         *  @brief  Returns the column, in the order the columns were added
+         *          to the reader.
+         * */
+        inline const DOMcolumn &getColumn(std::size_t i) const
+        {
+            return columns[i];
+        }
+
+        /**
+         *  @brief  Returns the column of the field path, nullptr if none.
+         * */
+        const DOMcolumn *findColumn(std::string_view path) const
+        {
+            for (const DOMcolumn &column : columns)
+                if (column.getPath() == path)
+                    return &column;
+            return nullptr;
+        }
+    };
+
+    /**
+     *  @brief  Reads records of a document straight into typed columns,
+     *          without building a tree. The records are the elements at the
+     *          record path from the root, such as "table/T"; each column
+     *          takes a field of the records, the text of an element at a path
+     *          relative to the record ("P_NAME", "a/b"), or an attribute of
+     *          the record or of such an element ("@id", "a/@id").
+     *
+     *          Text is taken as DOMparser takes inner-data: runs of whitespace
+     *          collapse to single spaces and entities are kept as they are.
+     *          The first occurrence of a field in a record is kept.
+     *
+     *          Big documents are cut in chunks at the start tags of records,
+     *          read by several threads into columns of their own which are
+     *          concatenated in document order at the end, the dictionaries
+     *          merged. The cuts look for the name of the record element, so
+     *          that name must not be used by other elements; if a chunk turns
+     *          out malformed the document is read again by one thread.
+     * */
+    class DOMcolumnReader
+    {
+    private:
+        struct field_t
+        {
+            DOMcolumnType type;
+            std::string attribute; // empty for the text of the element
+        };
+
+        // element at a path relative to the record, the record being step 0
+        struct step_t
+        {
+            std::string name;
+            std::vector<std::uint32_t> children;
+            std::vector<std::uint32_t> texts;      // fields taking its text
+            std::vector<std::uint32_t> attributes; // fields taking an attribute
+        };
+
+        // values of one column read by one thread
+        struct part_column_t
+        {
+            std::vector<std::int64_t> integers;
+            std::vector<double> reals;
+            std::vector<std::uint32_t> codes;
+            std::vector<std::uint8_t> present;
+            std::unordered_map<std::string_view, std::uint32_t> dictionary;
+            std::vector<std::string_view> words;
+        };
+
+        // columns read by one thread from a chunk
+        struct part_t
+        {
+            std::size_t rows = 0;
+            std::vector<part_column_t> columns;
+            std::deque<std::string> collapsed; // strings which are not views of the document
+        };
+
+        // text of a field being read
+        struct capture_t
+        {
+            std::uint32_t field;
+            std::size_t depth;
+            std::string_view value;
+            bool joined; // value is in the scratch string of the field
+        };
+
+        // minimum number of bytes read by one thread
+        static constexpr std::size_t CHUNK_GRAIN = 1 << 18;
+
+        std::vector<std::string> recordPath;
+        std::vector<field_t> fields;
+        std::vector<step_t> steps;
+        std::vector<std::string> paths;
+
+        static inline bool isSpace(char c)
+        {
+            return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+        }
+
+        static std::vector<std::string> split(std::string_view path)
+        {
+            std::vector<std::string> parts;
+            std::size_t begin = 0;
+            while (begin <= path.size())
+            {
+                std::size_t end = std::min(path.find('/', begin), path.size());
+                parts.emplace_back(path.substr(begin, end - begin));
+                begin = end + 1;
+            }
+            return parts;
+        }
+
+        static inline std::string_view trim(std::string_view text)
+        {
+            while (!text.empty() && isSpace(text.front()))
+                text.remove_prefix(1);
+            while (!text.empty() && isSpace(text.back()))
+                text.remove_suffix(1);
+            return text;
+        }
+
+        /**
+         *  @brief  Checks if the trimmed text has whitespace other than
+         *          single spaces.
+         * */
+        static inline bool needsCollapse(std::string_view text)
+        {
+            for (std::size_t i = 0; i < text.size(); ++i)
+                if (isSpace(text[i]) && (text[i] != ' ' || text[i + 1] == ' '))
+                    return true;
+            return false;
+        }
+
+        /**
+         *  @brief  Appends the trimmed text with its whitespace collapsed.
+         * */
+        static void appendCollapsed(std::string &out, std::string_view text)
+        {
+            bool space = false;
+            for (char c : text)
+            {
+                if (isSpace(c))
+                    space = true;
+                else
+                {
+                    if (space)
+                        out += ' ';
+                    out += c;
+                    space = false;
+                }
+            }
+        }
+
+        /**
+         *  @brief  Stores the value of the field in the last row of the part.
+         *  @param  stable  value stays valid as long as the document
+         * */
+        void store(part_t &part, std::uint32_t field, std::string_view value, bool stable) const
+        {
+            part_column_t &column = part.columns[field];
+            std::size_t row = part.rows - 1;
+            switch (fields[field].type)
+            {
+            case DOMcolumnType::INT64:
+            case DOMcolumnType::DOUBLE:
+            {
+                if (!value.empty() && value.front() == '+')
+                    value.remove_prefix(1);
+                const char *end = value.data() + value.size();
+                std::int64_t integer = 0;
+                double real = 0;
+                std::from_chars_result result;
+                if (fields[field].type == DOMcolumnType::INT64)
+                    result = std::from_chars(value.data(), end, integer);
+                else
+                    result = std::from_chars(value.data(), end, real);
+                bool number = (!value.empty() && result.ec == std::errc() && result.ptr == end);
+                if (fields[field].type == DOMcolumnType::INT64)
+                    column.integers[row] = (number ? integer : 0);
+                else
+                    column.reals[row] = (number ? real : 0);
+                column.present[row] = number;
+                break;
+            }
+            case DOMcolumnType::STRING:
+            {
+                auto i = column.dictionary.find(value);
+                if (i == column.dictionary.end())
+                {
+                    if (!stable)
+                        value = part.collapsed.emplace_back(value);
+                    i = column.dictionary.emplace(value, std::uint32_t(column.words.size())).first;
+                    column.words.push_back(value);
+                }
+                column.codes[row] = i->second;
+                column.present[row] = 1;
+                break;
+            }
+            }
+        }
+
+        /**
+         *  @brief  Appends a null row to the columns of the part.
+         * */
+        void addRow(part_t &part) const
+        {
+            for (std::uint32_t f = 0; f < fields.size(); ++f)
+            {
+                part_column_t &column = part.columns[f];
+                if (fields[f].type == DOMcolumnType::INT64)
+                    column.integers.push_back(0);
+                else if (fields[f].type == DOMcolumnType::DOUBLE)
+                    column.reals.push_back(0);
+                else
+                    column.codes.push_back(0);
+                column.present.push_back(0);
+            }
+            ++part.rows;
+        }
+
+        /**
+         *  @brief  Reads the records whose start tag begins in [from, to).
+         *  @param  first   from is the start of the document, otherwise it is
+         *                  the start tag of a record
+         *  @return false if the chunk is malformed
+         * */
+        bool scan(std::string_view data, std::size_t from, std::size_t to, bool first, part_t &part) const
+        {
+            part.columns.assign(fields.size(), part_column_t());
+            const char *text = data.data();
+            const std::size_t size = data.size(), depth = recordPath.size();
+
+            std::vector<std::string_view> open;
+            std::vector<std::int32_t> opened; // step of each open element, -1 if none
+            std::size_t matched = 0;          // open elements along the record path
+            if (!first)
+                for (; matched + 1 < depth; ++matched)
+                {
+                    open.push_back(recordPath[matched]);
+                    opened.push_back(-1);
+                }
+
+            std::vector<capture_t> captures;
+            std::vector<std::string> scratch(fields.size());
+            std::vector<std::uint8_t> done(fields.size());
+            std::vector<std::pair<std::string_view, std::string_view>> attributes;
+
+            auto addText = [&](std::string_view segment)
+            {
+                segment = trim(segment);
+                if (segment.empty())
+                    return;
+                bool collapse = needsCollapse(segment);
+                for (capture_t &capture : captures)
+                {
+                    std::string &joined = scratch[capture.field];
+                    if (!capture.joined && capture.value.empty() && !collapse)
+                    {
+                        capture.value = segment;
+                        continue;
+                    }
+                    if (!capture.joined)
+                    {
+                        joined.assign(capture.value);
+                        capture.joined = true;
+                    }
+                    if (!joined.empty())
+                        joined += ' ';
+                    appendCollapsed(joined, segment);
+                }
+            };
+
+            auto push = [&](std::string_view name)
+            {
+                std::size_t d = open.size();
+                std::int32_t step = -1;
+                if (matched == d && d < depth && name == recordPath[d])
+                {
+                    if (++matched == depth)
+                    {
+                        addRow(part);
+                        std::fill(done.begin(), done.end(), 0);
+                        step = 0;
+                    }
+                }
+                else if (matched == depth && opened.back() >= 0)
+                    for (std::uint32_t child : steps[opened.back()].children)
+                        if (steps[child].name == name)
+                        {
+                            step = std::int32_t(child);
+                            break;
+                        }
+                open.push_back(name);
+                opened.push_back(step);
+                if (step < 0)
+                    return;
+                for (std::uint32_t field : steps[step].attributes)
+                    for (const auto &attribute : attributes)
+                        if (!done[field] && attribute.first == fields[field].attribute)
+                        {
+                            done[field] = 1;
+                            std::string_view value = trim(attribute.second);
+                            if (!needsCollapse(value))
+                                store(part, field, value, true);
+                            else
+                            {
+                                scratch[field].clear();
+                                appendCollapsed(scratch[field], value);
+                                store(part, field, scratch[field], false);
+                            }
+                        }
+                for (std::uint32_t field : steps[step].texts)
+                    if (!done[field])
+                    {
+                        done[field] = 1;
+                        captures.push_back({field, d, std::string_view(), false});
+                    }
+            };
+
+            auto pop = [&]()
+            {
+                std::size_t d = open.size() - 1;
+                while (!captures.empty() && captures.back().depth == d)
+                {
+                    capture_t &capture = captures.back();
+                    if (capture.joined)
+                        store(part, capture.field, scratch[capture.field], false);
+                    else
+                        store(part, capture.field, capture.value, true);
+                    captures.pop_back();
+                }
+                if (matched > d)
+                    matched = d;
+                open.pop_back();
+                opened.pop_back();
+            };
+
+            // position of the end of the markup, size if not found
+            auto skipPast = [&](std::size_t p, std::string_view end)
+            {
+                std::size_t found = data.find(end, p);
+                return (found == std::string_view::npos ? size : found + end.size());
+            };
+
+            std::size_t p = from;
+            while (true)
+            {
+                const char *lt = static_cast<const char *>(std::memchr(text + p, '<', size - p));
+                std::size_t tag = (lt ? std::size_t(lt - text) : size);
+                if (!captures.empty() && tag > p)
+                    addText(data.substr(p, tag - p));
+                if (tag == size)
+                    return (first ? open.empty() : matched < depth);
+                if (matched < depth && tag >= to) // the records of the chunk are read
+                    return true;
+
+                p = tag + 1;
+                if (p == size)
+                    return false;
+                if (text[p] == '?')
+                {
+                    p = skipPast(p, "?>");
+                    continue;
+                }
+                if (text[p] == '!')
+                {
+                    if (data.compare(p, 3, "!--") == 0)
+                        p = skipPast(p, "-->");
+                    else if (data.compare(p, 8, "![CDATA[") == 0)
+                    {
+                        std::size_t end = skipPast(p, "]]>");
+                        if (!captures.empty() && end != size)
+                            addText(data.substr(p + 8, end - 3 - (p + 8)));
+                        p = end;
+                    }
+                    else
+                        p = skipPast(p, ">");
+                    continue;
+                }
+                if (text[p] == '/') // closing tag
+                {
+                    std::size_t end = data.find('>', p);
+                    if (end == std::string_view::npos)
+                        return false;
+                    std::string_view name = trim(data.substr(p + 1, end - p - 1));
+                    p = end + 1;
+                    if (open.empty())
+                        return !first; // past the parent of the records
+                    if (name != open.back())
+                        return false;
+                    pop();
+                    continue;
+                }
+
+                std::size_t begin = p;
+                while (p < size && !isSpace(text[p]) && text[p] != '>' && text[p] != '/')
+                    ++p;
+                std::string_view name = data.substr(begin, p - begin);
+                if (name.empty())
+                    return false;
+                attributes.clear();
+                bool closed = false;
+                while (true)
+                {
+                    while (p < size && isSpace(text[p]))
+                        ++p;
+                    if (p == size)
+                        return false;
+                    if (text[p] == '>')
+                    {
+                        ++p;
+                        break;
+                    }
+                    if (text[p] == '/')
+                    {
+                        if (p + 1 < size && text[p + 1] == '>')
+                        {
+                            p += 2;
+                            closed = true;
+                            break;
+                        }
+                        ++p;
+                        continue;
+                    }
+                    begin = p;
+                    while (p < size && !isSpace(text[p]) && text[p] != '=' && text[p] != '>' && text[p] != '/')
+                        ++p;
+                    std::string_view attribute = data.substr(begin, p - begin), value;
+                    while (p < size && isSpace(text[p]))
+                        ++p;
+                    if (p < size && text[p] == '=')
+                    {
+                        ++p;
+                        while (p < size && isSpace(text[p]))
+                            ++p;
+                        if (p < size && (text[p] == '"' || text[p] == '\''))
+                        {
+                            std::size_t end = data.find(text[p], p + 1);
+                            if (end == std::string_view::npos)
+                                return false;
+                            value = data.substr(p + 1, end - p - 1);
+                            p = end + 1;
+                        }
+                        else
+                        {
+                            begin = p;
+                            while (p < size && !isSpace(text[p]) && text[p] != '>')
+                                ++p;
+                            value = data.substr(begin, p - begin);
+                        }
+                    }
+                    attributes.emplace_back(attribute, value);
+                }
+                push(name);
+                if (closed)
+                    pop();
+            }
+        }
+
+        /**
+         *  @brief  Concatenates the columns of the parts into the table, each
+         *          part copied by a thread of its own.
+         * */
+        void merge(std::vector<part_t> &parts, DOMcolumnTable &table) const
+        {
+            std::vector<std::size_t> offsets(parts.size() + 1, 0);
+            for (std::size_t r = 0; r < parts.size(); ++r)
+                offsets[r + 1] = offsets[r] + parts[r].rows;
+            table.rows = offsets.back();
+            table.columns.clear();
+
+            // codes of the strings of each part in the merged dictionaries
+            std::vector<std::vector<std::vector<std::uint32_t>>> remap(fields.size());
+            for (std::uint32_t f = 0; f < fields.size(); ++f)
+            {
+                DOMcolumn &column = table.columns.emplace_back(paths[f], fields[f].type);
+                column.present.resize(table.rows);
+                if (fields[f].type == DOMcolumnType::INT64)
+                    column.integers.resize(table.rows);
+                else if (fields[f].type == DOMcolumnType::DOUBLE)
+                    column.reals.resize(table.rows);
+                else
+                {
+                    column.codes.resize(table.rows);
+                    remap[f].resize(parts.size());
+                    std::unordered_map<std::string_view, std::uint32_t> merged; // views of the parts
+                    for (std::size_t r = 0; r < parts.size(); ++r)
+                        for (std::string_view word : parts[r].columns[f].words)
+                        {
+                            auto i = merged.emplace(word, std::uint32_t(merged.size())).first;
+                            if (i->second == column.dictionary.size())
+                                column.dictionary.emplace_back(word);
+                            remap[f][r].push_back(i->second);
+                        }
+                }
+            }
+
+            auto copy = [&](std::size_t r)
+            {
+                for (std::uint32_t f = 0; f < fields.size(); ++f)
+                {
+                    part_column_t &from = parts[r].columns[f];
+                    DOMcolumn &to = table.columns[f];
+                    std::copy(from.present.begin(), from.present.end(), to.present.begin() + offsets[r]);
+                    if (fields[f].type == DOMcolumnType::INT64)
+                        std::copy(from.integers.begin(), from.integers.end(), to.integers.begin() + offsets[r]);
+                    else if (fields[f].type == DOMcolumnType::DOUBLE)
+                        std::copy(from.reals.begin(), from.reals.end(), to.reals.begin() + offsets[r]);
+                    else
+                        for (std::size_t i = 0; i < from.codes.size(); ++i)
+                            to.codes[offsets[r] + i] = (from.present[i] ? remap[f][r][from.codes[i]] : 0);
+                }
+            };
+            parallelRun(parts.size(), copy);
+        }
+
+    public:
+        /**
+         *  @brief  Constructor.
+         *  @param  recordPath  names of the elements from the root of the
+         *                      document to the records, separated by '/'
+         * */
+        explicit DOMcolumnReader(std::string_view recordPath)
+        {
+            if (!recordPath.empty() && recordPath.front() == '/')
+                recordPath.remove_prefix(1);
+            this->recordPath = split(recordPath);
+            steps.push_back({this->recordPath.back(), {}, {}, {}});
+        }
+
+        /**
+         *  @brief  Adds a column taking a field of the records.
+         *  @param  path    path of the field relative to the record, element
+         *                  names separated by '/', optionally ending with an
+         *                  attribute name after '@'
+         *  @param  type    type of the values
+         *  @return index of the column in the tables, -1 if the path is
+         *          malformed
+         * */
+        int addColumn(std::string_view path, DOMcolumnType type)
+        {
+            std::vector<std::string> names = split(path);
+            std::string attribute;
+            if (!names.back().empty() && names.back().front() == '@')
+            {
+                attribute = names.back().substr(1);
+                names.pop_back();
+                if (attribute.empty())
+                    return -1;
+            }
+            for (const std::string &name : names)
+                if (name.empty() || name.find('@') != std::string::npos)
+                    return -1;
+
+            std::uint32_t step = 0;
+            for (const std::string &name : names)
+            {
+                std::uint32_t next = 0;
+                for (std::uint32_t child : steps[step].children)
+                    if (steps[child].name == name)
+                        next = child;
+                if (next == 0)
+                {
+                    next = std::uint32_t(steps.size());
+                    steps.push_back({name, {}, {}, {}});
+                    steps[step].children.push_back(next);
+                }
+                step = next;
+            }
+            std::uint32_t field = std::uint32_t(fields.size());
+            fields.push_back({type, attribute});
+            paths.emplace_back(path);
+            (attribute.empty() ? steps[step].texts : steps[step].attributes).push_back(field);
+            return int(field);
+        }
+
+        /**
+         *  @brief  Reads the records of the document into the table.
+         *  @param  data        the document
+         *  @param  table       table to fill, its columns are replaced
+         *  @param  threads     maximum number of threads to use
+         *  @return 0   success
+         *          -2  malformed document
+         * */
+        int parse(std::string_view data, DOMcolumnTable &table,
+                  unsigned threads = std::thread::hardware_concurrency())
+        {
+            std::size_t ranges = parallelRanges(threads, data.size(), CHUNK_GRAIN);
+
+            // chunks start at the start tag of a record
+            std::vector<std::size_t> starts{0};
+            std::string pattern = "<" + recordPath.back();
+            for (std::size_t r = 1; r < ranges; ++r)
+            {
+                std::size_t p = std::max(data.size() / ranges * r, starts.back() + 1);
+                while ((p = data.find(pattern, p)) != std::string_view::npos)
+                {
+                    std::size_t after = p + pattern.size();
+                    if (after < data.size() && (isSpace(data[after]) || data[after] == '>' || data[after] == '/'))
+                        break;
+                    p = after;
+                }
+                starts.push_back(p == std::string_view::npos ? data.size() : p);
+            }
+            starts.push_back(data.size());
+
+            std::vector<part_t> parts(ranges);
+            std::vector<std::uint8_t> valid(ranges);
+            parallelRun(ranges, [&](std::size_t r)
+                        { valid[r] = scan(data, starts[r], starts[r + 1], r == 0, parts[r]); });
+
+            if (!valid[0])
+                return -2;
+            if (std::find(valid.begin(), valid.end(), 0) != valid.end()) // a cut was not at a record
+            {
+                parts.assign(1, part_t());
+                if (!scan(data, 0, data.size(), true, parts[0]))
+                    return -2;
+            }
+            merge(parts, table);
+            return 0;
+        }
+
+        /**
+         *  @brief  Reads the records of the file into the table.
+         *  @param  path        path of the file
+         *  @param  table       table to fill, its columns are replaced
+         *  @param  threads     maximum number of threads to use
+         *  @return 0   success
+         *          -1  file cannot be read
+         *          -2  malformed document
+         * */
+        int load(std::filesystem::path path, DOMcolumnTable &table,
+                 unsigned threads = std::thread::hardware_concurrency())
+        {
+            std::ifstream fin(path, std::ios::binary);
+            if (!fin.is_open())
+                return -1;
+            std::string data;
+            fin.seekg(0, std::ios::end);
+            data.resize(std::size_t(fin.tellg()));
+            fin.seekg(0, std::ios::beg);
+            if (!fin.read(data.data(), std::streamsize(data.size())))
+                return -1;
+            return parse(data, table, threads);
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
@@ -0,0 +1,753 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_COMPRESSED
+#define DOM_PARSER_DOM_COMPRESSED
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "DOMarena.hpp"
+#include "DOMhash.hpp"
+#include "DOMsymbols.hpp"
+#include "DOMtree.hpp"
+
+namespace dom_parser
+{
+    class DOMcompressedNode;
+
+    /**
+     *  @brief  Read-only copy of a tree in which repeated structure is
+     *          stored once.
+     *
+     *          The structure of every subtree (tags, names of the attributes
+     *          and the structure of the children, but no text) is hash-consed
+     *          into a shape, so that all the records of a table share one
+     *          shape, and so do all the identical subtrees. The children of a
+     *          shape are stored as runs of consecutive children of the same
+     *          shape, a table of a million equal rows is one run.
+     *
+     *          The text (inner-data and values of the attributes) is kept
+     *          apart, as one column of value ids in document order; every
+     *          distinct value is stored once. A node costs nothing but the
+     *          ids of its text, equal subtrees differ only in where their ids
+     *          start.
+     *
+     *          Nodes are visited through DOMcompressedNode cursors, which
+     *          offer the accessors of DOMnode. UIDs of the nodes are their
+     *          positions in document order, the root being 0, that is the
+     *          slots (uidSlot()) of the UIDs DOMtree::compact() gives to the
+     *          nodes of the original tree.
+     *          Any number of threads may read the tree at once.
+     * */
+    class DOMcompressedTree
+    {
+        friend class DOMcompressedNode;
+        friend class DOMcompressedAttributeRange;
+
+    private:
+        static constexpr std::uint32_t NONE = 0xFFFFFFFF;
+
+        struct shape_t
+        {
+            DOMsymbol tag;                // NO_SYMBOL for inner-data nodes
+            std::uint32_t names;          // first name of the attributes in names
+            std::uint32_t attributeCount; //
+            std::uint32_t runs;           // first run of the children in runs
+            std::uint32_t runCount;       //
+            std::uint32_t childCount;     //
+            std::uint64_t size;           // nodes in the subtree
+            std::uint64_t slots;          // values in the subtree
+        };
+
+        // consecutive children of the same shape
+        struct run_t
+        {
+            std::uint32_t shape;
+            std::uint32_t first;  // index of the first child of the run
+            std::uint64_t offset; // from the UID of the parent to the first child
+            std::uint64_t slot;   // from the first slot of the parent to the first child
+        };
+
+        std::shared_ptr<DOMsymbolTable> symbols;
+        std::unique_ptr<DOMarena> storage; // of the distinct values
+
+        std::vector<shape_t> shapes;
+        std::vector<DOMsymbol> names;
+        std::vector<run_t> runs;
+        std::uint32_t rootShape = NONE;
+
+        // value ids in document order, the values of the attributes of a
+        // node in their order or its inner-data, then those of its children
+        std::vector<std::uint32_t> slots;
+        std::vector<std::string_view> values;
+        std::size_t valueBytes = 0;
+
+        /**
+         *  @brief  Returns the number of values of the node itself.
+         * */
+        static inline std::uint64_t ownSlots(const shape_t &shape)
+        {
+            return (shape.tag == DOMsymbolTable::NO_SYMBOL ? 1 : shape.attributeCount);
+        }
+
+        /**
+         *  @brief  Returns the number of children in the run.
+         * */
+        inline std::uint32_t runLength(const shape_t &shape, std::uint32_t run) const
+        {
+            return (run + 1 < shape.runs + shape.runCount ? runs[run + 1].first : shape.childCount) -
+                   runs[run].first;
+        }
+
+        /**
+         *  @brief  Builds the shapes, bottom-up, and the column of values,
+         *          in document order, in one walk over the subtree.
+         * */
+        void build(const DOMtree &tree, DOMnodeUID root)
+        {
+            std::unordered_map<std::string_view, std::uint32_t> valueIds;
+            std::unordered_map<std::uint64_t, std::uint32_t> buckets; // first shape of the hash
+            std::vector<std::uint32_t> chain;                          // next shape of the same hash
+
+            auto storeValue = [&](std::string_view value)
+            {
+                auto i = valueIds.find(value);
+                if (i != valueIds.end())
+                    return i->second;
+                std::string_view stored = storage->storeString(value);
+                std::uint32_t id = std::uint32_t(values.size());
+                values.push_back(stored);
+                valueBytes += stored.size();
+                valueIds.emplace(stored, id);
+                return id;
+            };
+
+            // runs of the children closed so far, of all the open nodes
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> pending; // shape, count
+            std::vector<DOMsymbol> attributes;
+
+            auto intern = [&](const DOMnode &node, std::size_t begin)
+            {
+                shape_t shape{node.getTagSymbol(), 0, 0, 0, std::uint32_t(pending.size() - begin), 0, 1, 0};
+                attributes.clear();
+                if (!node.isInnerDataNode())
+                {
+                    DOMattributeRange range = node.getAllAttributes();
+                    for (std::uint32_t i = 0; i < range.size(); ++i)
+                        attributes.push_back(range.symbolAt(i));
+                }
+                shape.attributeCount = std::uint32_t(attributes.size());
+                shape.slots = ownSlots(shape);
+
+                std::uint64_t h = hashMix(shape.tag);
+                for (DOMsymbol name : attributes)
+                    h = hashMix(h ^ name);
+                for (std::size_t r = begin; r < pending.size(); ++r)
+                    h = hashMix(h ^ (std::uint64_t(pending[r].first) << 32 | pending[r].second));
+
+                auto bucket = buckets.find(h);
+                for (std::uint32_t s = (bucket == buckets.end() ? NONE : bucket->second); s != NONE; s = chain[s])
+                {
+                    const shape_t &other = shapes[s];
+                    if (other.tag != shape.tag || other.attributeCount != shape.attributeCount ||
+                        other.runCount != shape.runCount ||
+                        !std::equal(attributes.begin(), attributes.end(), names.begin() + other.names))
+                        continue;
+                    bool same = true;
+                    for (std::uint32_t r = 0; r < shape.runCount && same; ++r)
+                        same = (runs[other.runs + r].shape == pending[begin + r].first &&
+                                runLength(other, other.runs + r) == pending[begin + r].second);
+                    if (same)
+                        return s;
+                }
+
+                shape.names = std::uint32_t(names.size());
+                names.insert(names.end(), attributes.begin(), attributes.end());
+                shape.runs = std::uint32_t(runs.size());
+                for (std::size_t r = begin; r < pending.size(); ++r)
+                {
+                    const shape_t &child = shapes[pending[r].first];
+                    runs.push_back({pending[r].first, shape.childCount, shape.size, shape.slots});
+                    shape.childCount += pending[r].second;
+                    shape.size += child.size * pending[r].second;
+                    shape.slots += child.slots * pending[r].second;
+                }
+                std::uint32_t id = std::uint32_t(shapes.size());
+                shapes.push_back(shape);
+                chain.push_back(bucket == buckets.end() ? NONE : bucket->second);
+                buckets[h] = id;
+                return id;
+            };
+
+            struct open_t
+            {
+                const DOMnode *node;
+                std::size_t runs; // first pending run of its children
+            };
+            std::vector<open_t> stack;
+            const DOMnode *node = &tree.getNode(root);
+            while (node)
+            {
+                if (node->isInnerDataNode())
+                    slots.push_back(storeValue(node->getInnerData()));
+                else
+                {
+                    DOMattributeRange range = node->getAllAttributes();
+                    for (std::uint32_t i = 0; i < range.size(); ++i)
+                        slots.push_back(storeValue(range.valueAt(i)));
+                }
+                stack.push_back({node, pending.size()});
+                if (node->getFirstChild() != -1)
+                {
+                    node = &tree.getNode(node->getFirstChild());
+                    continue;
+                }
+                node = nullptr;
+                while (!stack.empty())
+                {
+                    open_t closed = stack.back();
+                    stack.pop_back();
+                    std::uint32_t shape = intern(*closed.node, closed.runs);
+                    pending.resize(closed.runs);
+                    if (stack.empty())
+                    {
+                        rootShape = shape;
+                        break;
+                    }
+                    if (pending.size() > stack.back().runs && pending.back().first == shape)
+                        ++pending.back().second;
+                    else
+                        pending.push_back({shape, 1});
+                    if (closed.node->getNextSibling() != -1)
+                    {
+                        node = &tree.getNode(closed.node->getNextSibling());
+                        break;
+                    }
+                }
+            }
+
+            shapes.shrink_to_fit();
+            names.shrink_to_fit();
+            runs.shrink_to_fit();
+            slots.shrink_to_fit();
+            values.shrink_to_fit();
+        }
+
+    public:
+        /**
+         *  @brief  Constructor, compresses the subtree of the tree. The names
+         *          stay interned in the symbol table of the tree, the text is
+         *          copied.
+         *  @param  tree    the tree
+         *  @param  root    UID of the root of the subtree
+         * */
+        explicit DOMcompressedTree(const DOMtree &tree, DOMnodeUID root = 0)
+            : symbols(tree.shareSymbols()), storage(std::make_unique<DOMarena>(nullptr, tree.shareSymbols()))
+        {
+            if (tree.isValid(root))
+                build(tree, root);
+        }
+
+        // cursors refer to the tree
+        DOMcompressedTree(const DOMcompressedTree &) = delete;
+        DOMcompressedTree &operator=(const DOMcompressedTree &) = delete;
+        DOMcompressedTree(DOMcompressedTree &&) = default;
+        DOMcompressedTree &operator=(DOMcompressedTree &&) = default;
+
+        /**
+         *  @brief  Returns a cursor on the root, the tree must not be empty.
+         * */
+        inline DOMcompressedNode getRoot() const;
+
+        /**
+         *  @brief  Returns a cursor on the node, found by a descent from the
+         *          root in O(depth * log(runs)).
+         *  @param  node    UID of the node, must be valid
+         * */
+        inline DOMcompressedNode getNode(DOMnodeUID node) const;
+
+        /**
+         *  @brief  Checks if the UID refers to a node of the tree.
+         * */
+        inline bool isValid(DOMnodeUID node) const
+        {
+            return node >= 0 && std::uint64_t(node) < getNodeCount();
+        }
+
+        /**
+         *  @brief  Returns the number of nodes in the tree.
+         * */
+        inline std::uint64_t getNodeCount() const
+        {
+            return (rootShape == NONE ? 0 : shapes[rootShape].size);
+        }
+
+        /**
+         *  @brief  Returns the number of distinct shapes of the subtrees.
+         * */
+        inline std::size_t getShapeCount() const
+        {
+            return shapes.size();
+        }
+
+        /**
+         *  @brief  Returns the number of distinct values of the text.
+         * */
+        inline std::size_t getValueCount() const
+        {
+            return values.size();
+        }
+
+        /**
+         *  @brief  Returns the number of bytes taken by the tree.
+         * */
+        std::size_t getMemoryUsage() const
+        {
+            return sizeof(*this) + shapes.size() * sizeof(shape_t) + names.size() * sizeof(DOMsymbol) +
+                   runs.size() * sizeof(run_t) + slots.size() * sizeof(std::uint32_t) +
+                   values.size() * sizeof(std::string_view) + valueBytes;
+        }
+
+        /**
+         *  @brief  Returns the symbol table the names are interned in.
+         * */
+        inline DOMsymbolTable &getSymbols() const
+        {
+            return *symbols;
+        }
+    };
+
+    /**
+     *  @brief  Iterable view of the attributes of a node of a compressed
+     *          tree, yields pairs of {attribute, value} in their order.
+     * */
+    class DOMcompressedAttributeRange
+    {
+    private:
+        const DOMcompressedTree *tree;
+        const DOMsymbol *names;
+        const std::uint32_t *slots;
+        std::uint32_t count;
+
+    public:
+        class iterator
+        {
+        private:
+            const DOMcompressedAttributeRange *range;
+            std::uint32_t i;
+
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef std::pair<std::string_view, std::string_view> value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const value_type *pointer;
+            typedef value_type reference;
+
+            iterator(const DOMcompressedAttributeRange *range, std::uint32_t i) : range(range), i(i) {}
+
+            inline value_type operator*() const
+            {
+                return value_type(range->tree->symbols->name(range->names[i]), range->valueAt(i));
+            }
+            inline iterator &operator++()
+            {
+                ++i;
+                return *this;
+            }
+            inline iterator operator++(int)
+            {
+                iterator old = *this;
+                ++i;
+                return old;
+            }
+            inline bool operator==(const iterator &other) const
+            {
+                return i == other.i;
+            }
+            inline bool operator!=(const iterator &other) const
+            {
+                return i != other.i;
+            }
+        };
+
+        DOMcompressedAttributeRange(const DOMcompressedTree *tree, const DOMsymbol *names,
+                                    const std::uint32_t *slots, std::uint32_t count)
+            : tree(tree), names(names), slots(slots), count(count) {}
+
+        inline iterator begin() const
+        {
+            return iterator(this, 0);
+        }
+        inline iterator end() const
+        {
+            return iterator(this, count);
+        }
+        inline std::uint32_t size() const
+        {
+            return count;
+        }
+        inline bool empty() const
+        {
+            return count == 0;
+        }
+        inline DOMsymbol symbolAt(std::uint32_t i) const
+        {
+            return names[i];
+        }
+        inline std::string_view valueAt(std::uint32_t i) const
+        {
+            return tree->values[slots[i]];
+        }
+    };
+
+    /**
+     *  @brief  Cursor on a node of a DOMcompressedTree, with the accessors
+     *          of DOMnode. It keeps the path from the root, so that moving to
+     *          the parent, a sibling or a child is O(1) (O(log(runs)) for the
+     *          i-th child). The cursor is valid as long as the tree.
+     * */
+    class DOMcompressedNode
+    {
+        friend class DOMcompressedTree;
+
+    private:
+        struct frame_t
+        {
+            std::uint32_t shape;
+            std::uint32_t run;   // of the node among the runs of the parent
+            std::uint32_t child; // index of the node among the children of the parent
+            DOMnodeUID uid;
+            std::uint64_t slot; // first value of the subtree
+        };
+
+        const DOMcompressedTree *tree;
+        std::vector<frame_t> path; // from the root to the node
+
+        explicit DOMcompressedNode(const DOMcompressedTree *tree) : tree(tree) {}
+
+        inline const DOMcompressedTree::shape_t &shape() const
+        {
+            return tree->shapes[path.back().shape];
+        }
+
+        /**
+         *  @brief  Returns the frame of the i-th child of the node on top.
+         * */
+        frame_t childFrame(std::uint32_t i) const
+        {
+            const frame_t &top = path.back();
+            const DOMcompressedTree::shape_t &s = tree->shapes[top.shape];
+            auto first = tree->runs.begin() + s.runs;
+            auto run = std::upper_bound(first, first + s.runCount, i,
+                                        [](std::uint32_t i, const DOMcompressedTree::run_t &run)
+                                        { return i < run.first; }) -
+                       1;
+            const DOMcompressedTree::shape_t &c = tree->shapes[run->shape];
+            std::uint64_t k = i - run->first;
+            return {run->shape, std::uint32_t(run - tree->runs.begin()), i,
+                    top.uid + DOMnodeUID(run->offset + k * c.size), top.slot + run->slot + k * c.slots};
+        }
+
+        /**
+         *  @brief  Computes the frame of the next (step 1) or the previous
+         *          (step -1) sibling of the node on top.
+         *  @return false if there is no such sibling
+         * */
+        bool siblingFrame(int step, frame_t &sibling) const
+        {
+            if (path.size() < 2)
+                return false;
+            const frame_t &top = path.back();
+            const DOMcompressedTree::shape_t &parent = tree->shapes[path[path.size() - 2].shape];
+            if (step > 0)
+            {
+                if (top.child + 1 == parent.childCount)
+                    return false;
+                const DOMcompressedTree::shape_t &s = tree->shapes[top.shape];
+                std::uint32_t run = top.run;
+                if (run + 1 < parent.runs + parent.runCount && tree->runs[run + 1].first == top.child + 1)
+                    ++run;
+                sibling = {tree->runs[run].shape, run, top.child + 1, top.uid + DOMnodeUID(s.size), top.slot + s.slots};
+                return true;
+            }
+            if (top.child == 0)
+                return false;
+            std::uint32_t run = top.run;
+            if (tree->runs[run].first == top.child)
+                --run;
+            const DOMcompressedTree::shape_t &s = tree->shapes[tree->runs[run].shape];
+            sibling = {tree->runs[run].shape, run, top.child - 1, top.uid - DOMnodeUID(s.size), top.slot - s.slots};
+            return true;
+        }
+
+    public:
+        /**
+         *  @brief  Returns the tagName of the node, empty string for
+         *          inner-data nodes.
+         * */
+        inline const std::string &getTagName() const
+        {
+            static const std::string noName;
+            return (isInnerDataNode() ? noName : tree->symbols->name(shape().tag));
+        }
+
+        /**
+         *  @brief  Returns the interned id of the tagName of the node,
+         *          NO_SYMBOL for inner-data nodes.
+         * */
+        inline DOMsymbol getTagSymbol() const
+        {
+            return shape().tag;
+        }
+
+        /**
+         *  @brief  Returns the UID of the node, its position in document
+         *          order.
+         * */
+        inline DOMnodeUID getUID() const
+        {
+            return path.back().uid;
+        }
+
+        /**
+         *  @brief  Returns the id of the shape of the subtree of the node.
+         *          Subtrees of the same shape have the same structure and
+         *          differ at most in their text.
+         * */
+        inline std::uint32_t getShape() const
+        {
+            return path.back().shape;
+        }
+
+        /**
+         *  @brief  Returns the number of nodes in the subtree of the node.
+         * */
+        inline std::uint64_t getSubtreeSize() const
+        {
+            return shape().size;
+        }
+
+        /**
+         *  @brief  Returns pointer to the value of the attribute with the
+         *          given interned name, nullptr if it does not exist.
+         * */
+        const std::string_view *findAttribute(DOMsymbol attribute) const
+        {
+            const DOMcompressedTree::shape_t &s = shape();
+            for (std::uint32_t i = 0; i < s.attributeCount; ++i)
+                if (tree->names[s.names + i] == attribute)
+                    return &tree->values[tree->slots[path.back().slot + i]];
+            return nullptr;
+        }
+
+        /**
+         *  @brief  Gets the value of the said attribute. Returns empty
+         *          string if the attribute does not exist.
+         * */
+        inline std::string getAttribute(std::string_view attribute) const
+        {
+            const std::string_view *value = findAttribute(tree->symbols->find(attribute));
+            return (value ? std::string(*value) : std::string());
+        }
+
+        /**
+         *  @brief  Checks if the node has the said attribute.
+         * */
+        inline bool hasAttribute(std::string_view attribute) const
+        {
+            return findAttribute(tree->symbols->find(attribute)) != nullptr;
+        }
+
+        /**
+         *  @brief  Returns a view of all the attributes which yields pairs
+         *          of {attribute, value}.
+         * */
+        inline DOMcompressedAttributeRange getAllAttributes() const
+        {
+            const DOMcompressedTree::shape_t &s = shape(); // no attributes for inner-data nodes
+            return DOMcompressedAttributeRange(tree, tree->names.data() + s.names,
+                                               tree->slots.data() + path.back().slot, s.attributeCount);
+        }
+
+        /**
+         *  @brief  Checks if node is inner-data node.
+         * */
+        inline bool isInnerDataNode() const
+        {
+            return shape().tag == DOMsymbolTable::NO_SYMBOL;
+        }
+
+        /**
+         *  @brief  Returns view of inner-data, empty string if the node does
+         *          not store inner-data. The data lives as long as the tree.
+         * */
+        inline std::string_view getInnerData() const
+        {
+            return (isInnerDataNode() ? tree->values[tree->slots[path.back().slot]] : std::string_view());
+        }
+
+        /**
+         *  @brief  Returns number of children of the node.
+         * */
+        inline std::uint32_t getChildCount() const
+        {
+            return shape().childCount;
+        }
+
+        /**
+         *  @brief  Returns UID of the parent, -1 for the root.
+         * */
+        inline DOMnodeUID getParent() const
+        {
+            return (path.size() < 2 ? -1 : path[path.size() - 2].uid);
+        }
+
+        /**
+         *  @brief  Returns UID of the first child, -1 if there are no children.
+         * */
+        inline DOMnodeUID getFirstChild() const
+        {
+            return (getChildCount() == 0 ? -1 : path.back().uid + 1);
+        }
+
+        /**
+         *  @brief  Returns UID of the last child, -1 if there are no children.
+         * */
+        inline DOMnodeUID getLastChild() const
+        {
+            return (getChildCount() == 0 ? -1 : childFrame(getChildCount() - 1).uid);
+        }
+
+        /**
+         *  @brief  Returns UID of the next sibling, -1 if it is the last child.
+         * */
+        inline DOMnodeUID getNextSibling() const
+        {
+            frame_t sibling;
+            return (siblingFrame(1, sibling) ? sibling.uid : -1);
+        }
+
+        /**
+         *  @brief  Returns UID of the previous sibling, -1 if it is the first child.
+         * */
+        inline DOMnodeUID getPrevSibling() const
+        {
+            frame_t sibling;
+            return (siblingFrame(-1, sibling) ? sibling.uid : -1);
+        }
+
+        /**
+         *  @brief  Moves to the parent.
+         *  @return false, without moving, if the node is the root
+         * */
+        inline bool toParent()
+        {
+            if (path.size() < 2)
+                return false;
+            path.pop_back();
+            return true;
+        }
+
+        /**
+         *  @brief  Moves to the first child.
+         *  @return false, without moving, if there are no children
+         * */
+        inline bool toFirstChild()
+        {
+            const frame_t &top = path.back();
+            const DOMcompressedTree::shape_t &s = tree->shapes[top.shape];
+            if (s.childCount == 0)
+                return false;
+            path.push_back({tree->runs[s.runs].shape, s.runs, 0, top.uid + 1,
+                            top.slot + DOMcompressedTree::ownSlots(s)});
+            return true;
+        }
+
+        /**
+         *  @brief  Moves to the i-th child.
+         *  @return false, without moving, if there is no such child
+         * */
+        inline bool toChild(std::uint32_t i)
+        {
+            if (i >= getChildCount())
+                return false;
+            path.push_back(childFrame(i));
+            return true;
+        }
+
+        /**
+         *  @brief  Moves to the next sibling.
+         *  @return false, without moving, if it is the last child
+         * */
+        inline bool toNextSibling()
+        {
+            return siblingFrame(1, path.back());
+        }
+
+        /**
+         *  @brief  Moves to the previous sibling.
+         *  @return false, without moving, if it is the first child
+         * */
+        inline bool toPrevSibling()
+        {
+            return siblingFrame(-1, path.back());
+        }
+
+        /**
+         *  @brief  Returns the depth of the node, 0 for the root.
+         * */
+        inline std::size_t getDepth() const
+        {
+            return path.size() - 1;
+        }
+    };
+
+    inline DOMcompressedNode DOMcompressedTree::getRoot() const
+    {
+        DOMcompressedNode node(this);
+        node.path.push_back({rootShape, 0, 0, 0, 0});
+        return node;
+    }
+
+    inline DOMcompressedNode DOMcompressedTree::getNode(DOMnodeUID uid) const
+    {
+        DOMcompressedNode node = getRoot();
+        while (node.getUID() != uid)
+        {
+            // the child whose subtree holds the node
+            const DOMcompressedNode::frame_t &top = node.path.back();
+            const shape_t &s = shapes[top.shape];
+            std::uint64_t offset = std::uint64_t(uid - top.uid);
+            auto first = runs.begin() + s.runs;
+            auto run = std::upper_bound(first, first + s.runCount, offset,
+                                        [](std::uint64_t offset, const run_t &run)
+                                        { return offset < run.offset; }) -
+                       1;
+            node.path.push_back(node.childFrame(
+                run->first + std::uint32_t((offset - run->offset) / shapes[run->shape].size)));
+        }
+        return node;
+    }
+
+} // namespace dom_parser
+
+#endif
@@ -0,0 +1,701 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_DIFF
+#define DOM_PARSER_DOM_DIFF
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "DOMhash.hpp"
+#include "DOMtree.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Operation of an edit script made by DOMdiff.
+     *
+     *          Nodes of the old tree are referred to by their UIDs, nodes
+     *          created by an earlier INSERT of the same script by the index
+     *          of that edit (parentEdit, afterEdit). A node is placed after
+     *          the sibling given by after / afterEdit, or first among the
+     *          children of its parent if both are -1.
+     * */
+    struct DOMedit
+    {
+        enum kind_t
+        {
+            INSERT,           // copy of node of the new tree, with its subtree if subtree is set
+            DELETE,           // subtree of node
+            MOVE,             // subtree of node, to parent after the sibling
+            UPDATE_ATTRIBUTE, // set attribute name of node to value
+            REMOVE_ATTRIBUTE, // remove attribute name of node
+            UPDATE_TEXT       // set inner-data of node to value
+        };
+
+        kind_t kind;
+        DOMnodeUID node = -1;
+        DOMnodeUID parent = -1;
+        DOMnodeUID after = -1;
+        std::int64_t parentEdit = -1;
+        std::int64_t afterEdit = -1;
+        bool subtree = false;
+        std::string name;
+        std::string value;
+    };
+
+    /**
+     *  @brief  Difference between two revisions of a document, as an edit
+     *          script which turns the old tree into the new one in place,
+     *          keeping the UIDs of the nodes the revisions have in common.
+     *
+     *          Nodes are matched in this order:
+     *              - the roots,
+     *              - elements with the same unique id attribute,
+     *              - subtrees whose hash occurs once in each tree,
+     *              - top-down, the unmatched children of matched nodes:
+     *                equal subtrees first, then the longest common
+     *                subsequence of their tags (text nodes match text
+     *                nodes), which is cut to an in-order greedy match when
+     *                the sibling lists are long.
+     *          Matched children out of order are moved, the fewest such
+     *          moves are found from the longest increasing run of their old
+     *          positions. Time is linear in the size of the trees, but for
+     *          the LCS of short sibling lists.
+     *
+     *          Subtree hashes are 64-bit and taken as equality. Tags cannot
+     *          be renamed in place, the roots are matched even if their
+     *          tags differ and the script then leaves the old tag.
+     * */
+    class DOMdiff
+    {
+    private:
+        static constexpr std::uint32_t NONE = static_cast<std::uint32_t>(-1);
+
+        // LCS of the children is computed when the table has at most so many cells
+        static constexpr std::size_t LCS_CELLS = std::size_t(1) << 16;
+
+        // nodes of a tree in pre-order, a subtree is the range [i, i + size[i])
+        struct side_t
+        {
+            const DOMtree *tree = nullptr;
+            std::vector<DOMnodeUID> uids;
+            std::vector<std::uint32_t> parent;
+            std::vector<std::uint32_t> position; // among the siblings
+            std::vector<std::uint32_t> size;
+            std::vector<std::uint32_t> label; // 0 for inner-data, tag otherwise
+            std::vector<std::uint64_t> hash;
+            std::vector<std::uint32_t> match; // index in the other tree
+        };
+
+        DOMtree *oldTree;
+        const DOMtree *newTree;
+        side_t before, after;
+        std::unordered_map<std::string_view, std::uint32_t> labels;
+        std::vector<DOMedit> edits;
+
+        /**
+         *  @brief  Lists the nodes of the tree in pre-order and hashes their
+         *          subtrees.
+         * */
+        void walk(const DOMtree &tree, side_t &side)
+        {
+            side.tree = &tree;
+            if (!tree.isValid(0))
+                return;
+            std::size_t count = std::size_t(tree.getNodeCount());
+            side.uids.reserve(count);
+            side.parent.reserve(count);
+            side.position.reserve(count);
+            side.label.reserve(count);
+            side.hash.reserve(count);
+
+            std::vector<std::uint32_t> open; // ancestors of the node
+            std::vector<std::uint32_t> children; // children met so far, per node
+            const DOMnode *node = &tree.getNode(0);
+            while (node)
+            {
+                std::uint32_t index = std::uint32_t(side.uids.size());
+                std::uint32_t parent = (open.empty() ? NONE : open.back());
+                side.uids.push_back(node->getUID());
+                side.parent.push_back(parent);
+                side.position.push_back(parent == NONE ? 0 : children[parent]++);
+                children.push_back(0);
+
+                std::uint64_t local;
+                if (node->isInnerDataNode())
+                {
+                    side.label.push_back(0);
+                    local = hashMix(hashBytes(node->getInnerData()));
+                }
+                else
+                {
+                    const std::string &tag = node->getTagName();
+                    auto found = labels.try_emplace(tag, std::uint32_t(labels.size() + 1)).first;
+                    side.label.push_back(found->second);
+                    local = hashMix(hashBytes(tag) + 1);
+                    std::uint64_t attributes = 0; // in any order
+                    for (auto attribute : node->getAllAttributes())
+                        attributes += hashMix(hashBytes(attribute.first) * 31 + hashBytes(attribute.second));
+                    local ^= hashMix(attributes);
+                }
+                side.hash.push_back(local);
+
+                if (node->getFirstChild() != -1)
+                {
+                    open.push_back(index);
+                    node = &tree.getNode(node->getFirstChild());
+                    continue;
+                }
+                while (node && node->getNextSibling() == -1)
+                {
+                    if (open.empty())
+                        node = nullptr;
+                    else
+                    {
+                        node = &tree.getNode(side.uids[open.back()]);
+                        open.pop_back();
+                    }
+                }
+                if (node)
+                    node = &tree.getNode(node->getNextSibling());
+            }
+
+            // children follow their parent, so in reverse they are done first;
+            // they are folded in reverse order, the same for both trees
+            std::size_t n = side.uids.size();
+            side.size.assign(n, 1);
+            std::vector<std::uint64_t> folded(n, 0);
+            for (std::size_t i = n; i-- > 0;)
+            {
+                side.hash[i] = hashMix(side.hash[i] + folded[i]);
+                if (side.parent[i] != NONE)
+                {
+                    side.size[side.parent[i]] += side.size[i];
+                    folded[side.parent[i]] = folded[side.parent[i]] * 0x100000001b3ull + side.hash[i];
+                }
+            }
+            side.match.assign(n, NONE);
+        }
+
+        inline void pair(std::uint32_t i, std::uint32_t j)
+        {
+            after.match[i] = j;
+            before.match[j] = i;
+        }
+
+        /**
+         *  @brief  Matches the nodes of two equal subtrees, but those already
+         *          matched.
+         * */
+        void pairSubtrees(std::uint32_t i, std::uint32_t j)
+        {
+            std::uint32_t size = std::min(after.size[i], before.size[j]);
+            for (std::uint32_t k = 0; k < size; ++k)
+                if (after.match[i + k] == NONE && before.match[j + k] == NONE)
+                    pair(i + k, j + k);
+        }
+
+        void matchIds(std::string_view idAttribute)
+        {
+            // value -> index, NONE if the value is not unique
+            auto collect = [idAttribute](side_t &side)
+            {
+                std::unordered_map<std::string_view, std::uint32_t> ids;
+                for (std::uint32_t i = 0; i < side.uids.size(); ++i)
+                {
+                    if (side.label[i] == 0)
+                        continue;
+                    const DOMnode &node = side.tree->getNode(side.uids[i]);
+                    for (auto attribute : node.getAllAttributes())
+                        if (attribute.first == idAttribute)
+                        {
+                            auto inserted = ids.emplace(attribute.second, i);
+                            if (!inserted.second)
+                                inserted.first->second = NONE;
+                            break;
+                        }
+                }
+                return ids;
+            };
+            std::unordered_map<std::string_view, std::uint32_t> oldIds = collect(before);
+            if (oldIds.empty())
+                return;
+            for (const auto &id : collect(after))
+            {
+                auto found = oldIds.find(id.first);
+                if (found == oldIds.end() || id.second == NONE || found->second == NONE)
+                    continue;
+                std::uint32_t i = id.second, j = found->second;
+                if (after.match[i] == NONE && before.match[j] == NONE && after.label[i] == before.label[j])
+                    pair(i, j);
+            }
+        }
+
+        void matchUniqueSubtrees()
+        {
+            // hash -> index, NONE if the hash is not unique
+            std::unordered_map<std::uint64_t, std::uint32_t> oldHashes, newHashes;
+            auto collect = [](const side_t &side, std::unordered_map<std::uint64_t, std::uint32_t> &hashes)
+            {
+                hashes.reserve(side.uids.size());
+                for (std::uint32_t i = 1; i < side.uids.size(); ++i)
+                {
+                    auto inserted = hashes.emplace(side.hash[i], i);
+                    if (!inserted.second)
+                        inserted.first->second = NONE;
+                }
+            };
+            collect(before, oldHashes);
+            collect(after, newHashes);
+            for (std::uint32_t i = 1; i < after.uids.size();)
+            {
+                auto found = oldHashes.find(after.hash[i]);
+                if (found != oldHashes.end() && found->second != NONE && newHashes[after.hash[i]] != NONE &&
+                    after.match[i] == NONE && before.match[found->second] == NONE)
+                {
+                    pairSubtrees(i, found->second);
+                    i += after.size[i];
+                }
+                else
+                    ++i;
+            }
+        }
+
+        /**
+         *  @brief  Matches the unmatched children of the new node i and of the
+         *          old node j.
+         * */
+        void matchChildren(std::uint32_t i, std::uint32_t j)
+        {
+            std::vector<std::uint32_t> a, b;
+            for (std::uint32_t c = i + 1; c < i + after.size[i]; c += after.size[c])
+                if (after.match[c] == NONE)
+                    a.push_back(c);
+            if (a.empty())
+                return;
+            for (std::uint32_t c = j + 1; c < j + before.size[j]; c += before.size[c])
+                if (before.match[c] == NONE)
+                    b.push_back(c);
+            if (b.empty())
+                return;
+
+            // equal subtrees: common ends, then anywhere
+            std::size_t front = 0, back = 0;
+            while (front < a.size() && front < b.size() && after.hash[a[front]] == before.hash[b[front]])
+                pairSubtrees(a[front], b[front]), ++front;
+            while (back + front < a.size() && back + front < b.size() &&
+                   after.hash[a[a.size() - 1 - back]] == before.hash[b[b.size() - 1 - back]])
+                pairSubtrees(a[a.size() - 1 - back], b[b.size() - 1 - back]), ++back;
+            a.assign(a.begin() + front, a.end() - back);
+            b.assign(b.begin() + front, b.end() - back);
+            if (a.empty() || b.empty())
+                return;
+
+            std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> equal;
+            for (std::size_t k = b.size(); k-- > 0;)
+                equal[before.hash[b[k]]].push_back(b[k]);
+            for (std::uint32_t c : a)
+            {
+                auto found = equal.find(after.hash[c]);
+                if (found == equal.end() || found->second.empty())
+                    continue;
+                pairSubtrees(c, found->second.back());
+                found->second.pop_back();
+            }
+            auto unmatched = [](const side_t &side, std::vector<std::uint32_t> &list)
+            {
+                list.erase(std::remove_if(list.begin(), list.end(), [&side](std::uint32_t c)
+                                          { return side.match[c] != NONE; }),
+                           list.end());
+            };
+            unmatched(after, a);
+            unmatched(before, b);
+            if (a.empty() || b.empty())
+                return;
+
+            // same tags
+            if (a.size() * b.size() <= LCS_CELLS)
+            {
+                std::size_t width = b.size() + 1;
+                std::vector<std::uint32_t> common((a.size() + 1) * width, 0);
+                for (std::size_t x = a.size(); x-- > 0;)
+                    for (std::size_t y = b.size(); y-- > 0;)
+                        common[x * width + y] = (after.label[a[x]] == before.label[b[y]]
+                                                     ? common[(x + 1) * width + y + 1] + 1
+                                                     : std::max(common[(x + 1) * width + y], common[x * width + y + 1]));
+                for (std::size_t x = 0, y = 0; x < a.size() && y < b.size();)
+                {
+                    if (after.label[a[x]] == before.label[b[y]])
+                        pair(a[x++], b[y++]);
+                    else if (common[(x + 1) * width + y] >= common[x * width + y + 1])
+                        ++x;
+                    else
+                        ++y;
+                }
+                return;
+            }
+            std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> tags;
+            for (std::size_t k = b.size(); k-- > 0;)
+                tags[before.label[b[k]]].push_back(b[k]);
+            for (std::uint32_t c : a)
+            {
+                auto found = tags.find(after.label[c]);
+                if (found == tags.end() || found->second.empty())
+                    continue;
+                pair(c, found->second.back());
+                found->second.pop_back();
+            }
+        }
+
+        /**
+         *  @brief  Adds the edits updating the attributes or the text of the
+         *          old node j to those of the new node i.
+         * */
+        void updateContent(std::uint32_t i, std::uint32_t j)
+        {
+            if (after.hash[i] == before.hash[j])
+                return;
+            const DOMnode &updated = newTree->getNode(after.uids[i]);
+            const DOMnode &node = oldTree->getNode(before.uids[j]);
+            if (updated.isInnerDataNode())
+            {
+                if (updated.getInnerData() != node.getInnerData())
+                    addEdit(DOMedit::UPDATE_TEXT, node.getUID(), "", updated.getInnerData());
+                return;
+            }
+            // setAttribute() appends new names, so the old attributes kept in
+            // their order must be a prefix of the new ones; those past the
+            // first one out of order are removed and appended again
+            std::vector<std::pair<std::string_view, std::string_view>> wanted;
+            for (auto attribute : updated.getAllAttributes())
+                wanted.push_back(attribute);
+            auto find = [&wanted](std::string_view name)
+            {
+                std::size_t k = 0;
+                while (k < wanted.size() && wanted[k].first != name)
+                    ++k;
+                return k;
+            };
+            std::vector<std::string_view> values(wanted.size()); // old values of the kept names
+            std::size_t inPlace = 0;
+            bool ordered = true;
+            for (auto previous : node.getAllAttributes())
+            {
+                std::size_t k = find(previous.first);
+                if (k == wanted.size())
+                    continue;
+                values[k] = previous.second;
+                if (ordered && k == inPlace)
+                    ++inPlace;
+                else
+                    ordered = false;
+            }
+            for (auto previous : node.getAllAttributes())
+                if (find(previous.first) >= inPlace)
+                    addEdit(DOMedit::REMOVE_ATTRIBUTE, node.getUID(), previous.first, "");
+            for (std::size_t k = 0; k < wanted.size(); ++k)
+                if (k >= inPlace || values[k] != wanted[k].second)
+                    addEdit(DOMedit::UPDATE_ATTRIBUTE, node.getUID(), wanted[k].first, wanted[k].second);
+        }
+
+        inline void addEdit(DOMedit::kind_t kind, DOMnodeUID node, std::string_view name, std::string_view value)
+        {
+            DOMedit edit;
+            edit.kind = kind;
+            edit.node = node;
+            edit.name = name;
+            edit.value = value;
+            edits.push_back(std::move(edit));
+        }
+
+        /**
+         *  @brief  Writes the edit script: inserts, moves and updates in
+         *          pre-order of the new tree, so that parents are in place
+         *          before their children, then the deletes.
+         * */
+        void script()
+        {
+            std::size_t n = after.uids.size();
+            if (n == 0 || before.uids.empty())
+                return;
+
+            // matched nodes in the subtree of every new node
+            std::vector<std::uint32_t> matched(n, 0);
+            for (std::size_t i = n; i-- > 0;)
+            {
+                matched[i] += (after.match[i] != NONE);
+                if (after.parent[i] != NONE)
+                    matched[after.parent[i]] += matched[i];
+            }
+
+            // the node of the old tree a new node becomes: its match, or an insert
+            std::vector<std::int64_t> inserted(n, -1);
+            auto place = [this, &inserted](DOMedit &edit, std::uint32_t parent, std::uint32_t previous)
+            {
+                if (after.match[parent] != NONE)
+                    edit.parent = before.uids[after.match[parent]];
+                else
+                    edit.parentEdit = inserted[parent];
+                if (previous == NONE)
+                    return;
+                if (after.match[previous] != NONE)
+                    edit.after = before.uids[after.match[previous]];
+                else
+                    edit.afterEdit = inserted[previous];
+            };
+
+            std::vector<std::uint32_t> children, positions, tails, links;
+            std::vector<bool> kept;
+            for (std::uint32_t i = 0; i < n;)
+            {
+                if (i > 0 && after.match[i] == NONE && matched[i] == 0)
+                {
+                    i += after.size[i]; // inserted with its subtree
+                    continue;
+                }
+                std::uint32_t j = after.match[i];
+                if (j != NONE)
+                    updateContent(i, j);
+
+                children.clear();
+                for (std::uint32_t c = i + 1; c < i + after.size[i]; c += after.size[c])
+                    children.push_back(c);
+
+                // children already under the node stay where they are if their
+                // old positions increase, the longest such run is kept
+                kept.assign(children.size(), false);
+                tails.clear();
+                links.assign(children.size(), NONE);
+                positions.clear();
+                for (std::uint32_t k = 0; k < children.size(); ++k)
+                {
+                    std::uint32_t m = after.match[children[k]];
+                    if (j == NONE || m == NONE || before.parent[m] != j)
+                        continue;
+                    std::uint32_t position = before.position[m];
+                    auto it = std::lower_bound(tails.begin(), tails.end(), position,
+                                               [this, &children](std::uint32_t t, std::uint32_t p)
+                                               { return before.position[after.match[children[t]]] < p; });
+                    links[k] = (it == tails.begin() ? NONE : *(it - 1));
+                    if (it == tails.end())
+                        tails.push_back(k);
+                    else
+                        *it = k;
+                }
+                for (std::uint32_t k = (tails.empty() ? NONE : tails.back()); k != NONE; k = links[k])
+                    kept[k] = true;
+
+                std::uint32_t previous = NONE;
+                for (std::uint32_t k = 0; k < children.size(); ++k)
+                {
+                    std::uint32_t c = children[k];
+                    if (after.match[c] != NONE)
+                    {
+                        if (!kept[k])
+                        {
+                            DOMedit edit;
+                            edit.kind = DOMedit::MOVE;
+                            edit.node = before.uids[after.match[c]];
+                            place(edit, i, previous);
+                            edits.push_back(std::move(edit));
+                        }
+                    }
+                    else
+                    {
+                        DOMedit edit;
+                        edit.kind = DOMedit::INSERT;
+                        edit.node = after.uids[c];
+                        edit.subtree = (matched[c] == 0);
+                        place(edit, i, previous);
+                        inserted[c] = std::int64_t(edits.size());
+                        edits.push_back(std::move(edit));
+                    }
+                    previous = c;
+                }
+                ++i;
+            }
+
+            for (std::uint32_t j = 1; j < before.uids.size();)
+            {
+                if (before.match[j] == NONE)
+                {
+                    addEdit(DOMedit::DELETE, before.uids[j], "", "");
+                    j += before.size[j];
+                }
+                else
+                    ++j;
+            }
+        }
+
+        /**
+         *  @brief  Appends a copy of the source node, with its subtree if
+         *          deep, to the children of parent.
+         * */
+        static DOMnodeUID copyNode(DOMtree &tree, DOMnodeUID parent, const DOMtree &source, DOMnodeUID node,
+                                   bool deep)
+        {
+            if (deep)
+                return tree.graft(source, node, parent);
+            const DOMnode &original = source.getNode(node);
+            if (original.isInnerDataNode())
+                return tree.addInnerDataNode(parent, original.getInnerData());
+            DOMnodeUID copy = tree.addNode(parent, original.getTagName());
+            if (copy != -1)
+                for (auto attribute : original.getAllAttributes())
+                    tree.getNode(copy).setAttribute(attribute.first, attribute.second);
+            return copy;
+        }
+
+        /**
+         *  @brief  Moves the node of the tree after the sibling, or first
+         *          among the children of parent if after is -1.
+         * */
+        static bool placeNode(DOMtree &tree, DOMnodeUID node, DOMnodeUID parent, DOMnodeUID after)
+        {
+            if (after != -1)
+                return tree.getNode(node).getPrevSibling() == after || tree.moveSubtreeAfter(node, after);
+            DOMnodeUID first = tree.getNode(parent).getFirstChild();
+            if (first == node)
+                return true;
+            if (first == -1)
+                return tree.moveSubtree(node, parent);
+            return tree.moveSubtreeBefore(node, first);
+        }
+
+    public:
+        /**
+         *  @brief  Constructor, computes the edit script.
+         *  @param  oldTree     tree to be patched
+         *  @param  newTree     new revision, must outlive the diff
+         *  @param  idAttribute attribute identifying elements, empty not
+         *                      to match by ids
+         * */
+        DOMdiff(DOMtree &oldTree, const DOMtree &newTree, std::string_view idAttribute = "id")
+            : oldTree(&oldTree), newTree(&newTree)
+        {
+            walk(oldTree, before);
+            walk(newTree, after);
+            if (before.uids.empty() || after.uids.empty())
+                return;
+
+            pair(0, 0);
+            if (!idAttribute.empty())
+                matchIds(idAttribute);
+            matchUniqueSubtrees();
+            for (std::uint32_t i = 0; i < after.uids.size(); ++i)
+                if (after.match[i] != NONE)
+                    matchChildren(i, after.match[i]);
+            script();
+        }
+
+        /**
+         *  @brief  Returns the edit script, empty if the trees are equal.
+         * */
+        inline const std::vector<DOMedit> &getEdits() const
+        {
+            return edits;
+        }
+
+        /**
+         *  @brief  Returns pairs of {UID in the new tree, UID in the old
+         *          tree} of the matched nodes, in pre-order of the new tree.
+         * */
+        std::vector<std::pair<DOMnodeUID, DOMnodeUID>> getMatches() const
+        {
+            std::vector<std::pair<DOMnodeUID, DOMnodeUID>> matches;
+            for (std::size_t i = 0; i < after.uids.size(); ++i)
+                if (after.match[i] != NONE)
+                    matches.emplace_back(after.uids[i], before.uids[after.match[i]]);
+            return matches;
+        }
+
+        /**
+         *  @brief  Applies the edit script to the old tree.
+         *  @param  created     if not null, receives the UIDs of the nodes
+         *                      created by the INSERT edits, indexed by edit
+         *  @return true    if every edit applied
+         *          false   if the old tree changed since the diff, edits
+         *                  before the failed one stay applied
+         * */
+        bool patch(std::vector<DOMnodeUID> *created = nullptr)
+        {
+            return apply(*oldTree, *newTree, edits, created);
+        }
+
+        /**
+         *  @brief  Applies an edit script to a tree.
+         *  @param  tree    tree to be patched
+         *  @param  source  tree the inserted nodes are copied from
+         *  @param  edits   the edit script
+         *  @param  created if not null, receives the UIDs of the nodes
+         *                  created by the INSERT edits, indexed by edit
+         *  @return true    if every edit applied, false otherwise
+         * */
+        static bool apply(DOMtree &tree, const DOMtree &source, const std::vector<DOMedit> &edits,
+                          std::vector<DOMnodeUID> *created = nullptr)
+        {
+            std::vector<DOMnodeUID> inserted(edits.size(), -1);
+            bool applied = true;
+            for (std::size_t e = 0; e < edits.size() && applied; ++e)
+            {
+                const DOMedit &edit = edits[e];
+                DOMnodeUID parent = (edit.parentEdit >= 0 ? inserted[edit.parentEdit] : edit.parent);
+                DOMnodeUID after = (edit.afterEdit >= 0 ? inserted[edit.afterEdit] : edit.after);
+                switch (edit.kind)
+                {
+                case DOMedit::INSERT:
+                    applied = tree.isValid(parent) && source.isValid(edit.node) &&
+                              (inserted[e] = copyNode(tree, parent, source, edit.node, edit.subtree)) != -1 &&
+                              placeNode(tree, inserted[e], parent, after);
+                    break;
+                case DOMedit::MOVE:
+                    applied = tree.isValid(edit.node) && tree.isValid(parent) &&
+                              (after != -1 || tree.getNode(edit.node).getParent() == parent ||
+                               tree.moveSubtree(edit.node, parent)) &&
+                              placeNode(tree, edit.node, parent, after);
+                    break;
+                case DOMedit::DELETE:
+                    if ((applied = tree.isValid(edit.node)))
+                        tree.deleteSubtree(edit.node);
+                    break;
+                case DOMedit::UPDATE_ATTRIBUTE:
+                    if ((applied = tree.isValid(edit.node)))
+                        tree.getNode(edit.node).setAttribute(edit.name, edit.value);
+                    break;
+                case DOMedit::REMOVE_ATTRIBUTE:
+                    if ((applied = tree.isValid(edit.node)))
+                        tree.getNode(edit.node).removeAttribute(edit.name);
+                    break;
+                case DOMedit::UPDATE_TEXT:
+                    applied = tree.isValid(edit.node) && tree.getNode(edit.node).isInnerDataNode();
+                    if (applied)
+                        tree.getNode(edit.node).setInnerData(edit.value);
+                    break;
+                }
+            }
+            if (created)
+                *created = std::move(inserted);
+            return applied;
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
@@ -0,0 +1,392 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_HASH
+#define DOM_PARSER_DOM_HASH
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "DOMarena.hpp"
+#include "DOMnode.hpp"
+#include "DOMnodeTable.hpp"
+#include "DOMthreads.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Structural hash of a subtree, 64 bits, or 128 bits with the
+     *          second half when wide hashes are enabled.
+     * */
+    struct DOMhash
+    {
+        std::uint64_t low = 0;
+        std::uint64_t high = 0;
+
+        inline bool operator==(const DOMhash &other) const
+        {
+            return low == other.low && high == other.high;
+        }
+        inline bool operator!=(const DOMhash &other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    /**
+     *  @brief  Finalizer of splitmix64, spreads every bit of x over the
+     *          result.
+     * */
+    inline constexpr std::uint64_t hashMix(std::uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    /**
+     *  @brief  Hashes the bytes of the string eight at a time. The result
+     *          depends only on the bytes and the seed, so it is the same on
+     *          every run and for every tree.
+     * */
+    inline std::uint64_t hashBytes(std::string_view bytes, std::uint64_t seed = 0)
+    {
+        std::uint64_t h = hashMix(seed ^ bytes.size());
+        std::size_t i = 0;
+        for (; i + 8 <= bytes.size(); i += 8)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, bytes.data() + i, 8);
+            h = hashMix(h ^ word) * 0x9fb21c651e98df25ull;
+        }
+        if (i < bytes.size())
+        {
+            std::uint64_t word = 0;
+            std::memcpy(&word, bytes.data() + i, bytes.size() - i);
+            h = hashMix(h ^ word) * 0x9fb21c651e98df25ull;
+        }
+        return hashMix(h);
+    }
+
+    /**
+     *  @brief  Merkle hashes of the subtrees of a tree. The hash of a node
+     *          covers its tag and its attributes in any order, or its
+     *          inner-data, and the hashes of its children in order; equal
+     *          subtrees of any trees have equal hashes.
+     *
+     *          Hashes are cached per slot. A change of a node marks it and
+     *          its ancestors dirty, up to the first one already dirty, so
+     *          that the next lookup recomputes only the dirty paths. The
+     *          first build shares the children subtrees of the root between
+     *          threads. Hashes which cannot follow the changes of the tree
+     *          (after a concurrent build or compaction) are marked stale and
+     *          rebuilt by the next lookup.
+     * */
+    class DOMhashes : public DOMattributeObserver
+    {
+    private:
+        // minimum number of nodes for the build to use several threads
+        static constexpr std::int64_t BUILD_GRAIN = 16384;
+
+        // seeds of the two halves of the hashes
+        static constexpr std::uint64_t LOW_SEED = 0x243f6a8885a308d3ull;
+        static constexpr std::uint64_t HIGH_SEED = 0x13198a2e03707344ull;
+
+        std::shared_ptr<DOMobserverList> observerSlot;
+        DOMnodeTable *nodes;
+        const DOMsymbolTable *symbols;
+        bool wide;
+
+        // by slot; a dirty node has dirty ancestors
+        std::vector<DOMhash> hashes;
+        std::vector<std::uint8_t> dirty;
+        bool stale = true;
+
+        // hashes of the names, by symbol
+        std::vector<DOMhash> names;
+
+        // inner-data may be replaced by several threads at once
+        std::mutex mutex;
+
+        inline DOMhash hashString(std::string_view string) const
+        {
+            return {hashBytes(string, LOW_SEED), (wide ? hashBytes(string, HIGH_SEED) : 0)};
+        }
+
+        inline const DOMhash &nameHash(DOMsymbol symbol)
+        {
+            if (symbol >= names.size())
+            {
+                std::size_t first = names.size();
+                names.resize(std::max<std::size_t>(symbols->size(), symbol + 1));
+                for (std::size_t s = first; s < names.size(); ++s)
+                    names[s] = hashString(symbols->name(DOMsymbol(s)));
+            }
+            return names[symbol];
+        }
+
+        inline void reserve(std::uint64_t slot)
+        {
+            if (slot >= hashes.size())
+            {
+                std::uint64_t size = std::max<std::uint64_t>(slot + 1, nodes->size());
+                hashes.resize(size);
+                dirty.resize(size, 1);
+            }
+        }
+
+        /**
+         *  @brief  Marks the node and its ancestors dirty, up to the first
+         *          one already dirty.
+         * */
+        void touch(DOMnodeUID uid)
+        {
+            while (uid != -1)
+            {
+                std::uint64_t slot = uidSlot(uid);
+                reserve(slot);
+                if (dirty[slot])
+                    return;
+                dirty[slot] = 1;
+                uid = nodes->get(slot)->getParent();
+            }
+        }
+
+        /**
+         *  @brief  Returns the hash of the node from its own data and the
+         *          hashes of its children, which must be clean.
+         * */
+        DOMhash combine(const DOMnode &node)
+        {
+            DOMhash h;
+            if (node.isInnerDataNode())
+            {
+                h = hashString(node.getInnerData());
+                h.low = hashMix(h.low + 1);
+                h.high = (wide ? hashMix(h.high + 1) : 0);
+                return h;
+            }
+            h = nameHash(node.getTagSymbol());
+            DOMhash attributes; // summed, so their order does not matter
+            for (auto attribute : node.getAllAttributes())
+            {
+                DOMhash name = hashString(attribute.first), value = hashString(attribute.second);
+                attributes.low += hashMix(name.low * 31 + value.low);
+                if (wide)
+                    attributes.high += hashMix(name.high * 31 + value.high);
+            }
+            h.low = hashMix(h.low ^ hashMix(attributes.low));
+            for (DOMnodeUID child : node.getChildrenUID())
+                h.low = hashMix(h.low * 0x100000001b3ull + hashes[uidSlot(child)].low);
+            if (wide)
+            {
+                h.high = hashMix(h.high ^ hashMix(attributes.high));
+                for (DOMnodeUID child : node.getChildrenUID())
+                    h.high = hashMix(h.high * 0x100000001b3ull + hashes[uidSlot(child)].high);
+            }
+            return h;
+        }
+
+        /**
+         *  @brief  Recomputes the dirty nodes of the subtree, children before
+         *          their parents.
+         * */
+        const DOMhash &compute(DOMnode &subtree_root)
+        {
+            std::uint64_t rootSlot = uidSlot(subtree_root.getUID());
+            reserve(rootSlot);
+            if (!dirty[rootSlot])
+                return hashes[rootSlot];
+
+            std::vector<std::pair<DOMnode *, bool>> stack{{&subtree_root, false}}; // node, children done
+            while (!stack.empty())
+            {
+                auto [node, expanded] = stack.back();
+                if (expanded)
+                {
+                    stack.pop_back();
+                    std::uint64_t slot = uidSlot(node->getUID());
+                    hashes[slot] = combine(*node);
+                    dirty[slot] = 0;
+                    continue;
+                }
+                stack.back().second = true;
+                for (DOMnodeUID child : node->getChildrenUID())
+                {
+                    std::uint64_t slot = uidSlot(child);
+                    reserve(slot);
+                    if (dirty[slot])
+                        stack.push_back({nodes->get(slot), false});
+                }
+            }
+            return hashes[rootSlot];
+        }
+
+    public:
+        /**
+         *  @brief  Constructor, the hashes are built by the first lookup or
+         *          by build().
+         *  @param  arena   arena of the tree, to observe its nodes
+         *  @param  nodes   slots of the nodes of the tree
+         *  @param  wide    compute 128-bit hashes instead of 64-bit
+         * */
+        DOMhashes(DOMarena &arena, DOMnodeTable *nodes, bool wide)
+            : observerSlot(arena.shareObserverSlot()), nodes(nodes), symbols(&arena.getSymbols()), wide(wide)
+        {
+            observerSlot->add(this);
+        }
+
+        DOMhashes(const DOMhashes &) = delete;
+        DOMhashes &operator=(const DOMhashes &) = delete;
+
+        ~DOMhashes()
+        {
+            observerSlot->remove(this);
+        }
+
+        /**
+         *  @brief  Marks the hashes stale, to be rebuilt by the next lookup.
+         *  @param  table   slots of the nodes of the tree, which may have
+         *                  been replaced
+         * */
+        void invalidate(DOMnodeTable *table)
+        {
+            nodes = table;
+            stale = true;
+        }
+
+        /**
+         *  @brief  Computes the hashes of all the nodes of the tree.
+         *  @param  threads     maximum number of threads to use
+         * */
+        void build(unsigned threads)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            hashes.assign(nodes->size(), DOMhash());
+            dirty.assign(nodes->size(), 1);
+            stale = false;
+            if (nodes->count() == 0)
+                return;
+            if (symbols->size() > 0)
+                nameHash(DOMsymbol(symbols->size() - 1)); // all the names, read only by the threads
+
+            DOMnode &root = *nodes->get(0);
+            if (threads > 1 && nodes->count() >= BUILD_GRAIN && root.getChildCount() > 1)
+            {
+                // children subtrees of the root are taken one by one, they
+                // write disjoint slots
+                std::vector<DOMnode *> children;
+                for (DOMnodeUID child : root.getChildrenUID())
+                    children.push_back(nodes->get(uidSlot(child)));
+                parallelEach(threads, children.size(), [&](std::size_t, std::size_t i)
+                             { compute(*children[i]); });
+            }
+            compute(root);
+        }
+
+        /**
+         *  @brief  Checks if the hashes have to be rebuilt before lookups.
+         * */
+        inline bool isStale() const
+        {
+            return stale;
+        }
+
+        /**
+         *  @brief  Checks if the hashes are 128-bit.
+         * */
+        inline bool isWide() const
+        {
+            return wide;
+        }
+
+        /**
+         *  @brief  Returns the hash of the subtree of the node, recomputing
+         *          its dirty part first.
+         * */
+        DOMhash getHash(DOMnode &node)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return compute(node);
+        }
+
+        /**
+         *  @brief  Marks a new node of the tree dirty, with its ancestors.
+         * */
+        void nodeAdded(const DOMnode &node)
+        {
+            if (stale)
+                return;
+            std::lock_guard<std::mutex> lock(mutex);
+            std::uint64_t slot = uidSlot(node.getUID());
+            reserve(slot);
+            dirty[slot] = 1; // the slot may be reused
+            touch(node.getParent());
+        }
+
+        /**
+         *  @brief  Marks new nodes of the tree dirty, with their ancestors,
+         *          under one lock.
+         * */
+        void nodesAdded(const std::vector<DOMnode *> &added)
+        {
+            if (stale || added.empty())
+                return;
+            std::lock_guard<std::mutex> lock(mutex);
+            std::uint64_t last = 0;
+            for (const DOMnode *node : added)
+                last = std::max(last, uidSlot(node->getUID()));
+            reserve(last);
+            for (const DOMnode *node : added)
+            {
+                dirty[uidSlot(node->getUID())] = 1; // the slot may be reused
+                touch(node->getParent());
+            }
+        }
+
+        /**
+         *  @brief  Marks the node dirty, with its ancestors, after its own
+         *          data or its list of children changed.
+         * */
+        void nodeChanged(DOMnodeUID node)
+        {
+            if (stale)
+                return;
+            std::lock_guard<std::mutex> lock(mutex);
+            touch(node);
+        }
+
+        void attributeChanged(DOMnode &node, DOMsymbol /*name*/, std::string_view previous,
+                              std::string_view value) override
+        {
+            if (previous != value)
+                nodeChanged(node.getUID());
+        }
+
+        void innerDataChanged(DOMnode &node, std::string_view previous, std::string_view data) override
+        {
+            if (previous != data)
+                nodeChanged(node.getUID());
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
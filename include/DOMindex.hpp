@@ -0,0 +1,647 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_INDEX
+#define DOM_PARSER_DOM_INDEX
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "DOMarena.hpp"
+#include "DOMnode.hpp"
+#include "DOMnodeTable.hpp"
+#include "DOMthreads.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Secondary indexes of a tree: tag name to nodes, value of the
+     *          id attribute to node, and token of a token-list attribute
+     *          (class) to nodes.
+     *
+     *          Tag entries are added when a node is added. Nodes whose id
+     *          or token list is set are only queued, and their entries are
+     *          added in bulk by the next lookup of an id or a token, from the
+     *          values they hold then: building a tree with the index enabled
+     *          costs a push per change, values replaced before the lookup
+     *          are never hashed, and the table of ids grows once per batch.
+     *
+     *          Entries are removed lazily: every entry is checked
+     *          against the node when read, so entries of deleted nodes, of
+     *          reused slots and of changed or removed attributes are dropped
+     *          by the lookups, and by a sweep of all the lists once they are
+     *          about half stale. Deleting nodes and changing attributes
+     *          only count the entries they make stale.
+     *
+     *          An index which cannot follow the changes of the tree (after
+     *          a concurrent build or compaction) is marked stale and rebuilt
+     *          by the next lookup, by several threads for big trees.
+     * */
+    class DOMindex : public DOMattributeObserver
+    {
+    private:
+        typedef std::vector<DOMnodeUID> list_t;
+
+        struct token_list_t
+        {
+            list_t uids;
+            // some node lost the token since the list was last filtered, and
+            // some node may be listed twice
+            bool lost = false;
+            bool repeated = false;
+        };
+
+        // entry of the table of ids, the value itself is read from the node
+        struct id_entry_t
+        {
+            std::size_t hash;
+            DOMnodeUID uid;
+        };
+
+        // lists built by one thread from a range of slots
+        struct part_t
+        {
+            std::vector<list_t> tags;
+            std::vector<id_entry_t> ids;
+            std::unordered_map<std::string_view, list_t> classes;
+        };
+
+        // minimum number of stale entries before all the lists are swept
+        static constexpr std::size_t SWEEP_SLACK = 4096;
+
+        // minimum number of slots scanned by one thread when building
+        static constexpr std::uint64_t BUILD_GRAIN = 16384;
+
+        // UIDs of the free and of the dropped entries of the table of ids
+        static constexpr DOMnodeUID FREE_ID = -1;
+        static constexpr DOMnodeUID DROPPED_ID = -2;
+
+        std::shared_ptr<DOMobserverList> observerSlot;
+        DOMnodeTable *nodes;
+
+        bool tagsIndexed;
+        DOMsymbol idAttribute;
+        DOMsymbol classAttribute;
+
+        // ids are kept by the hash of the value in an open addressing table
+        // of a power of two size, at most half full counting the dropped
+        // entries; keys of classes are views of the attribute values stored
+        // in the arenas of the tree, which are never modified in place
+        std::vector<list_t> tags;
+        std::vector<id_entry_t> ids;
+        std::size_t usedIds = 0;
+        std::unordered_map<std::string_view, token_list_t> classes;
+
+        // nodes whose id, or token list, changed since the last lookup
+        list_t pendingIds;
+        list_t pendingClasses;
+
+        // number of entries, and an estimate of how many of them are stale
+        std::size_t entries = 0;
+        std::size_t garbage = 0;
+        bool stale = true;
+
+        /**
+         *  @brief  Returns the live node of the UID, nullptr if it was
+         *          deleted.
+         * */
+        inline DOMnode *live(DOMnodeUID uid) const
+        {
+            if (uidSlot(uid) >= nodes->size())
+                return nullptr;
+            DOMnode *node = nodes->get(uidSlot(uid));
+            return (node->getUID() == uid ? node : nullptr);
+        }
+
+        /**
+         *  @brief  Calls f for each token of the token list.
+         * */
+        template <class F>
+        static void forEachToken(std::string_view list, F &&f)
+        {
+            static constexpr std::string_view SPACES = " \t\n\r\f";
+            std::size_t begin = list.find_first_not_of(SPACES);
+            while (begin != std::string_view::npos)
+            {
+                std::size_t end = list.find_first_of(SPACES, begin);
+                f(list.substr(begin, end - begin));
+                if (end == std::string_view::npos)
+                    break;
+                begin = list.find_first_not_of(SPACES, end);
+            }
+        }
+
+        inline bool validTag(DOMnodeUID uid, DOMsymbol tag) const
+        {
+            DOMnode *node = live(uid);
+            return node && node->getTagSymbol() == tag;
+        }
+
+        inline bool validId(DOMnodeUID uid, std::string_view id) const
+        {
+            DOMnode *node = live(uid);
+            const std::string_view *value = (node ? node->findAttribute(idAttribute) : nullptr);
+            return value && *value == id;
+        }
+
+        inline bool validClass(DOMnodeUID uid, std::string_view token) const
+        {
+            DOMnode *node = live(uid);
+            const std::string_view *value = (node ? node->findAttribute(classAttribute) : nullptr);
+            return value && containsToken(*value, token);
+        }
+
+        /**
+         *  @brief  Drops the entries of the list which fail the check.
+         * */
+        template <class Valid>
+        void filter(list_t &list, Valid &&valid)
+        {
+            std::size_t kept = 0;
+            for (DOMnodeUID uid : list)
+                if (valid(uid))
+                    list[kept++] = uid;
+            entries -= list.size() - kept;
+            list.resize(kept);
+        }
+
+        /**
+         *  @brief  Drops the entries of the class list which fail the check
+         *          and, if a node might be listed twice, the repeated ones.
+         * */
+        void filterClass(token_list_t &list, std::string_view token)
+        {
+            if (list.repeated)
+            {
+                std::unordered_set<DOMnodeUID> listed;
+                filter(list.uids, [&](DOMnodeUID uid) { return validClass(uid, token) && listed.insert(uid).second; });
+            }
+            else
+                filter(list.uids, [&](DOMnodeUID uid) { return validClass(uid, token); });
+            list.lost = list.repeated = false;
+        }
+
+        /**
+         *  @brief  Drops the invalid entries of all the lists.
+         * */
+        void sweep()
+        {
+            for (DOMsymbol tag = 0; tag < tags.size(); ++tag)
+                filter(tags[tag], [&](DOMnodeUID uid) { return validTag(uid, tag); });
+            resizeIds(0);
+            for (auto i = classes.begin(); i != classes.end();)
+            {
+                filterClass(i->second, i->first);
+                i = (i->second.uids.empty() ? classes.erase(i) : std::next(i));
+            }
+            garbage = 0;
+        }
+
+        /**
+         *  @brief  Counts entries which turned stale, sweeping the lists
+         *          when about half of the entries are.
+         * */
+        inline void collect(std::size_t n)
+        {
+            garbage += n;
+            if (garbage > entries / 2 + SWEEP_SLACK)
+                sweep();
+        }
+
+        /**
+         *  @brief  Adds the node to the list of the token.
+         * */
+        inline void addToken(std::string_view token, DOMnodeUID uid)
+        {
+            token_list_t &list = classes[token];
+            if (!list.uids.empty() && list.uids.back() == uid) // repeated in the list of the node
+                return;
+            list.repeated = list.repeated || list.lost;
+            list.uids.push_back(uid);
+            ++entries;
+        }
+
+        /**
+         *  @brief  Returns the hash by which the id is kept in the table.
+         * */
+        static inline std::size_t hashId(std::string_view id)
+        {
+            return std::hash<std::string_view>()(id);
+        }
+
+        /**
+         *  @brief  Adds the entry to the table of ids, which must have room
+         *          for it, unless the node is already listed with the hash.
+         * */
+        bool insertId(const id_entry_t &id)
+        {
+            std::size_t mask = ids.size() - 1;
+            for (std::size_t i = id.hash & mask;; i = (i + 1) & mask)
+            {
+                if (ids[i].uid == FREE_ID)
+                {
+                    ids[i] = id;
+                    ++usedIds;
+                    return true;
+                }
+                if (ids[i].hash == id.hash && ids[i].uid == id.uid)
+                    return false;
+            }
+        }
+
+        /**
+         *  @brief  Rehashes the valid entries of the table of ids into a table
+         *          with room for n more entries.
+         * */
+        void resizeIds(std::size_t n)
+        {
+            std::vector<id_entry_t> old;
+            old.swap(ids);
+            std::size_t listed = 0, kept = 0;
+            for (const id_entry_t &id : old)
+            {
+                if (id.uid < 0)
+                    continue;
+                ++listed;
+                DOMnode *node = live(id.uid);
+                const std::string_view *value = (node ? node->findAttribute(idAttribute) : nullptr);
+                if (value && hashId(*value) == id.hash)
+                    old[kept++] = id;
+            }
+            entries -= listed - kept;
+            usedIds = 0;
+            std::size_t size = 16;
+            while (size < 2 * (kept + n))
+                size *= 2;
+            ids.assign(size, id_entry_t{0, FREE_ID});
+            for (std::size_t i = 0; i < kept; ++i)
+                insertId(old[i]);
+        }
+
+        /**
+         *  @brief  Makes room in the table of ids for n more entries, at
+         *          least doubling the room when it has to grow.
+         * */
+        inline void reserveIds(std::size_t n)
+        {
+            if (2 * (usedIds + n) > ids.size())
+                resizeIds(std::max(n, usedIds));
+        }
+
+        /**
+         *  @brief  Queues the node, unless it was the last one queued.
+         * */
+        static inline void enqueue(list_t &queue, DOMnodeUID uid)
+        {
+            if (queue.empty() || queue.back() != uid)
+                queue.push_back(uid);
+        }
+
+        /**
+         *  @brief  Sorts the queue and drops the nodes queued twice, unless
+         *          they were queued in order.
+         * */
+        static void dedupe(list_t &queue)
+        {
+            if (std::adjacent_find(queue.begin(), queue.end(), std::greater_equal<DOMnodeUID>()) != queue.end())
+            {
+                std::sort(queue.begin(), queue.end());
+                queue.erase(std::unique(queue.begin(), queue.end()), queue.end());
+            }
+        }
+
+        /**
+         *  @brief  Adds the entries of the queued nodes which are still
+         *          alive, from the values they hold now.
+         * */
+        void update()
+        {
+            if (!pendingIds.empty())
+            {
+                dedupe(pendingIds);
+                reserveIds(pendingIds.size());
+                for (DOMnodeUID uid : pendingIds)
+                {
+                    const DOMnode *node = live(uid);
+                    const std::string_view *id = (node ? node->findAttribute(idAttribute) : nullptr);
+                    if (id && !id->empty() && insertId(id_entry_t{hashId(*id), uid}))
+                        ++entries;
+                }
+                pendingIds.clear();
+            }
+            if (!pendingClasses.empty())
+            {
+                dedupe(pendingClasses);
+                for (DOMnodeUID uid : pendingClasses)
+                {
+                    const DOMnode *node = live(uid);
+                    if (const std::string_view *list = (node ? node->findAttribute(classAttribute) : nullptr))
+                        forEachToken(*list, [&](std::string_view token) { addToken(token, uid); });
+                }
+                pendingClasses.clear();
+            }
+        }
+
+        /**
+         *  @brief  Adds the nodes in the slots [lo, hi) to the lists.
+         * */
+        void scan(std::uint64_t lo, std::uint64_t hi, part_t &part) const
+        {
+            for (std::uint64_t slot = lo; slot < hi; ++slot)
+            {
+                DOMnode *node = nodes->get(slot);
+                if (node->getUID() < 0 || node->isInnerDataNode())
+                    continue;
+                if (tagsIndexed)
+                {
+                    if (node->getTagSymbol() >= part.tags.size())
+                        part.tags.resize(node->getTagSymbol() + 1);
+                    part.tags[node->getTagSymbol()].push_back(node->getUID());
+                }
+                if (const std::string_view *id = node->findAttribute(idAttribute))
+                    if (!id->empty())
+                        part.ids.push_back(id_entry_t{hashId(*id), node->getUID()});
+                if (const std::string_view *list = node->findAttribute(classAttribute))
+                    forEachToken(*list, [&](std::string_view token)
+                                 {
+                                     list_t &uids = part.classes[token];
+                                     if (uids.empty() || uids.back() != node->getUID()) // repeated in the list
+                                         uids.push_back(node->getUID());
+                                 });
+            }
+        }
+
+        /**
+         *  @brief  Appends the lists of the part to the index.
+         * */
+        void merge(part_t &part)
+        {
+            if (part.tags.size() > tags.size())
+                tags.resize(part.tags.size());
+            for (std::size_t tag = 0; tag < part.tags.size(); ++tag)
+            {
+                tags[tag].insert(tags[tag].end(), part.tags[tag].begin(), part.tags[tag].end());
+                entries += part.tags[tag].size();
+            }
+            reserveIds(part.ids.size());
+            for (const id_entry_t &id : part.ids)
+                insertId(id);
+            entries += part.ids.size();
+            for (auto &token : part.classes)
+            {
+                list_t &uids = classes[token.first].uids;
+                uids.insert(uids.end(), token.second.begin(), token.second.end());
+                entries += token.second.size();
+            }
+        }
+
+    public:
+        /**
+         *  @brief  Checks if the token list holds the token, tokens are
+         *          separated by ASCII whitespace.
+         * */
+        static bool containsToken(std::string_view list, std::string_view token)
+        {
+            bool found = false;
+            forEachToken(list, [&](std::string_view t) { found = found || t == token; });
+            return found;
+        }
+
+        /**
+         *  @brief  Constructor of an index to be built by build().
+         *  @param  arena           arena of the tree, the index observes the
+         *                          attributes set on the nodes of the tree
+         *  @param  nodes           slots of the nodes of the tree
+         *  @param  tagsIndexed     index the nodes by tag name
+         *  @param  idAttribute     name of the id attribute, NO_SYMBOL for
+         *                          no index of ids
+         *  @param  classAttribute  name of the token list attribute,
+         *                          NO_SYMBOL for no index of tokens
+         * */
+        DOMindex(DOMarena &arena, DOMnodeTable *nodes, bool tagsIndexed, DOMsymbol idAttribute,
+                 DOMsymbol classAttribute)
+            : observerSlot(arena.shareObserverSlot()), nodes(nodes), tagsIndexed(tagsIndexed),
+              idAttribute(idAttribute), classAttribute(classAttribute)
+        {
+            observerSlot->add(this);
+        }
+
+        DOMindex(const DOMindex &) = delete;
+        DOMindex &operator=(const DOMindex &) = delete;
+
+        ~DOMindex()
+        {
+            observerSlot->remove(this);
+        }
+
+        /**
+         *  @brief  Marks the index stale, to be rebuilt by the next lookup.
+         *  @param  table   slots of the nodes of the tree, which may have
+         *                  been replaced
+         * */
+        void invalidate(DOMnodeTable *table)
+        {
+            nodes = table;
+            stale = true;
+            tags.clear();
+            ids.clear();
+            usedIds = 0;
+            classes.clear();
+            pendingIds.clear();
+            pendingClasses.clear();
+            entries = garbage = 0;
+        }
+
+        /**
+         *  @brief  Rebuilds the index from all the nodes of the tree. Big
+         *          trees are scanned by several threads, each taking a range
+         *          of slots, and the lists are merged in slot order.
+         *  @param  threads     maximum number of threads to use
+         * */
+        void build(unsigned threads)
+        {
+            invalidate(nodes);
+            std::uint64_t size = nodes->size();
+            std::size_t ranges = parallelRanges(threads, size, BUILD_GRAIN);
+            std::vector<part_t> parts(ranges);
+            parallelSlices(ranges, size, [&](std::size_t r, std::uint64_t lo, std::uint64_t hi)
+                           { scan(lo, hi, parts[r]); });
+            for (auto &part : parts)
+                merge(part);
+            stale = false;
+        }
+
+        /**
+         *  @brief  Checks if the index has to be rebuilt before lookups.
+         * */
+        inline bool isStale() const
+        {
+            return stale;
+        }
+
+        /**
+         *  @brief  Adds a new node of the tree, which has no attributes yet.
+         * */
+        inline void nodeAdded(const DOMnode &node)
+        {
+            if (stale || !tagsIndexed || node.isInnerDataNode())
+                return;
+            if (node.getTagSymbol() >= tags.size())
+                tags.resize(node.getTagSymbol() + 1);
+            tags[node.getTagSymbol()].push_back(node.getUID());
+            ++entries;
+        }
+
+        /**
+         *  @brief  Adds new nodes of the tree, whose attributes were already
+         *          passed to attributeChanged().
+         * */
+        void nodesAdded(const std::vector<DOMnode *> &added)
+        {
+            if (stale || !tagsIndexed)
+                return;
+            for (const DOMnode *node : added)
+                nodeAdded(*node);
+        }
+
+        /**
+         *  @brief  Counts the nodes deleted from the tree, their entries
+         *          turned stale.
+         * */
+        inline void nodesDeleted(std::size_t n)
+        {
+            if (!stale)
+                collect(n);
+        }
+
+        void attributeChanged(DOMnode &node, DOMsymbol name, std::string_view previous,
+                              std::string_view value) override
+        {
+            if (stale || previous == value || (name != idAttribute && name != classAttribute))
+                return;
+            if (name == idAttribute)
+            {
+                if (!value.empty())
+                    enqueue(pendingIds, node.getUID());
+                if (!previous.empty())
+                    collect(1);
+            }
+            else
+            {
+                if (!value.empty())
+                    enqueue(pendingClasses, node.getUID());
+                // a kept token is added again by the next lookup
+                std::size_t lost = 0;
+                forEachToken(previous, [&](std::string_view token)
+                             {
+                                 auto i = classes.find(token);
+                                 if (i == classes.end())
+                                     return;
+                                 if (containsToken(value, token))
+                                     i->second.repeated = true;
+                                 else
+                                 {
+                                     i->second.lost = true;
+                                     ++lost;
+                                 }
+                             });
+                collect(lost);
+            }
+        }
+
+        /**
+         *  @brief  Checks if nodes are indexed by tag name.
+         * */
+        inline bool hasTags() const
+        {
+            return tagsIndexed;
+        }
+
+        /**
+         *  @brief  Returns the name of the indexed id attribute, NO_SYMBOL
+         *          if ids are not indexed.
+         * */
+        inline DOMsymbol getIdAttribute() const
+        {
+            return idAttribute;
+        }
+
+        /**
+         *  @brief  Returns the name of the indexed token list attribute,
+         *          NO_SYMBOL if tokens are not indexed.
+         * */
+        inline DOMsymbol getClassAttribute() const
+        {
+            return classAttribute;
+        }
+
+        /**
+         *  @brief  Appends the UIDs of the nodes with the tag to the vector,
+         *          in O(k). The index must not be stale.
+         * */
+        void findTag(DOMsymbol tag, std::vector<DOMnodeUID> &found)
+        {
+            if (tag >= tags.size())
+                return;
+            filter(tags[tag], [&](DOMnodeUID uid) { return validTag(uid, tag); });
+            found.insert(found.end(), tags[tag].begin(), tags[tag].end());
+        }
+
+        /**
+         *  @brief  Returns UID of the node with the id, any of them if there
+         *          are many, -1 if there is none. The index must not be stale.
+         * */
+        DOMnodeUID findId(std::string_view id)
+        {
+            update();
+            if (ids.empty())
+                return -1;
+            std::size_t hash = hashId(id);
+            std::size_t mask = ids.size() - 1;
+            for (std::size_t i = hash & mask; ids[i].uid != FREE_ID; i = (i + 1) & mask)
+            {
+                if (ids[i].hash != hash || ids[i].uid == DROPPED_ID)
+                    continue;
+                if (validId(ids[i].uid, id))
+                    return ids[i].uid;
+                ids[i].uid = DROPPED_ID;
+                --entries;
+            }
+            return -1;
+        }
+
+        /**
+         *  @brief  Appends the UIDs of the nodes whose token list holds the
+         *          token to the vector, in O(k). The index must not be stale.
+         * */
+        void findClass(std::string_view token, std::vector<DOMnodeUID> &found)
+        {
+            update();
+            auto i = classes.find(token);
+            if (i == classes.end())
+                return;
+            filterClass(i->second, token);
+            found.insert(found.end(), i->second.uids.begin(), i->second.uids.end());
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
@@ -15,50 +15,225 @@
 #ifndef DOM_PARSER_DOM_NODE
 #define DOM_PARSER_DOM_NODE
 
-#include <list>
+#include <cstdint>
+#include <iterator>
 #include <map>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
 
+#include "DOMarena.hpp"
+#include "DOMattributes.hpp"
 #include "DOMnodeUID.hpp"
+#include "DOMnumbers.hpp"
 
 namespace dom_parser
 {
+    class DOMnode;
+
+    /**
+     *  @brief  Iterable view over the children of a node which yields UIDs
+     *          of the children in order. Walks the sibling links of the nodes.
+     * */
+    class DOMchildRange
+    {
+    private:
+        DOMnode *first;
+        std::uint32_t count;
+
+    public:
+        class iterator
+        {
+        private:
+            DOMnode *node;
+
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef DOMnodeUID value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const DOMnodeUID *pointer;
+            typedef DOMnodeUID reference;
+
+            explicit iterator(DOMnode *node) : node(node) {}
+
+            inline DOMnodeUID operator*() const;
+            inline iterator &operator++();
+            inline iterator operator++(int)
+            {
+                iterator old = *this;
+                ++(*this);
+                return old;
+            }
+            inline bool operator==(const iterator &other) const
+            {
+                return node == other.node;
+            }
+            inline bool operator!=(const iterator &other) const
+            {
+                return node != other.node;
+            }
+        };
+
+        DOMchildRange(DOMnode *first, std::uint32_t count) : first(first), count(count) {}
+
+        inline iterator begin() const
+        {
+            return iterator(first);
+        }
+        inline iterator end() const
+        {
+            return iterator(nullptr);
+        }
+        inline bool empty() const
+        {
+            return count == 0;
+        }
+        inline std::uint32_t size() const
+        {
+            return count;
+        }
+    };
+
     /// @brief   Node in the DOM tree.
     class DOMnode
     {
+        friend class DOMchildRange::iterator;
+
     private:
         DOMnodeUID uid;
         DOMnodeUID parent;
-        std::list<DOMnodeUID> children;
-        std::map<std::string, std::string> tagAttributes;
-        std::string tagName;
+        DOMarena *arena;
+
+        // intrusive links, children form a doubly linked list through
+        // the sibling pointers so that linking and unlinking is O(1)
+        DOMnode *firstChild = nullptr;
+        DOMnode *lastChild = nullptr;
+        DOMnode *prevSibling = nullptr;
+        DOMnode *nextSibling = nullptr;
+        std::uint32_t childCount = 0;
+
+        // pre/post-order interval labels, maintained by the tree when enabled
+        std::uint64_t preLabel = 0;
+        std::uint64_t postLabel = 0;
+
+        DOMattributes tagAttributes;
+        DOMsymbol tagName;
 
         // if innerData node
         bool innerDataNode = false;
-        std::string innerData;
+        std::string_view innerData; // stored in the arena
 
     public:
         /**
          * @brief   Constructor for DOMnode
-         * @param   tagName     Name of the tag of the node.
+         * @param   tagName     Interned name of the tag of the node.
          * @param   uid         UID of this node.
+         * @param   parent      UID of the parent
+         * @param   arena       arena of the tree the node belongs to.
          */
-        DOMnode(std::string tagName, DOMnodeUID uid, DOMnodeUID parent)
-            : tagName(tagName), uid(uid), parent(parent){};
+        DOMnode(DOMsymbol tagName, DOMnodeUID uid, DOMnodeUID parent, DOMarena *arena)
+            : uid(uid), parent(parent), arena(arena), tagName(tagName){};
 
         /**
          * @brief   Constructor for DOMnode specially for storing inner-data
          * @param   uid         UID of this node
          * @param   parent      UID of the parent
          * @param   innerData   inner text data stored by the node
+         * @param   arena       arena of the tree the node belongs to.
          * */
-        DOMnode(DOMnodeUID uid, DOMnodeUID parent, std::string innerData)
-            : uid(uid), parent(parent), innerData(innerData), innerDataNode(true){};
+        DOMnode(DOMnodeUID uid, DOMnodeUID parent, std::string_view innerData, DOMarena *arena)
+            : uid(uid), parent(parent), arena(arena), tagName(DOMsymbolTable::NO_SYMBOL),
+              innerDataNode(true), innerData(arena->storeString(innerData)){};
+
+        /**
+         * @brief   Constructor for a copy of a node of another tree, used when
+         *          cloning trees. Data of the node (inner-data and values of the
+         *          attributes) is shared with the original node, links to
+         *          other nodes are not copied.
+         * @param   node    the original node
+         * @param   arena   arena of the tree the copy belongs to, it must use
+         *                  the same symbol table as the tree of the original
+         * */
+        DOMnode(const DOMnode &node, DOMarena *arena)
+            : uid(node.uid), parent(node.parent), arena(arena),
+              preLabel(node.preLabel), postLabel(node.postLabel),
+              tagName(node.tagName), innerDataNode(node.innerDataNode), innerData(node.innerData)
+        {
+            tagAttributes.copyFrom(node.tagAttributes, *arena);
+        }
+
+        /**
+         * @brief   Constructor for a relocated copy of a node, used when
+         *          compacting trees. Data of the node is copied to the arena,
+         *          links to other nodes are not copied.
+         * @param   node    the original node
+         * @param   uid     new UID of the node
+         * @param   parent  new UID of the parent
+         * @param   arena   arena the node and its data are moved to, it must
+         *                  use the same symbol table as the original
+         * */
+        DOMnode(const DOMnode &node, DOMnodeUID uid, DOMnodeUID parent, DOMarena *arena)
+            : uid(uid), parent(parent), arena(arena),
+              preLabel(node.preLabel), postLabel(node.postLabel),
+              tagName(node.tagName), innerDataNode(node.innerDataNode),
+              innerData(arena->storeString(node.innerData))
+        {
+            for (std::uint32_t i = 0; i < node.tagAttributes.size(); ++i)
+                tagAttributes.set(node.tagAttributes.keyAt(i),
+                                  arena->storeString(node.tagAttributes.valueAt(i)), *arena);
+        }
+
+        /**
+         * @brief   Constructor for a copy of a node placed elsewhere, used when
+         *          copying subtrees within a tree or between trees. Links to
+         *          other nodes are not copied.
+         * @param   node    the original node
+         * @param   uid     UID of the copy
+         * @param   parent  UID of the parent of the copy
+         * @param   arena   arena of the tree the copy belongs to
+         * @param   names   interned names of the tree of the copy, indexed by
+         *                  the interned names of the original, nullptr if both
+         *                  trees use the same symbol table
+         * @param   copyData    copy the data of the node to the arena instead
+         *                      of sharing it with the original
+         * */
+        DOMnode(const DOMnode &node, DOMnodeUID uid, DOMnodeUID parent, DOMarena *arena,
+                const DOMsymbol *names, bool copyData)
+            : uid(uid), parent(parent), arena(arena),
+              tagName(names && !node.innerDataNode ? names[node.tagName] : node.tagName),
+              innerDataNode(node.innerDataNode),
+              innerData(copyData ? arena->storeString(node.innerData) : node.innerData)
+        {
+            for (std::uint32_t i = 0; i < node.tagAttributes.size(); ++i)
+            {
+                DOMsymbol key = node.tagAttributes.keyAt(i);
+                std::string_view value = node.tagAttributes.valueAt(i);
+                tagAttributes.set((names ? names[key] : key), (copyData ? arena->storeString(value) : value),
+                                  *arena);
+            }
+        }
+
+        // see the note at the end of the class
+        DOMnode(const DOMnode &) = delete;
+        DOMnode &operator=(const DOMnode &) = delete;
 
         /**
-         * @brief   Returns the tagName of the node.
+         * @brief   Returns the tagName of the node. The name is stored once
+         *          in the symbol table of the tree and shared by all nodes
+         *          with the same tag. Returns empty string for inner-data nodes.
          */
-        inline std::string getTagName()
+        inline const std::string &getTagName() const
+        {
+            static const std::string noName;
+            return (innerDataNode ? noName : arena->getSymbols().name(tagName));
+        }
+
+        /**
+         * @brief   Returns the interned id of the tagName of the node, nodes
+         *          with same tag have equal ids. NO_SYMBOL for inner-data nodes.
+         */
+        inline DOMsymbol getTagSymbol() const
         {
             return tagName;
         }
@@ -66,7 +241,7 @@ namespace dom_parser
         /**
          * @brief   Returns the UID of the node.
          */
-        inline DOMnodeUID getUID()
+        inline DOMnodeUID getUID() const
         {
             return uid;
         }
@@ -77,33 +252,53 @@ namespace dom_parser
          * @param   attribute   Name of the attribute
          * @param   value       Data of the attribute
          */
-        inline void setAttribute(std::string attribute, std::string value)
+        inline void setAttribute(std::string_view attribute, std::string_view value)
         {
             if (innerDataNode)
                 return;
-            tagAttributes[attribute] = value;
+            setAttribute(arena->getSymbols().intern(attribute), value);
         }
 
         /**
-         * @brief   Sets attributes from the std::map provided
-         *          which has pairs like {attribute, value}.
-         *          Previous attributes will be cleared.
-         * @param   attributes  attributes to be set
+         * @brief   Sets a new value to existing attribute or
+         *          adds new attribute with the given value.
+         * @param   attribute   Interned name of the attribute
+         * @param   value       Data of the attribute
          */
-        inline void setAttributes(const std::map<std::string, std::string> &attributes)
+        inline void setAttribute(DOMsymbol attribute, std::string_view value)
         {
-            tagAttributes = attributes;
+            if (innerDataNode)
+                return;
+            std::string_view stored = arena->storeString(value);
+            DOMattributeObserver *observer = arena->getObserver();
+            if (!observer)
+            {
+                tagAttributes.set(attribute, stored, *arena);
+                return;
+            }
+            const std::string_view *previous = tagAttributes.find(attribute);
+            std::string_view old = (previous ? *previous : std::string_view());
+            tagAttributes.set(attribute, stored, *arena);
+            observer->attributeChanged(*this, attribute, old, stored);
         }
 
         /**
-         * @brief   Sets attributes from the rvalue std::map provided
+         * @brief   Sets attributes from the std::map provided
          *          which has pairs like {attribute, value}.
          *          Previous attributes will be cleared.
          * @param   attributes  attributes to be set
          */
-        inline void setAttributes(std::map<std::string, std::string> &&attributes)
+        inline void setAttributes(const std::map<std::string, std::string> &attributes)
         {
-            tagAttributes.swap(attributes);
+            if (innerDataNode)
+                return;
+            if (DOMattributeObserver *observer = arena->getObserver())
+                for (std::uint32_t i = 0; i < tagAttributes.size(); ++i)
+                    observer->attributeChanged(*this, tagAttributes.keyAt(i), tagAttributes.valueAt(i),
+                                               std::string_view());
+            tagAttributes.clear();
+            for (const auto &attribute : attributes)
+                setAttribute(attribute.first, attribute.second);
         }
 
         /**
@@ -111,54 +306,207 @@ namespace dom_parser
          *          empty string if the attribute does not exist.
          * @param   attribute   Name of the attribute
          */
-        inline std::string getAttribute(std::string attribute)
+        inline std::string getAttribute(std::string_view attribute) const
+        {
+            const std::string_view *value = tagAttributes.find(arena->getSymbols().find(attribute));
+            return (value ? std::string(*value) : std::string());
+        }
+
+        /**
+         * @brief   Returns pointer to the value of the attribute with the
+         *          given interned name, nullptr if it does not exist.
+         * @param   attribute   Interned name of the attribute
+         */
+        inline const std::string_view *findAttribute(DOMsymbol attribute) const
+        {
+            return tagAttributes.find(attribute);
+        }
+
+        /**
+         * @brief   Checks if the node has the said attribute.
+         * @param   attribute   Name of the attribute
+         */
+        inline bool hasAttribute(std::string_view attribute) const
+        {
+            return tagAttributes.find(arena->getSymbols().find(attribute)) != nullptr;
+        }
+
+        /**
+         * @brief   Removes the said attribute if it exists.
+         * @param   attribute   Name of the attribute
+         */
+        inline void removeAttribute(std::string_view attribute)
+        {
+            removeAttribute(arena->getSymbols().find(attribute));
+        }
+
+        /**
+         * @brief   Removes the attribute if it exists.
+         * @param   attribute   Interned name of the attribute
+         */
+        inline void removeAttribute(DOMsymbol attribute)
         {
-            return tagAttributes.find(attribute)->second;
+            DOMattributeObserver *observer = arena->getObserver();
+            const std::string_view *previous = (observer ? tagAttributes.find(attribute) : nullptr);
+            if (!previous)
+            {
+                tagAttributes.remove(attribute);
+                return;
+            }
+            std::string_view old = *previous;
+            tagAttributes.remove(attribute);
+            observer->attributeChanged(*this, attribute, old, std::string_view());
         }
 
         /**
-         * @brief   Returns reference to the the ordered map of all the attributes
-         *          with their values.
+         * @brief   Returns a view of all the attributes which yields pairs
+         *          of {attribute, value} in the order they were set.
          * */
-        inline const std::map<std::string, std::string> &getAllAttributes()
+        inline DOMattributeRange getAllAttributes() const
+        {
+            return DOMattributeRange(tagAttributes, arena->getSymbols());
+        }
+
+        /**
+         * @brief   Returns value of the said attribute parsed as a number of
+         *          type T (see parseNumber()), such as std::int64_t or double.
+         *          Returns nothing if the attribute does not exist or is not
+         *          such a number.
+         * @param   attribute   Name of the attribute
+         */
+        template <class T>
+        inline std::optional<T> getAttributeAs(std::string_view attribute) const
+        {
+            return getAttributeAs<T>(arena->getSymbols().find(attribute));
+        }
+
+        /**
+         * @brief   Returns value of the attribute with the given interned
+         *          name parsed as a number of type T, nothing if the attribute
+         *          does not exist or is not such a number.
+         * @param   attribute   Interned name of the attribute
+         */
+        template <class T>
+        inline std::optional<T> getAttributeAs(DOMsymbol attribute) const
+        {
+            T value;
+            const std::string_view *text = tagAttributes.find(attribute);
+            if (!text || !parseNumber(*text, value))
+                return std::nullopt;
+            return value;
+        }
+
+        /**
+         * @brief   Returns value of the said attribute parsed as a number
+         *          with a unit, such as "10dp". Returns nothing if the
+         *          attribute does not exist or is not such a dimension.
+         * @param   attribute   Name of the attribute
+         */
+        inline std::optional<DOMdimension> getAttributeDimension(std::string_view attribute) const
+        {
+            DOMdimension dimension;
+            const std::string_view *text = tagAttributes.find(arena->getSymbols().find(attribute));
+            if (!text || !parseDimension(*text, dimension))
+                return std::nullopt;
+            return dimension;
+        }
+
+        /**
+         * @brief   Returns iterable view of UIDs of the children of the node.
+         */
+        inline DOMchildRange getChildrenUID() const
+        {
+            return DOMchildRange(firstChild, childCount);
+        }
+
+        /**
+         * @brief   Returns number of children of the node.
+         */
+        inline std::uint32_t getChildCount() const
+        {
+            return childCount;
+        }
+
+        /**
+         * @brief   Returns UID of the first child, -1 if there are no children.
+         */
+        inline DOMnodeUID getFirstChild() const
+        {
+            return (firstChild ? firstChild->uid : -1);
+        }
+
+        /**
+         * @brief   Returns UID of the last child, -1 if there are no children.
+         */
+        inline DOMnodeUID getLastChild() const
+        {
+            return (lastChild ? lastChild->uid : -1);
+        }
+
+        /**
+         * @brief   Returns UID of the next sibling, -1 if it is the last child.
+         */
+        inline DOMnodeUID getNextSibling() const
         {
-            return tagAttributes;
+            return (nextSibling ? nextSibling->uid : -1);
         }
 
         /**
-         * @brief   Returns reference to the list of children of the node.
+         * @brief   Returns UID of the previous sibling, -1 if it is the first child.
          */
-        inline const std::list<DOMnodeUID> &getChildrenUID()
+        inline DOMnodeUID getPrevSibling() const
         {
-            return children;
+            return (prevSibling ? prevSibling->uid : -1);
         }
 
         /**
-         * @brief   Adds a new child to the node.
-         * @param   child    Child node.
+         * @brief   Links a node as child of this node in O(1). Does not update
+         *          the parent UID of the child, that is the job of the tree.
+         * @param   child       Child node, must not be linked anywhere.
+         * @param   reference   Child of this node before which the new child is
+         *                      inserted, nullptr to append at the end.
          */
-        inline void addChild(DOMnodeUID child)
+        void linkChild(DOMnode &child, DOMnode *reference = nullptr)
         {
             if (innerDataNode)
                 return;
-            children.push_back(child);
+            child.nextSibling = reference;
+            child.prevSibling = (reference ? reference->prevSibling : lastChild);
+            if (child.prevSibling)
+                child.prevSibling->nextSibling = &child;
+            else
+                firstChild = &child;
+            if (reference)
+                reference->prevSibling = &child;
+            else
+                lastChild = &child;
+            ++childCount;
         }
 
         /**
-         * @brief   Removes the child node with the given UID.
-         * @param   uid     UID of the child node to remove.
+         * @brief   Unlinks a child node from this node in O(1).
+         * @param   child    Child node, must be linked to this node.
          */
-        void removeChild(DOMnodeUID uid)
+        void unlinkChild(DOMnode &child)
         {
             if (innerDataNode)
                 return;
-            children.remove(uid);
+            if (child.prevSibling)
+                child.prevSibling->nextSibling = child.nextSibling;
+            else
+                firstChild = child.nextSibling;
+            if (child.nextSibling)
+                child.nextSibling->prevSibling = child.prevSibling;
+            else
+                lastChild = child.prevSibling;
+            child.prevSibling = child.nextSibling = nullptr;
+            --childCount;
         }
 
         /**
          * @brief   Returns the parent node UID.
          */
-        inline DOMnodeUID getParent()
+        inline DOMnodeUID getParent() const
         {
             return parent;
         }
@@ -172,25 +520,110 @@ namespace dom_parser
             parent = new_parent_UID;
         }
 
+        /**
+         * @brief   Returns pre-order interval label of the node. Labels are
+         *          meaningful only when enabled in the tree.
+         * */
+        inline std::uint64_t getPreLabel() const
+        {
+            return preLabel;
+        }
+
+        /**
+         * @brief   Returns post-order interval label of the node. Labels are
+         *          meaningful only when enabled in the tree.
+         * */
+        inline std::uint64_t getPostLabel() const
+        {
+            return postLabel;
+        }
+
+        /**
+         * @brief   Sets the interval labels of the node.
+         * @param   pre     label given on entering the node in depth-first order
+         * @param   post    label given on leaving the node in depth-first order
+         * */
+        inline void setLabels(std::uint64_t pre, std::uint64_t post)
+        {
+            preLabel = pre;
+            postLabel = post;
+        }
+
         /**
          * @brief   Checks if node is inner-data node
          * */
-        inline bool isInnerDataNode()
+        inline bool isInnerDataNode() const
         {
             return innerDataNode;
         }
 
         /**
-         * @brief   Returns reference to inner-data if the node stores inner data.
+         * @brief   Returns view of inner-data if the node stores inner data.
          *          Returns empty string if node does not store inner-data.
+         *          The data lives as long as the tree.
          * */
-        inline const std::string &getInnerData()
+        inline std::string_view getInnerData() const
         {
             return innerData;
         }
 
         /**
-         *    Operator overload for =operator removed.
+         * @brief   Returns the inner-data node holding the text of the node:
+         *          the node itself, or the first child of an element if that
+         *          child is an inner-data node (as for <P_SIZE>7</P_SIZE>),
+         *          nullptr otherwise.
+         * */
+        inline const DOMnode *getTextNode() const
+        {
+            if (innerDataNode)
+                return this;
+            return (firstChild && firstChild->innerDataNode ? firstChild : nullptr);
+        }
+
+        /**
+         * @brief   Returns the inner-data of the text node (see getTextNode())
+         *          parsed as a number of type T, nothing if there is no text
+         *          or it is not such a number.
+         * */
+        template <class T>
+        inline std::optional<T> getInnerDataAs() const
+        {
+            T value;
+            const DOMnode *text = getTextNode();
+            if (!text || !parseNumber(text->innerData, value))
+                return std::nullopt;
+            return value;
+        }
+
+        /**
+         * @brief   Replaces the inner-data of the node, does nothing if the
+         *          node is not an inner-data node.
+         * @param   data    new inner-data, copied into the arena of the node
+         * */
+        inline void setInnerData(std::string_view data)
+        {
+            setInnerData(data, *arena);
+        }
+
+        /**
+         * @brief   Replaces the inner-data of the node, storing it in another
+         *          arena of the same tree (see DOMtree::createArena()), so that
+         *          threads can replace the data of different nodes at once.
+         * @param   data    new inner-data
+         * @param   storage arena the data is copied into
+         * */
+        inline void setInnerData(std::string_view data, DOMarena &storage)
+        {
+            if (!innerDataNode)
+                return;
+            std::string_view previous = innerData;
+            innerData = storage.storeString(data);
+            if (DOMattributeObserver *observer = arena->getObserver())
+                observer->innerDataChanged(*this, previous, innerData);
+        }
+
+        /**
+         *    Copy constructor and operator overload for =operator removed.
          *    Reason:
          *      A situation may arise when the user would need to copy one
          *      node to another. This would create the following problems:
@@ -212,10 +645,22 @@ namespace dom_parser
          *          inconsistent connections which point to the children 
          *          nodes but children nodes do not point back.
          *    Considering the above reasons, =operator overload is removed from
-         *    DOMnode.
+         *    DOMnode. To copy nodes, whole trees are copied with DOMtree::clone(),
+         *    subtrees with DOMtree::cloneSubtree() and DOMtree::graft().
          */
     };
 
+    inline DOMnodeUID DOMchildRange::iterator::operator*() const
+    {
+        return node->getUID();
+    }
+
+    inline DOMchildRange::iterator &DOMchildRange::iterator::operator++()
+    {
+        node = node->nextSibling;
+        return *this;
+    }
+
 }; // namespace dom_parser
 
 #endif
@@ -0,0 +1,391 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_NODE_TABLE
+#define DOM_PARSER_DOM_NODE_TABLE
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "DOMnodeUID.hpp"
+
+namespace dom_parser
+{
+    class DOMnode;
+
+    /**
+     *  @brief  Table of the slots holding nodes of a tree, indexed by the
+     *          slot part of the UIDs. The slots are kept in chunks of growing
+     *          size which are never moved or freed while the table lives, so
+     *          a slot can be read and written by many threads while others
+     *          grow the table.
+     *
+     *          Slots are handed out from a high-water mark, vacant slots of the
+     *          deleted nodes are kept in a lock-free (Treiber) stack threaded
+     *          through the slots. Slots which hold no node point to the vacant
+     *          placeholder node given on construction. Every slot counts its
+     *          generation, bumped when its node is released.
+     *
+     *          A released slot keeps the memory of its dead node, which is
+     *          recycled for the next node stored in the slot.
+     * */
+    class DOMnodeTable
+    {
+    private:
+        // chunk k holds FIRST_CHUNK << k slots
+        static constexpr std::uint32_t FIRST_CHUNK = 1024;
+        static constexpr int FIRST_CHUNK_LOG = 10;
+        static constexpr int MAX_CHUNKS = DOM_UID_SLOT_BITS - FIRST_CHUNK_LOG;
+        static constexpr int STRIPES = 64;
+
+        struct slot_t
+        {
+            std::atomic<DOMnode *> node;
+            std::atomic<std::uint32_t> generation;
+            std::atomic<std::uint64_t> nextVacant;
+            std::atomic<DOMnode *> recycled;
+        };
+
+        std::atomic<slot_t *> chunks[MAX_CHUNKS];
+        DOMnode *vacant;
+
+        std::atomic<std::uint64_t> highWater{0};
+        std::atomic<std::int64_t> live{0};
+
+        // top of the vacant slots stack, low bits are slot + 1 (0 for empty),
+        // high bits are a tag bumped on every change against ABA
+        std::atomic<std::uint64_t> vacantTop{0};
+
+        static constexpr std::uint64_t SLOT_MASK = (std::uint64_t(1) << DOM_UID_SLOT_BITS) - 1;
+
+        // next vacant slot of the retired slots, which are never reused
+        static constexpr std::uint64_t RETIRED = ~std::uint64_t(0);
+        std::atomic<std::uint64_t> retiredCount{0};
+
+        std::mutex stripes[STRIPES];
+
+        /**
+         *  @brief  Finds chunk and offset in the chunk of the slot.
+         * */
+        static inline void locate(std::uint64_t index, int &chunk, std::uint64_t &offset)
+        {
+            std::uint64_t i = index + FIRST_CHUNK;
+            chunk = 63 - __builtin_clzll(i) - FIRST_CHUNK_LOG;
+            offset = i - (std::uint64_t(FIRST_CHUNK) << chunk);
+        }
+
+        /**
+         *  @brief  Returns the slot, the chunk holding it must exist.
+         * */
+        inline slot_t &slot(std::uint64_t index) const
+        {
+            int chunk;
+            std::uint64_t offset;
+            locate(index, chunk, offset);
+            return chunks[chunk].load(std::memory_order_acquire)[offset];
+        }
+
+        /**
+         *  @brief  Allocates the chunks holding slots up to last, if missing.
+         * */
+        void grow(std::uint64_t last)
+        {
+            int lastChunk;
+            std::uint64_t offset;
+            locate(last, lastChunk, offset);
+            for (int chunk = lastChunk; chunk >= 0; --chunk)
+            {
+                if (chunks[chunk].load(std::memory_order_acquire))
+                    break; // chunks are allocated in order
+
+                std::uint64_t size = std::uint64_t(FIRST_CHUNK) << chunk;
+                slot_t *fresh = new slot_t[size];
+                for (std::uint64_t i = 0; i < size; ++i)
+                {
+                    fresh[i].node.store(vacant, std::memory_order_relaxed);
+                    fresh[i].generation.store(0, std::memory_order_relaxed);
+                    fresh[i].nextVacant.store(0, std::memory_order_relaxed);
+                    fresh[i].recycled.store(nullptr, std::memory_order_relaxed);
+                }
+                slot_t *expected = nullptr;
+                if (!chunks[chunk].compare_exchange_strong(expected, fresh, std::memory_order_acq_rel))
+                    delete[] fresh; // other thread was faster
+            }
+        }
+
+        /**
+         *  @brief  Pushes a chain of vacant slots on the free stack at once.
+         * */
+        void pushChain(std::uint64_t first, std::uint64_t last)
+        {
+            slot_t &tail = slot(last - 1);
+            std::uint64_t top = vacantTop.load(std::memory_order_relaxed);
+            do
+            {
+                tail.nextVacant.store(top & SLOT_MASK, std::memory_order_relaxed);
+            } while (!vacantTop.compare_exchange_weak(
+                top, (top & ~SLOT_MASK) + (SLOT_MASK + 1) + first, std::memory_order_release,
+                std::memory_order_relaxed));
+        }
+
+    public:
+        /// @brief   Last generation of a slot, see bury().
+        static constexpr std::uint32_t MAX_GENERATION = (std::uint32_t(1) << DOM_UID_GENERATION_BITS) - 1;
+
+        /// @brief   Returned by popVacant() when there is no vacant slot.
+        static constexpr std::uint64_t NO_SLOT = ~std::uint64_t(0);
+
+        /**
+         *  @brief  Vacant slots collected by one thread, to be handed back to
+         *          the table in one step by releaseChain().
+         * */
+        struct vacant_chain_t
+        {
+            std::uint64_t first = 0; // slot + 1, 0 for none
+            std::uint64_t last = 0;
+            std::int64_t count = 0; // buried nodes, retired slots included
+        };
+
+        /**
+         *  @brief  Constructor
+         *  @param  vacant  placeholder node stored in the slots without node
+         * */
+        explicit DOMnodeTable(DOMnode *vacant) : vacant(vacant)
+        {
+            for (auto &chunk : chunks)
+                chunk.store(nullptr, std::memory_order_relaxed);
+        }
+
+        DOMnodeTable(const DOMnodeTable &) = delete;
+        DOMnodeTable &operator=(const DOMnodeTable &) = delete;
+
+        ~DOMnodeTable()
+        {
+            for (auto &chunk : chunks)
+                delete[] chunk.load(std::memory_order_relaxed);
+        }
+
+        /**
+         *  @brief  Returns the node stored in the slot, the slot must be below
+         *          size().
+         * */
+        inline DOMnode *get(std::uint64_t index) const
+        {
+            return slot(index).node.load(std::memory_order_acquire);
+        }
+
+        /**
+         *  @brief  Stores the node in the slot, the slot must be below size().
+         * */
+        inline void set(std::uint64_t index, DOMnode *node)
+        {
+            slot(index).node.store(node, std::memory_order_release);
+        }
+
+        /**
+         *  @brief  Returns the generation of the slot, which is the generation
+         *          of the UID of its node, or of the next one if vacant.
+         * */
+        inline std::uint32_t getGeneration(std::uint64_t index) const
+        {
+            return slot(index).generation.load(std::memory_order_relaxed);
+        }
+
+        /**
+         *  @brief  Sets the generation of the slot.
+         * */
+        inline void setGeneration(std::uint64_t index, std::uint32_t generation)
+        {
+            slot(index).generation.store(generation, std::memory_order_relaxed);
+        }
+
+        /**
+         *  @brief  Marks the slot of a deleted node dead: the slot turns
+         *          vacant, its generation is bumped and the memory of the node
+         *          is kept for recycling. The slot is added to the chain, it
+         *          is not reused until the chain is released. A slot whose
+         *          generation is the last one is retired instead, never to be
+         *          reused, as a wrapped generation would make the handles of
+         *          its old nodes valid again. Does not allocate.
+         * */
+        inline void bury(std::uint64_t index, vacant_chain_t &chain)
+        {
+            slot_t &buried = slot(index);
+            std::uint32_t generation = buried.generation.load(std::memory_order_relaxed);
+            ++chain.count;
+            if (generation == MAX_GENERATION)
+            {
+                buried.node.store(vacant, std::memory_order_relaxed);
+                retire(index);
+                return;
+            }
+            buried.recycled.store(buried.node.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            buried.node.store(vacant, std::memory_order_relaxed);
+            buried.generation.store(generation + 1, std::memory_order_relaxed);
+            buried.nextVacant.store(chain.first, std::memory_order_relaxed);
+            chain.first = index + 1;
+            if (chain.last == 0)
+                chain.last = index + 1;
+        }
+
+        /**
+         *  @brief  Marks a vacant slot retired, it is never handed out again.
+         * */
+        inline void retire(std::uint64_t index)
+        {
+            slot(index).nextVacant.store(RETIRED, std::memory_order_relaxed);
+            retiredCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         *  @brief  Checks if the slot is retired (see bury()).
+         * */
+        inline bool isRetired(std::uint64_t index) const
+        {
+            return slot(index).nextVacant.load(std::memory_order_relaxed) == RETIRED;
+        }
+
+        /**
+         *  @brief  Hands the slots of the chain to the free stack with a
+         *          single atomic operation. Lock-free.
+         * */
+        inline void releaseChain(const vacant_chain_t &chain)
+        {
+            if (chain.count == 0)
+                return;
+            if (chain.first != 0) // all the slots may have been retired
+                pushChain(chain.first, chain.last);
+            live.fetch_sub(chain.count, std::memory_order_relaxed);
+        }
+
+        /**
+         *  @brief  Takes the memory of the dead node of the slot for reuse.
+         *  @return memory of a DOMnode, nullptr if there is none
+         * */
+        inline DOMnode *takeRecycled(std::uint64_t index)
+        {
+            return slot(index).recycled.exchange(nullptr, std::memory_order_relaxed);
+        }
+
+        /**
+         *  @brief  Returns the placeholder stored in the vacant slots.
+         * */
+        inline DOMnode *getVacant() const
+        {
+            return vacant;
+        }
+
+        /**
+         *  @brief  Returns number of slots handed out so far, all the slots
+         *          in use are below it.
+         * */
+        inline std::uint64_t size() const
+        {
+            return highWater.load(std::memory_order_acquire);
+        }
+
+        /**
+         *  @brief  Returns number of live nodes.
+         * */
+        inline std::int64_t count() const
+        {
+            return live.load(std::memory_order_relaxed);
+        }
+
+        /**
+         *  @brief  Adds to the number of live nodes.
+         * */
+        inline void addCount(std::int64_t n)
+        {
+            live.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        /**
+         *  @brief  Hands out a block of consecutive fresh slots.
+         *  @param  n   size of the block
+         *  @return first slot of the block
+         * */
+        std::uint64_t reserve(std::uint64_t n)
+        {
+            std::uint64_t first = highWater.fetch_add(n, std::memory_order_acq_rel);
+            grow(first + n - 1);
+            return first;
+        }
+
+        /**
+         *  @brief  Pushes a vacant slot on the free stack. Lock-free.
+         * */
+        inline void pushVacant(std::uint64_t index)
+        {
+            pushChain(index + 1, index + 1);
+        }
+
+        /**
+         *  @brief  Pops a vacant slot from the free stack. Lock-free.
+         *  @return the slot, NO_SLOT if there is none
+         * */
+        std::uint64_t popVacant()
+        {
+            std::uint64_t top = vacantTop.load(std::memory_order_acquire);
+            while ((top & SLOT_MASK) != 0)
+            {
+                std::uint64_t index = (top & SLOT_MASK) - 1;
+                std::uint64_t next = slot(index).nextVacant.load(std::memory_order_relaxed);
+                if (vacantTop.compare_exchange_weak(
+                        top, (top & ~SLOT_MASK) + (SLOT_MASK + 1) + next, std::memory_order_acquire,
+                        std::memory_order_acquire))
+                    return index;
+            }
+            return NO_SLOT;
+        }
+
+        /**
+         *  @brief  Forgets all the slots handed out but slot 0, which is
+         *          handed out again, and the retired slots. Every slot must
+         *          be vacant. Not thread-safe.
+         * */
+        inline void reset()
+        {
+            std::uint64_t size = highWater.load(std::memory_order_relaxed);
+            vacantTop.store(0, std::memory_order_relaxed);
+            if (size == 0)
+            {
+                reserve(1);
+                return;
+            }
+            if (retiredCount.load(std::memory_order_relaxed) == 0 || size <= 1)
+            {
+                highWater.store(1, std::memory_order_relaxed);
+                return;
+            }
+            // handing the slots out from 1 again would reuse the retired ones
+            for (std::uint64_t index = size; --index > 0;) // lowest slots are reused first
+                if (!isRetired(index))
+                    pushVacant(index);
+        }
+
+        /**
+         *  @brief  Returns the lock guarding the children links of the node.
+         *          Locks are striped, distinct nodes may share one.
+         * */
+        inline std::mutex &stripe(DOMnodeUID uid)
+        {
+            return stripes[uidSlot(uid) % STRIPES];
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
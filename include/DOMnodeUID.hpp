@@ -15,9 +15,49 @@
 #ifndef DOM_PARSER_DOM_NODE_UID
 #define DOM_PARSER_DOM_NODE_UID
 
+#include <cstdint>
+
 namespace dom_parser
 {
-    typedef int DOMnodeUID;
+    /**
+     *  @brief  Handle of a node. The low DOM_UID_SLOT_BITS bits hold the
+     *          index of the slot of the node in its tree, the bits above hold
+     *          the generation of the slot, which changes every time the slot
+     *          is reused. A handle of a deleted node thus never refers to a
+     *          node added later. -1 is never a valid handle, the root of a
+     *          tree is 0.
+     * */
+    typedef std::int64_t DOMnodeUID;
+
+    /// @brief   Number of bits of the slot index in a DOMnodeUID.
+    constexpr int DOM_UID_SLOT_BITS = 40;
+
+    /// @brief   Number of bits of the generation in a DOMnodeUID.
+    constexpr int DOM_UID_GENERATION_BITS = 23;
+
+    /**
+     *  @brief  Returns the slot index of the handle.
+     * */
+    inline constexpr std::uint64_t uidSlot(DOMnodeUID uid)
+    {
+        return std::uint64_t(uid) & ((std::uint64_t(1) << DOM_UID_SLOT_BITS) - 1);
+    }
+
+    /**
+     *  @brief  Returns the generation of the handle.
+     * */
+    inline constexpr std::uint32_t uidGeneration(DOMnodeUID uid)
+    {
+        return std::uint32_t(std::uint64_t(uid) >> DOM_UID_SLOT_BITS);
+    }
+
+    /**
+     *  @brief  Makes a handle of the slot index and generation.
+     * */
+    inline constexpr DOMnodeUID makeNodeUID(std::uint64_t slot, std::uint32_t generation)
+    {
+        return DOMnodeUID((std::uint64_t(generation) << DOM_UID_SLOT_BITS) | slot);
+    }
 } // namespace dom_parser
 
 #endif
@@ -0,0 +1,221 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_NUMBER_CACHE
+#define DOM_PARSER_DOM_NUMBER_CACHE
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "DOMarena.hpp"
+#include "DOMnode.hpp"
+#include "DOMnodeTable.hpp"
+#include "DOMnumbers.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Parsed values of the numbers of a tree, one per slot: the
+     *          last attribute or inner-data of the node parsed as an integer,
+     *          a real or a dimension, successfully or not. A lookup of the
+     *          same value again costs a comparison instead of a parse.
+     *
+     *          An entry is dropped when its attribute or inner-data changes;
+     *          entries of deleted nodes never match the UIDs of the nodes
+     *          reusing their slots. A cache which cannot follow the changes
+     *          of the tree (after compaction) is marked stale and emptied by
+     *          the next lookup. Lookups are not thread-safe: tree workers
+     *          mark the cache stale, which then ignores the changes they
+     *          make, and no lookup may run until they are done.
+     * */
+    class DOMnumberCache : public DOMattributeObserver
+    {
+    private:
+        enum kind_t : std::uint8_t
+        {
+            INTEGER,
+            REAL,
+            DIMENSION
+        };
+
+        struct entry_t
+        {
+            DOMnodeUID uid = -1;
+            DOMsymbol name; // NO_SYMBOL for the inner-data
+            kind_t kind;
+            bool valid;
+            std::int64_t integer;
+            DOMdimension real; // value and unit of reals and dimensions
+        };
+
+        std::shared_ptr<DOMobserverList> observerSlot;
+        DOMnodeTable *nodes;
+        std::vector<entry_t> entries; // by slot
+        bool stale = false;
+
+        /**
+         *  @brief  Returns the entry of the value, parsing it if the entry
+         *          of the slot holds another one.
+         *  @param  name    interned name of the attribute, NO_SYMBOL for the
+         *                  inner-data of the node
+         * */
+        const entry_t &lookup(const DOMnode &node, DOMsymbol name, kind_t kind)
+        {
+            if (stale)
+            {
+                entries.clear();
+                stale = false;
+            }
+            std::uint64_t slot = uidSlot(node.getUID());
+            if (slot >= entries.size())
+                entries.resize(std::max<std::uint64_t>(slot + 1, nodes->size()));
+            entry_t &entry = entries[slot];
+            if (entry.uid == node.getUID() && entry.name == name && entry.kind == kind)
+                return entry;
+
+            std::string_view text = node.getInnerData();
+            if (name != DOMsymbolTable::NO_SYMBOL)
+            {
+                const std::string_view *attribute = node.findAttribute(name);
+                text = (attribute ? *attribute : std::string_view()); // nothing parses from empty text
+            }
+            entry.uid = node.getUID();
+            entry.name = name;
+            entry.kind = kind;
+            if (kind == INTEGER)
+                entry.valid = parseNumber(text, entry.integer);
+            else if (kind == REAL)
+                entry.valid = parseNumber(text, entry.real.value);
+            else
+                entry.valid = parseDimension(text, entry.real);
+            return entry;
+        }
+
+        /**
+         *  @brief  Drops the entry of the node if it holds the value.
+         * */
+        inline void drop(const DOMnode &node, DOMsymbol name)
+        {
+            if (stale) // emptied by the next lookup anyway
+                return;
+            std::uint64_t slot = uidSlot(node.getUID());
+            if (slot < entries.size() && entries[slot].uid == node.getUID() && entries[slot].name == name)
+                entries[slot].uid = -1;
+        }
+
+    public:
+        /**
+         *  @brief  Constructor of an empty cache.
+         *  @param  arena   arena of the tree, the cache observes the
+         *                  attributes and inner-data set on its nodes
+         *  @param  nodes   slots of the nodes of the tree
+         * */
+        DOMnumberCache(DOMarena &arena, DOMnodeTable *nodes)
+            : observerSlot(arena.shareObserverSlot()), nodes(nodes)
+        {
+            observerSlot->add(this);
+        }
+
+        DOMnumberCache(const DOMnumberCache &) = delete;
+        DOMnumberCache &operator=(const DOMnumberCache &) = delete;
+
+        ~DOMnumberCache()
+        {
+            observerSlot->remove(this);
+        }
+
+        /**
+         *  @brief  Marks the cache stale, to be emptied by the next lookup.
+         *  @param  table   slots of the nodes of the tree, which may have
+         *                  been replaced
+         * */
+        void invalidate(DOMnodeTable *table)
+        {
+            nodes = table;
+            stale = true;
+        }
+
+        /**
+         *  @brief  Checks if the cache is to be emptied by the next lookup.
+         * */
+        inline bool isStale() const
+        {
+            return stale;
+        }
+
+        /**
+         *  @brief  Returns the attribute of the node, or its inner-data,
+         *          parsed as a number of type T (see parseNumber()).
+         *  @param  name    interned name of the attribute, NO_SYMBOL for the
+         *                  inner-data of the node
+         * */
+        template <class T>
+        std::optional<T> getNumber(const DOMnode &node, DOMsymbol name)
+        {
+            if constexpr (std::is_integral_v<T>)
+            {
+                const entry_t &entry = lookup(node, name, INTEGER);
+                if (!entry.valid)
+                    return std::nullopt;
+                if constexpr (std::is_unsigned_v<T>)
+                {
+                    if (entry.integer < 0 || std::uint64_t(entry.integer) > std::numeric_limits<T>::max())
+                        return std::nullopt;
+                }
+                else if (entry.integer < std::numeric_limits<T>::min() || entry.integer > std::numeric_limits<T>::max())
+                    return std::nullopt;
+                return T(entry.integer);
+            }
+            else
+            {
+                const entry_t &entry = lookup(node, name, REAL);
+                if (!entry.valid)
+                    return std::nullopt;
+                return T(entry.real.value);
+            }
+        }
+
+        /**
+         *  @brief  Returns the attribute of the node parsed as a dimension
+         *          (see parseDimension()).
+         * */
+        std::optional<DOMdimension> getDimension(const DOMnode &node, DOMsymbol name)
+        {
+            const entry_t &entry = lookup(node, name, DIMENSION);
+            if (!entry.valid)
+                return std::nullopt;
+            return entry.real;
+        }
+
+        void attributeChanged(DOMnode &node, DOMsymbol name, std::string_view /*previous*/,
+                              std::string_view /*value*/) override
+        {
+            drop(node, name);
+        }
+
+        void innerDataChanged(DOMnode &node, std::string_view /*previous*/, std::string_view /*data*/) override
+        {
+            drop(node, DOMsymbolTable::NO_SYMBOL);
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
@@ -0,0 +1,250 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_NUMBERS
+#define DOM_PARSER_DOM_NUMBERS
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Number followed by a unit, such as "10dp" or "1.5em". The unit
+     *          is a view of the parsed string, empty if there is none.
+     * */
+    struct DOMdimension
+    {
+        double value = 0;
+        std::string_view unit;
+    };
+
+    /**
+     *  @brief  Checks if the 8 bytes of the word, in memory order, are all
+     *          ASCII digits.
+     * */
+    inline bool isEightDigits(std::uint64_t word)
+    {
+        return ((word & 0xf0f0f0f0f0f0f0f0ull) |
+                (((word + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull) >> 4)) == 0x3333333333333333ull;
+    }
+
+    /**
+     *  @brief  Returns the value of 8 ASCII digits loaded from memory into
+     *          a little-endian word, combining pairs, then quads, then the
+     *          two halves of the digits with three multiplications.
+     * */
+    inline std::uint32_t parseEightDigits(std::uint64_t word)
+    {
+        word -= 0x3030303030303030ull;
+        word = (word * 10) + (word >> 8);
+        word = (((word & 0x000000ff000000ffull) * 0x000f424000000064ull) +
+                (((word >> 16) & 0x000000ff000000ffull) * 0x0000271000000001ull)) >>
+               32;
+        return std::uint32_t(word);
+    }
+
+    /**
+     *  @brief  Parses the run of digits at p, 8 at a time while they last,
+     *          appending them to value.
+     *  @param  digits  incremented by the number of digits
+     *  @return pointer past the digits
+     * */
+    inline const char *parseDigits(const char *p, const char *end, std::uint64_t &value, int &digits)
+    {
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        std::uint64_t word;
+        while (end - p >= 8 && (std::memcpy(&word, p, 8), isEightDigits(word)))
+        {
+            value = value * 100000000 + parseEightDigits(word);
+            p += 8;
+            digits += 8;
+        }
+#endif
+        while (p < end && unsigned(*p - '0') < 10)
+        {
+            value = value * 10 + unsigned(*p - '0');
+            ++p;
+            ++digits;
+        }
+        return p;
+    }
+
+    inline std::string_view trimNumber(std::string_view text)
+    {
+        auto space = [](char c)
+        { return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f' || c == '\v'; };
+        while (!text.empty() && space(text.front()))
+            text.remove_prefix(1);
+        while (!text.empty() && space(text.back()))
+            text.remove_suffix(1);
+        return text;
+    }
+
+    /**
+     *  @brief  Parses a decimal integer, with an optional sign.
+     *  @return pointer past the number, nullptr if there is none or it is
+     *          out of range
+     * */
+    inline const char *scanInteger(const char *first, const char *end, std::int64_t &value)
+    {
+        const char *p = first;
+        bool negative = (p < end && *p == '-');
+        if (p < end && (*p == '-' || *p == '+'))
+            ++p;
+        std::uint64_t magnitude = 0;
+        int digits = 0;
+        const char *last = parseDigits(p, end, magnitude, digits);
+        if (digits == 0)
+            return nullptr;
+        if (digits > 19) // may have overflowed, or be leading zeros
+        {
+            std::from_chars_result result = std::from_chars(negative ? p - 1 : p, end, value);
+            return (result.ec == std::errc() ? result.ptr : nullptr);
+        }
+        if (magnitude > std::uint64_t(std::numeric_limits<std::int64_t>::max()) + negative)
+            return nullptr;
+        value = (negative ? std::int64_t(0 - magnitude) : std::int64_t(magnitude));
+        return last;
+    }
+
+    /**
+     *  @brief  Parses a decimal real, with optional sign, fraction and
+     *          exponent. Numbers whose digits make an integer below 2^53 and
+     *          whose exponent is small are computed exactly from that integer
+     *          and a power of ten, the others by std::from_chars.
+     *  @return pointer past the number, nullptr if there is none or it is
+     *          out of the range of double
+     * */
+    inline const char *scanReal(const char *first, const char *end, double &value)
+    {
+        static constexpr double POWERS[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        const char *p = first;
+        bool negative = (p < end && *p == '-');
+        if (p < end && (*p == '-' || *p == '+'))
+            ++p;
+        const char *digitsBegin = p;
+        std::uint64_t mantissa = 0;
+        int digits = 0;
+        p = parseDigits(p, end, mantissa, digits);
+        int fraction = 0;
+        if (p < end && *p == '.')
+        {
+            const char *fractionBegin = p + 1;
+            p = parseDigits(fractionBegin, end, mantissa, digits);
+            fraction = int(p - fractionBegin);
+        }
+        if (digits == 0)
+            return nullptr;
+        int exponent = 0;
+        if (p + 1 < end && (*p == 'e' || *p == 'E')) // not a unit such as "em"
+        {
+            const char *q = p + 1;
+            bool negativeExponent = (*q == '-');
+            if (*q == '-' || *q == '+')
+                ++q;
+            std::uint64_t magnitude = 0;
+            int exponentDigits = 0;
+            const char *last = parseDigits(q, end, magnitude, exponentDigits);
+            if (exponentDigits > 0)
+            {
+                exponent = (exponentDigits > 4 ? 100000 : int(magnitude)); // far beyond the range of double
+                exponent = (negativeExponent ? -exponent : exponent);
+                p = last;
+            }
+        }
+
+        exponent -= fraction;
+        if (digits <= 19 && mantissa <= (std::uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+        {
+            double real = double(mantissa);
+            real = (exponent < 0 ? real / POWERS[-exponent] : real * POWERS[exponent]);
+            value = (negative ? -real : real);
+            return p;
+        }
+        double real;
+        std::from_chars_result result = std::from_chars(digitsBegin, p, real);
+        if (result.ec != std::errc())
+            return nullptr;
+        value = (negative ? -real : real);
+        return result.ptr;
+    }
+
+    /**
+     *  @brief  Parses the whole text, surrounding whitespace aside, as a
+     *          number of type T: an integral type, range checked, or a
+     *          floating-point type.
+     *  @return false if the text is not such a number
+     * */
+    template <class T>
+    bool parseNumber(std::string_view text, T &value)
+    {
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "numbers are integral or floating-point");
+        text = trimNumber(text);
+        const char *end = text.data() + text.size();
+        if constexpr (std::is_integral_v<T>)
+        {
+            std::int64_t integer;
+            if (scanInteger(text.data(), end, integer) != end || text.empty())
+                return false;
+            if constexpr (std::is_unsigned_v<T>)
+            {
+                if (integer < 0 || std::uint64_t(integer) > std::numeric_limits<T>::max())
+                    return false;
+            }
+            else if (integer < std::numeric_limits<T>::min() || integer > std::numeric_limits<T>::max())
+                return false;
+            value = T(integer);
+        }
+        else
+        {
+            double real;
+            if (text.empty() || scanReal(text.data(), end, real) != end)
+                return false;
+            value = T(real);
+        }
+        return true;
+    }
+
+    /**
+     *  @brief  Parses the whole text, surrounding whitespace aside, as a
+     *          number followed by a unit of letters or '%'.
+     *  @return false if the text does not start with a number or the rest
+     *          of it is not a unit
+     * */
+    inline bool parseDimension(std::string_view text, DOMdimension &dimension)
+    {
+        text = trimNumber(text);
+        const char *end = text.data() + text.size();
+        double real;
+        const char *p = (text.empty() ? nullptr : scanReal(text.data(), end, real));
+        if (!p)
+            return false;
+        std::string_view unit(p, std::size_t(end - p));
+        for (char c : unit)
+            if (c != '%' && unsigned((c | 0x20) - 'a') >= 26)
+                return false;
+        dimension.value = real;
+        dimension.unit = unit;
+        return true;
+    }
+
+} // namespace dom_parser
+
+#endif
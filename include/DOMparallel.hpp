@@ -0,0 +1,363 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_PARALLEL
+#define DOM_PARSER_DOM_PARALLEL
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "DOMtree.hpp"
+#include "taskflow/taskflow.hpp"
+#include "taskflow/algorithm/reduce.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Split of a subtree into chunks of about the same number of
+     *          nodes, to be processed by parallel tasks.
+     *
+     *          The subtree is cut into items in document order: subtrees
+     *          smaller than the grain, and single nodes whose subtrees are
+     *          bigger. Chunks are runs of consecutive items holding about a
+     *          grain of nodes. One walk over the subtree computes the split,
+     *          which stays valid until nodes are added, moved or deleted, so
+     *          it can be reused by many passes over the same tree.
+     * */
+    class DOMpartition
+    {
+    public:
+        struct item_t
+        {
+            DOMnode *node;
+            std::uint32_t size; // nodes in the item
+            bool subtree;       // the whole subtree of the node, or the node only
+        };
+
+        struct chunk_t
+        {
+            std::size_t begin, end; // items of the chunk
+            std::size_t size;       // nodes in the chunk
+        };
+
+        // bounds of the grain picked for a number of workers
+        static constexpr std::size_t MIN_GRAIN = 256;
+        static constexpr std::size_t MAX_GRAIN = 16384;
+
+        // chunks made per worker, so that workers done early steal the rest
+        static constexpr std::size_t CHUNKS_PER_WORKER = 8;
+
+    private:
+        DOMtree *tree = nullptr;
+        std::vector<item_t> items;
+        std::vector<chunk_t> chunks;
+        std::size_t count = 0;
+        std::size_t grain = 0;
+
+    public:
+        DOMpartition() = default;
+
+        /**
+         *  @brief  Constructor, splits the subtree of root.
+         *  @param  tree    the tree
+         *  @param  root    UID of the root of the subtree
+         *  @param  workers number of workers the chunks are made for
+         *  @param  grain   nodes per chunk, 0 to pick it from the size of the
+         *                  tree and the number of workers
+         * */
+        explicit DOMpartition(DOMtree &tree, DOMnodeUID root = 0,
+                              std::size_t workers = std::thread::hardware_concurrency(), std::size_t grain = 0)
+            : tree(&tree)
+        {
+            if (!tree.isValid(root))
+                return;
+            if (grain == 0)
+                grain = std::clamp<std::size_t>(static_cast<std::size_t>(tree.getNodeCount()) /
+                                                    (std::max<std::size_t>(workers, 1) * CHUNKS_PER_WORKER),
+                                                MIN_GRAIN, MAX_GRAIN);
+            this->grain = grain;
+
+            // every node gets an item when opened, the items of a subtree
+            // smaller than the grain are merged into one when it closes
+            struct open_t
+            {
+                DOMnode *node;
+                std::size_t item;
+                std::size_t size;
+            };
+            std::vector<open_t> stack;
+            DOMnode *node = &tree.getNode(root);
+            while (node)
+            {
+                stack.push_back({node, items.size(), 1});
+                items.push_back({node, 1, false});
+                if (node->getFirstChild() != -1)
+                {
+                    node = &tree.getNode(node->getFirstChild());
+                    continue;
+                }
+                node = nullptr;
+                while (!stack.empty())
+                {
+                    open_t closed = stack.back();
+                    stack.pop_back();
+                    if (closed.size < grain)
+                    {
+                        items.resize(closed.item + 1);
+                        items.back() = {closed.node, static_cast<std::uint32_t>(closed.size), true};
+                    }
+                    if (stack.empty())
+                    {
+                        count = closed.size;
+                        break;
+                    }
+                    stack.back().size += closed.size;
+                    if (closed.node->getNextSibling() != -1)
+                    {
+                        node = &tree.getNode(closed.node->getNextSibling());
+                        break;
+                    }
+                }
+            }
+
+            std::size_t begin = 0, size = 0;
+            for (std::size_t i = 0; i < items.size(); ++i)
+            {
+                size += items[i].size;
+                if (size >= grain || i + 1 == items.size())
+                {
+                    chunks.push_back({begin, i + 1, size});
+                    begin = i + 1;
+                    size = 0;
+                }
+            }
+        }
+
+        /**
+         *  @brief  Returns the chunks, in document order.
+         * */
+        inline const std::vector<chunk_t> &getChunks() const
+        {
+            return chunks;
+        }
+
+        /**
+         *  @brief  Returns the items, in document order.
+         * */
+        inline const std::vector<item_t> &getItems() const
+        {
+            return items;
+        }
+
+        /**
+         *  @brief  Returns the number of nodes in the subtree.
+         * */
+        inline std::size_t getNodeCount() const
+        {
+            return count;
+        }
+
+        /**
+         *  @brief  Returns the number of nodes per chunk aimed at.
+         * */
+        inline std::size_t getGrain() const
+        {
+            return grain;
+        }
+
+        /**
+         *  @brief  Returns the tree the partition was made for.
+         * */
+        inline DOMtree &getTree() const
+        {
+            return *tree;
+        }
+
+        /**
+         *  @brief  Calls f for every node of the item, in document order.
+         * */
+        template <class F>
+        void visit(const item_t &item, F &&f) const
+        {
+            DOMnode *node = item.node;
+            f(*node);
+            if (!item.subtree || node->getFirstChild() == -1)
+                return;
+            node = &tree->getNode(node->getFirstChild());
+            while (true)
+            {
+                f(*node);
+                if (node->getFirstChild() != -1)
+                {
+                    node = &tree->getNode(node->getFirstChild());
+                    continue;
+                }
+                while (node->getNextSibling() == -1)
+                {
+                    node = &tree->getNode(node->getParent());
+                    if (node == item.node)
+                        return;
+                }
+                node = &tree->getNode(node->getNextSibling());
+            }
+        }
+
+        /**
+         *  @brief  Calls f for every node of the chunk, in document order.
+         * */
+        template <class F>
+        void visit(const chunk_t &chunk, F &&f) const
+        {
+            for (std::size_t i = chunk.begin; i < chunk.end; ++i)
+                visit(items[i], f);
+        }
+    };
+
+    /**
+     *  @brief  Parallel algorithms over the nodes of a tree. The subtree is
+     *          split by DOMpartition and the chunks are scheduled on the
+     *          executor by the parallel algorithms of taskflow, with dynamic
+     *          partitioning over the work-stealing workers. Executors with
+     *          one worker run everything in the calling thread.
+     * */
+    namespace parallel
+    {
+        /**
+         *  @brief  Calls f(DOMnode &) for every node of the partition, from
+         *          many threads at once. Nodes must not be added, moved or
+         *          deleted by f.
+         * */
+        template <class F>
+        void for_each_node(tf::Executor &executor, const DOMpartition &partition, F f)
+        {
+            const std::vector<DOMpartition::chunk_t> &chunks = partition.getChunks();
+            if (executor.num_workers() < 2 || chunks.size() < 2)
+            {
+                for (const DOMpartition::chunk_t &chunk : chunks)
+                    partition.visit(chunk, f);
+                return;
+            }
+            tf::Taskflow taskflow;
+            taskflow.for_each(tf::ExecutionPolicy<tf::DynamicPartitioner>(1), chunks.begin(), chunks.end(),
+                              [&partition, &f](const DOMpartition::chunk_t &chunk)
+                              { partition.visit(chunk, f); });
+            executor.run(taskflow).wait();
+        }
+
+        /**
+         *  @brief  Calls f(DOMnode &) for every node in the subtree of root,
+         *          root included, from many threads at once.
+         * */
+        template <class F>
+        void for_each_node(tf::Executor &executor, DOMtree &tree, F f, DOMnodeUID root = 0)
+        {
+            for_each_node(executor, DOMpartition(tree, root, executor.num_workers()), f);
+        }
+
+        /**
+         *  @brief  Reduces the values uop(const DOMnode &) of the nodes of
+         *          the partition with bop. Every chunk is reduced in document
+         *          order, the results of the chunks in no particular order,
+         *          so bop must be associative and commutative.
+         *  @param  init    initial value of the reduction
+         * */
+        template <class T, class BOP, class UOP>
+        T reduce_subtrees(tf::Executor &executor, const DOMpartition &partition, T init, BOP bop, UOP uop)
+        {
+            auto reduceChunk = [&partition, &bop, &uop](const DOMpartition::chunk_t &chunk)
+            {
+                std::optional<T> sum;
+                partition.visit(chunk, [&sum, &bop, &uop](const DOMnode &node)
+                                {
+                                    if (sum)
+                                        sum = bop(std::move(*sum), uop(node));
+                                    else
+                                        sum = uop(node);
+                                });
+                return std::move(*sum); // chunks are never empty
+            };
+            const std::vector<DOMpartition::chunk_t> &chunks = partition.getChunks();
+            if (executor.num_workers() < 2 || chunks.size() < 2)
+            {
+                for (const DOMpartition::chunk_t &chunk : chunks)
+                    init = bop(std::move(init), reduceChunk(chunk));
+                return init;
+            }
+            tf::Taskflow taskflow;
+            taskflow.transform_reduce(tf::ExecutionPolicy<tf::DynamicPartitioner>(1), chunks.begin(), chunks.end(),
+                                      init, bop, reduceChunk);
+            executor.run(taskflow).wait();
+            return init;
+        }
+
+        /**
+         *  @brief  Reduces the values uop(const DOMnode &) of the nodes in
+         *          the subtree of root, root included, with bop, which must
+         *          be associative and commutative.
+         * */
+        template <class T, class BOP, class UOP>
+        T reduce_subtrees(tf::Executor &executor, DOMtree &tree, T init, BOP bop, UOP uop, DOMnodeUID root = 0)
+        {
+            return reduce_subtrees(executor, DOMpartition(tree, root, executor.num_workers()), std::move(init), bop,
+                                   uop);
+        }
+
+        /**
+         *  @brief  Replaces the text of every inner-data node of the
+         *          partition by f(std::string_view), which returns a string
+         *          or anything else convertible to std::string_view. The new
+         *          texts are stored in arenas of the tree, one per worker.
+         * */
+        template <class F>
+        void transform_text(tf::Executor &executor, const DOMpartition &partition, F f)
+        {
+            // created by the worker on its first replacement
+            std::vector<std::shared_ptr<DOMarena>> arenas(executor.num_workers() + 1);
+            DOMtree &tree = partition.getTree();
+            for_each_node(executor, partition, [&](DOMnode &node)
+                          {
+                              if (!node.isInnerDataNode())
+                                  return;
+                              std::string_view data = node.getInnerData();
+                              const auto &result = f(data);
+                              std::string_view replaced(result);
+                              if (replaced == data)
+                                  return;
+                              std::shared_ptr<DOMarena> &arena = arenas[executor.this_worker_id() + 1];
+                              if (!arena)
+                                  arena = tree.createArena();
+                              node.setInnerData(replaced, *arena);
+                          });
+        }
+
+        /**
+         *  @brief  Replaces the text of every inner-data node in the subtree
+         *          of root by f(std::string_view).
+         * */
+        template <class F>
+        void transform_text(tf::Executor &executor, DOMtree &tree, F f, DOMnodeUID root = 0)
+        {
+            transform_text(executor, DOMpartition(tree, root, executor.num_workers()), f);
+        }
+
+    } // namespace parallel
+
+} // namespace dom_parser
+
+#endif
@@ -18,6 +18,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory_resource>
 #include <stack>
 
 #include <filesystem>
@@ -29,6 +30,7 @@
 
 #include "DOMLexer.hpp"
 #include "DOMtree.hpp"
+#include "DOMwriter.hpp"
 
 namespace dom_parser
 {
@@ -37,6 +39,14 @@ namespace dom_parser
     private:
         DOMtree tree;
 
+        // memory resource for the trees built by the parser, nullptr for
+        // the default per-tree arena
+        std::pmr::memory_resource *resource = nullptr;
+
+        // names are interned here while scanning, shared by all the trees
+        // loaded by the parser
+        std::shared_ptr<DOMsymbolTable> symbols = std::make_shared<DOMsymbolTable>();
+
         /**
          * @brief   deprecated, loads tree from the data
          */
@@ -63,11 +73,10 @@ namespace dom_parser
                         return (i - data.begin());
 
                     // set the root
-                    DOMtree _tree(tag_name);
                     // std::cout << "\n\tdebug: "
                     //           << "root tag=" << tag_name << "\n";
                     DOMnodeUID uid = 0; // uid is 0 for root
-                    tree = _tree;
+                    tree = DOMtree(tag_name, resource, symbols);
                     element_stack.push(uid);
                     for (auto const &attribute : attr)
                         tree.getNode(uid).setAttribute(attribute.first, attribute.second);
@@ -148,15 +157,14 @@ namespace dom_parser
             // scan root node
             {
                 DOMnodeUID uid = 0; // for root
-                std::string tag_name;
+                DOMsymbol tag_name;
                 std::map<std::string, std::string> attributes;
 
                 int res = _data_scan_tag(_lexer, tag_name, attributes);
                 if (res != 1)
                     return -2;
 
-                DOMtree _tree(tag_name);
-                tree = _tree;
+                tree = DOMtree(tag_name, symbols, resource);
                 element_stack.push(uid);
                 tree.getNode(uid).setAttributes(std::move(attributes));
             }
@@ -164,7 +172,7 @@ namespace dom_parser
 
             while (_T->token != lexer_token_values::T_FILEEND)
             {
-                std::string tag_name;
+                DOMsymbol tag_name = DOMsymbolTable::NO_SYMBOL;
                 std::map<std::string, std::string> attributes;
                 DOMnodeUID uid;
 
@@ -173,7 +181,8 @@ namespace dom_parser
                     int res = _data_scan_tag(_lexer, tag_name, attributes);
 
 #ifdef DOM_PARSER_DEBUG_MODE
-                    std::cout << "\n\tdebug: PARSER: TAG: " << tag_name
+                    std::cout << "\n\tdebug: PARSER: TAG: "
+                              << (tag_name != DOMsymbolTable::NO_SYMBOL ? symbols->name(tag_name) : std::string())
                               << " ATTRIBUTES:";
                     for (const auto &attr : attributes)
                     {
@@ -327,155 +336,14 @@ namespace dom_parser
          *          -2  self closing tag
          * */
         int _data_scan_tag(lexer &_lexer,
-                           std::string &tag_name,
+                           DOMsymbol &tag_name,
                            std::map<std::string, std::string> &attributes)
         {
-            auto _T = _lexer.next();
-            // everytime we use lexer::next() we will check for file-end token
-            // if we get abrupt file end, error value will be returned
-
-            switch (_T->token)
-            {
-            case lexer_token_values::T_FILEEND: // found file end
-                return 0;
-
-            case lexer_token_values::T_BKSLASH: // closing tag
-                _T = _lexer.next();
-                if (_T->token != lexer_token_values::T_IDNTIFR)
-                    return 0;
-                _T = _lexer.next();
-                if (_T->token != lexer_token_values::T_CLOSTAG)
-                    return 0;
-                return -1;
-
-            case lexer_token_values::T_IDNTIFR: // found identifier
-
-                tag_name = _T->value; // set tagname
-
-                _T = _lexer.next();
-                if (_T->token == lexer_token_values::T_FILEEND)
-                    return 0;
-
-                // scan attributes till closing tag
-                while (_T->token != lexer_token_values::T_CLOSTAG &&
-                       _T->token != lexer_token_values::T_BKSLASH)
-                {
-                    // error: not identifier
-                    if (_T->token != lexer_token_values::T_IDNTIFR)
-                        return 0;
-
-                    std::string attribute, value;
-                    // get attribute name
-                    attribute = _T->value;
-
-                    // check next token for equal sign
-                    _T = _lexer.next();
-                    // either token should be equal sign or an identifier or > or /
-                    // > for tag closing, and / for /> type tag closing
-                    // otherwise error
-                    if (_T->token == lexer_token_values::T_IDNTIFR ||
-                        _T->token == lexer_token_values::T_BKSLASH ||
-                        _T->token == lexer_token_values::T_CLOSTAG) // no value attribute
-                    {
-                        attributes[attribute] = "";
-                        continue;
-                    }
-                    else if (_T->token != lexer_token_values::T_EQLSIGN) // error
-                        return 0;
-
-                    // scan attribute value
-                    // next token is either double/single quote or an identifier
-                    _T = _lexer.next();
-                    if (_T->token == lexer_token_values::T_IDNTIFR) // identifier
-                    {
-                        attributes[attribute] = _T->value;
-                    }
-                    else if (_T->token == lexer_token_values::T_DBLQUOT ||
-                             _T->token == lexer_token_values::T_SINQUOT) // quote
-                    {
-                        auto T_QUOTE = _T->token;
-                        _T = _lexer.next();
-                        // scan till we encounter that quote or file-end
-                        while (_T->token != T_QUOTE)
-                        {
-                            if (_T->token == lexer_token_values::T_FILEEND)
-                                return 0;
-                            value += _T->value + " ";
-
-                            _T = _lexer.next();
-                        }
-                        value.erase(value.length() - 1, 1); // trim the last space
-                        attributes[attribute] = value;
-                    }
-                    else
-                        return 0;
-
-                    _T = _lexer.next(); // next token
-                }
-
-                // check if element opening tag or self closing tag
-                if (_T->token == lexer_token_values::T_BKSLASH)
-                {
-                    _T = _lexer.next();
-                    if (_T->token == lexer_token_values::T_CLOSTAG)
-                        return -2; // self closing
-                    else
-                        return 0; // error
-                }
-                else if (_T->token == lexer_token_values::T_CLOSTAG)
-                    return 1; // success
-                else
-                    return 0; // error
-            }
-
-            return 0;
-        }
-
-        /**
-         * @brief   Helper function, generates output for the tree.
-         * @param   _node       Initial node
-         * @param   indent      Indentation string
-         * @param   indentation Current indentation at the node
-         * @param   _newline    Char to be used as newline char
-         * */
-        std::string _process_output_for_node(DOMnodeUID _node, const std::string &indent,
-                                             std::string indentation, std::string _newline)
-        {
-            auto node = tree.getNode(_node);
-            std::string s;
-
-            // set indentation
-            s += indentation;
-
-            // check if node is innerData node
-            if (node.isInnerDataNode())
-            {
-                s += node.getInnerData() + _newline;
-                return s;
-            }
-
-            // opening and closing tags
-            s += "<" + node.getTagName();
-            for (auto i : node.getAllAttributes())
-            {
-                s += " " + i.first;
-                if (!i.second.empty())
-                    s += "=\"" + i.second + "\"";
-            }
-            if (node.getChildrenUID().empty()) // if no child nodes
-                s += " />" + _newline;         // closing tags
-            else
-            {
-                // close opening tag
-                s += ">" + _newline;
-                // add children nodes
-                for (auto i : node.getChildrenUID())
-                    s += _process_output_for_node(i, indent, indentation + indent, _newline);
-                // closing tag
-                s += indentation + "</" + node.getTagName() + ">" + _newline;
-            }
-
-            return s;
+            std::string name;
+            int res = _lexer.scan_tag(name, attributes);
+            if (res == 1 || res == -2)
+                tag_name = symbols->intern(name); // set tagname
+            return res;
         }
 
     public:
@@ -484,6 +352,26 @@ namespace dom_parser
          */
         DOMparser() {}
 
+        /**
+         * @brief   Constructor, the trees loaded by the parser take their
+         *          memory from the given resource.
+         * @param   resource    memory resource for the nodes of loaded trees,
+         *                      nullptr for the default per-tree arena.
+         */
+        explicit DOMparser(std::pmr::memory_resource *resource)
+            : resource(resource) {}
+
+        /**
+         * @brief   Constructor, the trees loaded by the parser intern their
+         *          tag and attribute names in the given symbol table, which
+         *          can be shared by the parsers of a batch of documents.
+         * @param   resource    memory resource for the nodes of loaded trees,
+         *                      nullptr for the default per-tree arena.
+         * @param   symbols     shared symbol table
+         */
+        DOMparser(std::pmr::memory_resource *resource, std::shared_ptr<DOMsymbolTable> symbols)
+            : resource(resource), symbols(std::move(symbols)) {}
+
         /**
          * @brief   Deprecated. Constructs the tree from the provided data.
          * @param   data    the data
@@ -548,14 +436,35 @@ namespace dom_parser
         }
 
         /**
-         * @brief   Returns the loaded tree else the tree is blank
-         *          with only one node - root node with blank tag name.
+         * @brief   Returns reference to the loaded tree else the tree is
+         *          blank with only one node - root node with blank tag name.
+         *          The tree stays owned by the parser.
          */
-        inline DOMtree getTree()
+        inline const DOMtree &getTree() const
         {
             return tree;
         }
 
+        /**
+         * @brief   Returns reference to the loaded tree, which can be modified
+         *          in place before generating output.
+         */
+        inline DOMtree &getTree()
+        {
+            return tree;
+        }
+
+        /**
+         * @brief   Moves the loaded tree out of the parser in O(1), nothing
+         *          is copied. The parser is left with an empty tree.
+         */
+        inline DOMtree takeTree()
+        {
+            DOMtree taken = std::move(tree);
+            tree = DOMtree(resource, symbols);
+            return taken;
+        }
+
         /**
          * @brief   Returns string of formatted document.
          * @param   minified    If output is required to be in minified form.
@@ -565,19 +474,54 @@ namespace dom_parser
          * */
         std::string getOutput(bool minified = false, std::string indent = "    ", std::string indentation = "")
         {
-            // return _process_output_for_node(0, indent, indentation, (minified ? "" : "\n"));
-            if (minified)
-                return _process_output_for_node(0, "", "", "");
-            else
-                return _process_output_for_node(0, indent, indentation, "\n");
+            std::string output;
+            std::unique_ptr<char[]> buffer(new char[DOMoutputSink::BUFFER_SIZE]);
+            DOMoutputSink sink(buffer.get(), DOMoutputSink::BUFFER_SIZE, [&output](const char *data, std::size_t size)
+                               {
+                                   output.append(data, size);
+                                   return true;
+                               });
+            writeOutput(sink, minified, indent, indentation);
+            return output;
+        }
+
+        /**
+         * @brief   Writes the formatted document into the sink, as returned
+         *          by getOutput() but without building it in memory.
+         * @param   sink        destination of the document (see DOMoutputSink)
+         * @param   minified    If output is required to be in minified form.
+         * @param   indent      string which denotes indentation, default is 4 spaces.
+         * @param   indentation initial indentation of the output.
+         * @return  0   if written
+         *          -1  if the sink failed
+         * */
+        int writeOutput(DOMoutputSink &sink, bool minified = false, std::string_view indent = "    ",
+                        std::string_view indentation = "")
+        {
+            return DOMwriter(minified, indent, indentation).write(tree, 0, sink);
+        }
+
+        /**
+         * @brief   Writes the formatted document into the stream.
+         * @return  0   if written
+         *          -1  if the stream failed
+         * */
+        int writeOutput(std::ostream &out, bool minified = false, std::string_view indent = "    ",
+                        std::string_view indentation = "")
+        {
+            DOMoutputSink sink(out);
+            return writeOutput(sink, minified, indent, indentation);
         }
 
         /**
-         * @brief   =operator overload
+         * @brief   =operator overload, the tree of the other parser is cloned
+         *          (see DOMtree::clone()).
          * */
         DOMparser &operator=(const DOMparser &parser)
         {
-            this->tree = parser.tree;
+            this->tree = parser.tree.clone();
+            this->resource = parser.resource;
+            this->symbols = parser.symbols;
 
             return *this;
         }
@@ -0,0 +1,809 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_SELECTOR
+#define DOM_PARSER_DOM_SELECTOR
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "DOMtree.hpp"
+#include "taskflow/taskflow.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  CSS selector compiled to a program matched right to left: a
+     *          node is checked against the rightmost compound selector
+     *          first, then its ancestors against the compounds on the left.
+     *
+     *          Supported: type (tag) and universal selectors, #id, .class,
+     *          attribute selectors [a], [a=v], [a~=v], [a|=v], [a^=v],
+     *          [a$=v], [a*=v] (attribute names may contain ':', such as
+     *          android:id), :nth-child(an+b | odd | even), :first-child,
+     *          the descendant and child (>) combinators and selector lists
+     *          separated by commas. Names are case-sensitive, as in XML.
+     *          Only element nodes are matched.
+     * */
+    class DOMselector
+    {
+    private:
+        // in order of the cost of the test
+        enum class test_kind_t
+        {
+            EXISTS,    // [a]
+            EQUALS,    // [a=v], #id
+            TOKEN,     // [a~=v], .class
+            DASH,      // [a|=v]
+            PREFIX,    // [a^=v]
+            SUFFIX,    // [a$=v]
+            SUBSTRING, // [a*=v]
+            NTH_CHILD  // :nth-child(an+b)
+        };
+
+        struct test_t
+        {
+            test_kind_t kind;
+            DOMsymbol attribute;
+            std::string value;
+            int a, b;
+        };
+
+        struct compound_t
+        {
+            DOMsymbol tag = DOMsymbolTable::NO_SYMBOL; // NO_SYMBOL for any
+            std::string id;                             // empty for none
+            std::vector<test_t> tests;
+            bool child = false; // relation to the compound on its left
+        };
+
+        // compounds of each selector of the list, right to left
+        std::vector<std::vector<compound_t>> program;
+        const DOMsymbolTable *symbols;
+
+        /**
+         *  @brief  Hand-written parser of selector lists.
+         * */
+        class parser_t
+        {
+        private:
+            std::string_view text;
+            std::size_t i = 0;
+            DOMsymbolTable &symbols;
+
+            static inline bool isNameChar(char c, bool attribute)
+            {
+                return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' ||
+                       static_cast<unsigned char>(c) >= 0x80 || (attribute && c == ':');
+            }
+
+            inline bool skipSpaces()
+            {
+                std::size_t start = i;
+                while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i])))
+                    ++i;
+                return i != start;
+            }
+
+            inline bool name(std::string_view &parsed, bool attribute = false)
+            {
+                std::size_t start = i;
+                while (i < text.size() && isNameChar(text[i], attribute))
+                    ++i;
+                parsed = text.substr(start, i - start);
+                return !parsed.empty();
+            }
+
+            bool value(std::string &parsed)
+            {
+                if (i < text.size() && (text[i] == '"' || text[i] == '\''))
+                {
+                    char quote = text[i++];
+                    std::size_t end = text.find(quote, i);
+                    if (end == std::string_view::npos)
+                        return false;
+                    parsed = std::string(text.substr(i, end - i));
+                    i = end + 1;
+                    return true;
+                }
+                std::string_view bare;
+                if (!name(bare, true))
+                    return false;
+                parsed = std::string(bare);
+                return true;
+            }
+
+            static bool integer(std::string_view text, int &parsed)
+            {
+                if (text.empty() || text.size() > 9)
+                    return false;
+                parsed = 0;
+                for (char c : text)
+                {
+                    if (!std::isdigit(static_cast<unsigned char>(c)))
+                        return false;
+                    parsed = parsed * 10 + (c - '0');
+                }
+                return true;
+            }
+
+            /**
+             *  @brief  Parses the argument of :nth-child(), an+b or odd or even.
+             * */
+            static bool nth(std::string_view arg, int &a, int &b)
+            {
+                std::string compact;
+                for (char c : arg)
+                    if (!std::isspace(static_cast<unsigned char>(c)))
+                        compact += c;
+                std::string_view s = compact;
+                if (s == "odd")
+                    return a = 2, b = 1, true;
+                if (s == "even")
+                    return a = 2, b = 0, true;
+
+                std::size_t n = s.find('n');
+                if (n == std::string_view::npos)
+                {
+                    a = 0;
+                    bool negative = !s.empty() && s[0] == '-';
+                    if (!s.empty() && (s[0] == '+' || s[0] == '-'))
+                        s.remove_prefix(1);
+                    if (!integer(s, b))
+                        return false;
+                    b = (negative ? -b : b);
+                    return true;
+                }
+
+                std::string_view coefficient = s.substr(0, n);
+                if (coefficient.empty() || coefficient == "+")
+                    a = 1;
+                else if (coefficient == "-")
+                    a = -1;
+                else
+                {
+                    bool negative = coefficient[0] == '-';
+                    if (coefficient[0] == '+' || coefficient[0] == '-')
+                        coefficient.remove_prefix(1);
+                    if (!integer(coefficient, a))
+                        return false;
+                    a = (negative ? -a : a);
+                }
+
+                std::string_view offset = s.substr(n + 1);
+                if (offset.empty())
+                    return b = 0, true;
+                if (offset[0] != '+' && offset[0] != '-')
+                    return false;
+                if (!integer(offset.substr(1), b))
+                    return false;
+                b = (offset[0] == '-' ? -b : b);
+                return true;
+            }
+
+            bool attribute(compound_t &compound)
+            {
+                ++i; // [
+                skipSpaces();
+                std::string_view attributeName;
+                if (!name(attributeName, true))
+                    return false;
+                test_t test{test_kind_t::EXISTS, symbols.intern(attributeName), std::string(), 0, 0};
+                skipSpaces();
+                if (i < text.size() && text[i] != ']')
+                {
+                    static constexpr std::string_view OPERATORS = "~|^$*";
+                    if (OPERATORS.find(text[i]) != std::string_view::npos)
+                    {
+                        switch (text[i++])
+                        {
+                        case '~':
+                            test.kind = test_kind_t::TOKEN;
+                            break;
+                        case '|':
+                            test.kind = test_kind_t::DASH;
+                            break;
+                        case '^':
+                            test.kind = test_kind_t::PREFIX;
+                            break;
+                        case '$':
+                            test.kind = test_kind_t::SUFFIX;
+                            break;
+                        default:
+                            test.kind = test_kind_t::SUBSTRING;
+                        }
+                    }
+                    else
+                        test.kind = test_kind_t::EQUALS;
+                    if (i >= text.size() || text[i++] != '=')
+                        return false;
+                    skipSpaces();
+                    if (!value(test.value))
+                        return false;
+                    skipSpaces();
+                }
+                if (i >= text.size() || text[i++] != ']')
+                    return false;
+                compound.tests.push_back(std::move(test));
+                return true;
+            }
+
+            bool pseudoClass(compound_t &compound)
+            {
+                ++i; // :
+                std::string_view pseudo;
+                if (!name(pseudo))
+                    return false;
+                test_t test{test_kind_t::NTH_CHILD, DOMsymbolTable::NO_SYMBOL, std::string(), 0, 1};
+                if (pseudo == "nth-child")
+                {
+                    if (i >= text.size() || text[i++] != '(')
+                        return false;
+                    std::size_t end = text.find(')', i);
+                    if (end == std::string_view::npos || !nth(text.substr(i, end - i), test.a, test.b))
+                        return false;
+                    i = end + 1;
+                }
+                else if (pseudo != "first-child")
+                    return false;
+                compound.tests.push_back(std::move(test));
+                return true;
+            }
+
+            bool compound(compound_t &compound)
+            {
+                std::string_view parsed;
+                bool any = false;
+                if (i < text.size() && text[i] == '*')
+                {
+                    ++i;
+                    any = true;
+                }
+                else if (name(parsed))
+                {
+                    compound.tag = symbols.intern(parsed);
+                    any = true;
+                }
+
+                while (i < text.size())
+                {
+                    char c = text[i];
+                    if (c == '#' || c == '.')
+                    {
+                        ++i;
+                        if (!name(parsed))
+                            return false;
+                        if (c == '#')
+                        {
+                            compound.id = std::string(parsed);
+                            compound.tests.push_back(
+                                {test_kind_t::EQUALS, symbols.intern("id"), std::string(parsed), 0, 0});
+                        }
+                        else
+                            compound.tests.push_back(
+                                {test_kind_t::TOKEN, symbols.intern("class"), std::string(parsed), 0, 0});
+                    }
+                    else if (c == '[')
+                    {
+                        if (!attribute(compound))
+                            return false;
+                    }
+                    else if (c == ':')
+                    {
+                        if (!pseudoClass(compound))
+                            return false;
+                    }
+                    else
+                        break;
+                    any = true;
+                }
+                return any;
+            }
+
+        public:
+            parser_t(std::string_view text, DOMsymbolTable &symbols) : text(text), symbols(symbols) {}
+
+            /**
+             *  @brief  Parses the whole text into the program.
+             * */
+            bool parse(std::vector<std::vector<compound_t>> &program)
+            {
+                while (true)
+                {
+                    std::vector<compound_t> compounds; // left to right here
+                    skipSpaces();
+                    while (true)
+                    {
+                        compounds.emplace_back();
+                        if (!compound(compounds.back()))
+                            return false;
+                        bool spaces = skipSpaces();
+                        if (i >= text.size() || text[i] == ',')
+                            break;
+                        if (text[i] == '>')
+                        {
+                            ++i;
+                            skipSpaces();
+                            compounds.back().child = true;
+                        }
+                        else if (!spaces)
+                            return false;
+                    }
+                    // cheap tests first, kinds are declared by cost
+                    for (compound_t &c : compounds)
+                        std::stable_sort(c.tests.begin(), c.tests.end(), [](const test_t &x, const test_t &y)
+                                         { return x.kind < y.kind; });
+
+                    // store right to left, a compound keeps the combinator
+                    // which links it to the one on its left
+                    std::vector<compound_t> reversed(compounds.rbegin(), compounds.rend());
+                    for (std::size_t c = 0; c + 1 < reversed.size(); ++c)
+                        reversed[c].child = reversed[c + 1].child;
+                    reversed.back().child = false;
+                    program.push_back(std::move(reversed));
+
+                    if (i >= text.size())
+                        return true;
+                    ++i; // ,
+                }
+            }
+        };
+
+        explicit DOMselector(const DOMsymbolTable &symbols) : symbols(&symbols) {}
+
+        /**
+         *  @brief  Returns 1-based position of the node among the element
+         *          children of its parent.
+         * */
+        static int position(DOMtree &tree, const DOMnode &node)
+        {
+            int index = 1;
+            for (DOMnodeUID sibling = node.getPrevSibling(); sibling != -1;)
+            {
+                const DOMnode &previous = tree.getNode(sibling);
+                if (!previous.isInnerDataNode())
+                    ++index;
+                sibling = previous.getPrevSibling();
+            }
+            return index;
+        }
+
+        static bool test(DOMtree &tree, const DOMnode &node, const test_t &test)
+        {
+            if (test.kind == test_kind_t::NTH_CHILD)
+            {
+                int offset = position(tree, node) - test.b;
+                if (test.a == 0)
+                    return offset == 0;
+                return offset % test.a == 0 && offset / test.a >= 0;
+            }
+
+            const std::string_view *found = node.findAttribute(test.attribute);
+            if (!found)
+                return false;
+            std::string_view value = *found, expected = test.value;
+            switch (test.kind)
+            {
+            case test_kind_t::EXISTS:
+                return true;
+            case test_kind_t::EQUALS:
+                return value == expected;
+            case test_kind_t::TOKEN:
+                return DOMindex::containsToken(value, expected);
+            case test_kind_t::DASH:
+                return value == expected ||
+                       (value.size() > expected.size() && value.substr(0, expected.size()) == expected &&
+                        value[expected.size()] == '-');
+            case test_kind_t::PREFIX:
+                return !expected.empty() && value.substr(0, expected.size()) == expected;
+            case test_kind_t::SUFFIX:
+                return !expected.empty() && value.size() >= expected.size() &&
+                       value.substr(value.size() - expected.size()) == expected;
+            case test_kind_t::SUBSTRING:
+                return !expected.empty() && value.find(expected) != std::string_view::npos;
+            default:
+                return false;
+            }
+        }
+
+        static bool matchCompound(DOMtree &tree, const DOMnode &node, const compound_t &compound)
+        {
+            if (node.isInnerDataNode())
+                return false;
+            if (compound.tag != DOMsymbolTable::NO_SYMBOL && node.getTagSymbol() != compound.tag)
+                return false;
+            for (const test_t &t : compound.tests)
+                if (!test(tree, node, t))
+                    return false;
+            return true;
+        }
+
+        /**
+         *  @brief  Matches the node against compound c of the selector and
+         *          its ancestors against the compounds after c.
+         * */
+        static bool matchFrom(DOMtree &tree, const DOMnode &node, const std::vector<compound_t> &compounds,
+                              std::size_t c)
+        {
+            if (!matchCompound(tree, node, compounds[c]))
+                return false;
+            if (c + 1 == compounds.size())
+                return true;
+            if (compounds[c].child)
+                return node.getParent() != -1 && matchFrom(tree, tree.getNode(node.getParent()), compounds, c + 1);
+            for (DOMnodeUID ancestor = node.getParent(); ancestor != -1;)
+            {
+                const DOMnode &next = tree.getNode(ancestor);
+                if (matchFrom(tree, next, compounds, c + 1))
+                    return true;
+                ancestor = next.getParent();
+            }
+            return false;
+        }
+
+    public:
+        /**
+         *  @brief  Compiles the selector, interning the names it uses in the
+         *          symbol table. The selector matches nodes of the trees
+         *          using that table.
+         *  @param  text        the selector list
+         *  @param  symbols     symbol table of the trees to be queried
+         *  @return the compiled selector, nullptr if the text is invalid
+         * */
+        static std::shared_ptr<const DOMselector> compile(std::string_view text, DOMsymbolTable &symbols)
+        {
+            std::shared_ptr<DOMselector> selector(new DOMselector(symbols));
+            parser_t parser(text, symbols);
+            if (!parser.parse(selector->program))
+                return nullptr;
+            return selector;
+        }
+
+        /**
+         *  @brief  Returns the symbol table the selector was compiled with.
+         * */
+        inline const DOMsymbolTable &getSymbols() const
+        {
+            return *symbols;
+        }
+
+        /**
+         *  @brief  Checks if the node matches the selector. Ancestors of
+         *          the node are not limited to any subtree.
+         * */
+        bool matches(DOMtree &tree, DOMnodeUID uid) const
+        {
+            const DOMnode &node = tree.getNode(uid);
+            for (const auto &compounds : program)
+                if (matchFrom(tree, node, compounds, 0))
+                    return true;
+            return false;
+        }
+
+        /**
+         *  @brief  Collects the candidates of the selector from the indexes
+         *          of the tree: the node with the id, or the nodes with the
+         *          tag, of the rightmost compound of each selector of the list.
+         *  @return false if some selector has neither or there are no
+         *          matching indexes, candidates are then to be walked
+         * */
+        bool candidates(DOMtree &tree, std::vector<DOMnodeUID> &found) const
+        {
+            DOMindex *index = tree.getIndexes();
+            if (!index)
+                return false;
+            DOMsymbol idAttribute = symbols->find("id");
+            for (const auto &compounds : program)
+            {
+                const compound_t &last = compounds.front();
+                if (!last.id.empty() && idAttribute != DOMsymbolTable::NO_SYMBOL &&
+                    index->getIdAttribute() == idAttribute)
+                {
+                    DOMnodeUID uid = index->findId(last.id); // ids are taken as unique
+                    if (uid != -1)
+                        found.push_back(uid);
+                }
+                else if (last.tag != DOMsymbolTable::NO_SYMBOL && index->hasTags())
+                    index->findTag(last.tag, found);
+                else
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    /**
+     *  @brief  Runs selector queries over trees. Compiled selectors are
+     *          cached by their text, so a selector is compiled once however
+     *          many times it is run. Queries use the secondary indexes of the
+     *          tree when they hold the candidates, and split the walk of big
+     *          trees into subtree tasks run on the executor otherwise.
+     *
+     *          An engine can be shared by many threads, the trees queried
+     *          must not be modified during the queries. The interval labels
+     *          are refreshed once per query through
+     *          DOMtree::refreshIntervalLabels(), the rest of a query only
+     *          reads the tree. Cached selectors are bound to the symbol table
+     *          they were compiled with and are recompiled for trees with
+     *          another table, or once that table is destroyed.
+     * */
+    class DOMselectorEngine
+    {
+    private:
+        // trees with fewer nodes are walked by the calling thread
+        static constexpr std::int64_t PARALLEL_THRESHOLD = 16384;
+
+        // subtree tasks made per worker of the executor
+        static constexpr std::size_t TASKS_PER_WORKER = 4;
+
+        tf::Executor *executor;
+
+        std::mutex cacheMutex;
+
+        struct entry_t
+        {
+            std::shared_ptr<const DOMselector> selector;
+            std::weak_ptr<DOMsymbolTable> symbols; // table of the selector
+        };
+        std::unordered_map<std::string, entry_t> cache;
+
+        struct item_t
+        {
+            DOMnodeUID uid;
+            bool subtree; // the whole subtree, or only the node
+        };
+
+        /**
+         *  @brief  Calls f for every node of the subtree in pre-order, over
+         *          the sibling links.
+         * */
+        template <class F>
+        static void walk(DOMtree &tree, const DOMnode &root, F &&f)
+        {
+            const DOMnode *node = &root;
+            while (true)
+            {
+                f(*node);
+                if (node->getFirstChild() != -1)
+                {
+                    node = &tree.getNode(node->getFirstChild());
+                    continue;
+                }
+                while (node != &root && node->getNextSibling() == -1)
+                    node = &tree.getNode(node->getParent());
+                if (node == &root)
+                    return;
+                node = &tree.getNode(node->getNextSibling());
+            }
+        }
+
+        /**
+         *  @brief  Splits the subtree into items in document order, level
+         *          by level, until there are enough subtrees for the tasks.
+         * */
+        static std::vector<item_t> split(DOMtree &tree, DOMnodeUID root, std::size_t tasks)
+        {
+            std::vector<item_t> items{{root, true}};
+            for (std::size_t subtrees = 1; subtrees < tasks;)
+            {
+                std::vector<item_t> next;
+                subtrees = 0;
+                for (const item_t &item : items)
+                {
+                    const DOMnode &node = tree.getNode(item.uid);
+                    if (!item.subtree || node.getChildCount() == 0)
+                    {
+                        next.push_back(item);
+                        subtrees += item.subtree;
+                        continue;
+                    }
+                    next.push_back({item.uid, false});
+                    for (DOMnodeUID child : node.getChildrenUID())
+                        next.push_back({child, true});
+                    subtrees += node.getChildCount();
+                }
+                if (next.size() == items.size()) // only leaves left
+                    break;
+                items.swap(next);
+            }
+            return items;
+        }
+
+        /**
+         *  @brief  Body of querySelectorAll(), run with the labels refreshed.
+         *  @param  ordered if the pre labels order the nodes
+         * */
+        std::vector<DOMnodeUID> query(DOMtree &tree, const DOMselector &selector, DOMnodeUID root, bool ordered)
+        {
+            std::vector<DOMnodeUID> found;
+            std::vector<DOMnodeUID> candidates;
+            if (selector.candidates(tree, candidates) && (ordered || candidates.size() <= 1))
+            {
+                for (DOMnodeUID uid : candidates)
+                    if ((root == 0 || tree.isInSubtree(uid, root)) && selector.matches(tree, uid))
+                        found.push_back(uid);
+                if (ordered)
+                {
+                    auto pre = [&](DOMnodeUID a, DOMnodeUID b)
+                    { return tree.getNode(a).getPreLabel() < tree.getNode(b).getPreLabel(); };
+                    std::sort(found.begin(), found.end(), pre);
+                    found.erase(std::unique(found.begin(), found.end()), found.end());
+                }
+                return found;
+            }
+
+            auto collect = [&](std::vector<DOMnodeUID> &into)
+            {
+                return [&tree, &selector, &into](const DOMnode &node)
+                {
+                    if (selector.matches(tree, node.getUID()))
+                        into.push_back(node.getUID());
+                };
+            };
+            if (!executor || executor->num_workers() < 2 || tree.getNodeCount() < PARALLEL_THRESHOLD)
+            {
+                walk(tree, tree.getNode(root), collect(found));
+                return found;
+            }
+
+            // every subtree item is walked by a task, results are
+            // concatenated in the order of the items
+            std::vector<item_t> items = split(tree, root, TASKS_PER_WORKER * executor->num_workers());
+            std::vector<std::vector<DOMnodeUID>> results(items.size());
+            tf::Taskflow taskflow;
+            for (std::size_t i = 0; i < items.size(); ++i)
+            {
+                if (!items[i].subtree)
+                    continue;
+                taskflow.emplace([&, i]() { walk(tree, tree.getNode(items[i].uid), collect(results[i])); });
+            }
+            executor->run(taskflow).wait();
+
+            for (std::size_t i = 0; i < items.size(); ++i)
+            {
+                if (!items[i].subtree && selector.matches(tree, items[i].uid))
+                    found.push_back(items[i].uid);
+                found.insert(found.end(), results[i].begin(), results[i].end());
+            }
+            return found;
+        }
+
+    public:
+        /**
+         *  @brief  Constructor
+         *  @param  executor    executor to run the walks of big trees on,
+         *                      nullptr to walk in the calling thread
+         * */
+        explicit DOMselectorEngine(tf::Executor *executor = nullptr) : executor(executor) {}
+
+        /**
+         *  @brief  Returns the compiled selector, compiling it on the first
+         *          use with the symbol table only.
+         *  @param  text    the selector
+         *  @param  symbols symbol table of the trees to be queried, as given
+         *                  by DOMtree::shareSymbols()
+         *  @return nullptr if the selector is invalid
+         * */
+        std::shared_ptr<const DOMselector> compile(std::string_view text, const std::shared_ptr<DOMsymbolTable> &symbols)
+        {
+            std::string key(text);
+            {
+                std::lock_guard<std::mutex> lock(cacheMutex);
+                auto i = cache.find(key);
+                // a destroyed table may be followed by another one at the
+                // same address, so tables are compared while held
+                if (i != cache.end() && i->second.symbols.lock() == symbols)
+                    return i->second.selector;
+            }
+            std::shared_ptr<const DOMselector> selector = DOMselector::compile(text, *symbols);
+            if (selector)
+            {
+                std::lock_guard<std::mutex> lock(cacheMutex);
+                cache[std::move(key)] = {selector, symbols};
+            }
+            return selector;
+        }
+
+        /**
+         *  @brief  Drops the cached selectors.
+         * */
+        void clearCache()
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            cache.clear();
+        }
+
+        /**
+         *  @brief  Returns the nodes in the subtree of root, root included,
+         *          which match the selector, in document order.
+         *
+         *          Candidates are taken from the secondary indexes of the tree
+         *          when the rightmost compounds name an id or a tag which are
+         *          indexed, and the order of the candidates can be told, that
+         *          is, interval labels are enabled or there is at most one.
+         *          Otherwise the subtree is walked, split into subtree tasks on
+         *          the executor when the tree is big.
+         * @param   tree        the tree
+         * @param   selector    the compiled selector
+         * @param   root        UID of the root of the subtree to search
+         * */
+        std::vector<DOMnodeUID> querySelectorAll(DOMtree &tree, const DOMselector &selector, DOMnodeUID root = 0)
+        {
+            if (!tree.isValid(root))
+                return std::vector<DOMnodeUID>();
+            return query(tree, selector, root, tree.refreshIntervalLabels());
+        }
+
+        /**
+         *  @brief  Returns the nodes in the subtree of root, root included,
+         *          which match the selector, in document order.
+         *  @return empty if the selector is invalid
+         * */
+        std::vector<DOMnodeUID> querySelectorAll(DOMtree &tree, std::string_view selector, DOMnodeUID root = 0)
+        {
+            std::shared_ptr<const DOMselector> compiled = compile(selector, tree.shareSymbols());
+            if (!compiled)
+                return std::vector<DOMnodeUID>();
+            return querySelectorAll(tree, *compiled, root);
+        }
+
+        /**
+         *  @brief  Returns the first node in document order in the subtree
+         *          of root, root included, which matches the selector.
+         *  @return -1 if there is none or the selector is invalid
+         * */
+        DOMnodeUID querySelector(DOMtree &tree, std::string_view selector, DOMnodeUID root = 0)
+        {
+            std::shared_ptr<const DOMselector> compiled = compile(selector, tree.shareSymbols());
+            if (!compiled || !tree.isValid(root))
+                return -1;
+
+            bool ordered = tree.refreshIntervalLabels();
+            std::vector<DOMnodeUID> candidates;
+            if (compiled->candidates(tree, candidates) && (ordered || candidates.size() <= 1))
+            {
+                std::vector<DOMnodeUID> found = query(tree, *compiled, root, ordered);
+                return (found.empty() ? -1 : found.front());
+            }
+
+            // walks until the first match
+            const DOMnode *node = &tree.getNode(root);
+            while (true)
+            {
+                if (compiled->matches(tree, node->getUID()))
+                    return node->getUID();
+                if (node->getFirstChild() != -1)
+                {
+                    node = &tree.getNode(node->getFirstChild());
+                    continue;
+                }
+                while (node->getUID() != root && node->getNextSibling() == -1)
+                    node = &tree.getNode(node->getParent());
+                if (node->getUID() == root)
+                    return -1;
+                node = &tree.getNode(node->getNextSibling());
+            }
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
@@ -0,0 +1,850 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_SNAPSHOT
+#define DOM_PARSER_DOM_SNAPSHOT
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "DOMsymbols.hpp"
+#include "DOMtree.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Epoch based reclamation. Readers pin the current epoch while
+     *          they use shared data, the writer retires old data with the
+     *          epoch in which it was unlinked and frees it only once every
+     *          pinned reader has entered a later epoch.
+     *
+     *          Pinning and unpinning are lock-free, readers never wait.
+     * */
+    class DOMepochManager
+    {
+    private:
+        static constexpr std::uint64_t IDLE = ~std::uint64_t(0);
+        static constexpr int BLOCK_SLOTS = 64;
+        static constexpr int MAX_BLOCKS = 64;
+
+        struct alignas(64) slot_t
+        {
+            std::atomic<std::uint64_t> epoch{IDLE};
+        };
+
+        std::atomic<slot_t *> blocks[MAX_BLOCKS];
+        std::atomic<std::uint64_t> globalEpoch{0};
+
+        /**
+         *  @brief  Returns the block of slots, allocating it if required.
+         * */
+        slot_t *getBlock(int b)
+        {
+            slot_t *block = blocks[b].load(std::memory_order_acquire);
+            if (block)
+                return block;
+
+            slot_t *fresh = new slot_t[BLOCK_SLOTS];
+            if (blocks[b].compare_exchange_strong(block, fresh, std::memory_order_acq_rel))
+                return fresh;
+            delete[] fresh; // other thread was faster
+            return block;
+        }
+
+    public:
+        typedef std::atomic<std::uint64_t> *pin_t;
+
+        DOMepochManager()
+        {
+            for (auto &block : blocks)
+                block.store(nullptr, std::memory_order_relaxed);
+        }
+
+        DOMepochManager(const DOMepochManager &) = delete;
+        DOMepochManager &operator=(const DOMepochManager &) = delete;
+
+        ~DOMepochManager()
+        {
+            for (auto &block : blocks)
+                delete[] block.load(std::memory_order_relaxed);
+        }
+
+        /**
+         *  @brief  Pins an epoch for the calling reader.
+         *  @param  epoch   epoch to pin, IDLE for the current epoch. An older
+         *                  epoch may only be pinned while another pin of it
+         *                  is held.
+         *  @return the pin, to be released with unpin()
+         * */
+        pin_t pin(std::uint64_t epoch = IDLE)
+        {
+            for (int b = 0; b < MAX_BLOCKS; ++b)
+            {
+                slot_t *block = getBlock(b);
+                for (int i = 0; i < BLOCK_SLOTS; ++i)
+                {
+                    std::uint64_t idle = IDLE;
+                    std::uint64_t e = (epoch == IDLE ? globalEpoch.load() : epoch);
+                    if (block[i].epoch.load(std::memory_order_relaxed) == IDLE &&
+                        block[i].epoch.compare_exchange_strong(idle, e))
+                        return &block[i].epoch;
+                }
+            }
+            throw std::length_error("DOMepochManager: too many pinned readers");
+        }
+
+        /**
+         *  @brief  Returns the epoch held by the pin.
+         * */
+        static inline std::uint64_t pinnedEpoch(pin_t pin)
+        {
+            return pin->load(std::memory_order_relaxed);
+        }
+
+        /**
+         *  @brief  Releases the pin.
+         * */
+        static inline void unpin(pin_t pin)
+        {
+            pin->store(IDLE, std::memory_order_release);
+        }
+
+        /**
+         *  @brief  Starts a new epoch.
+         *  @return the epoch which just ended, data unlinked before this call
+         *          is retired with it.
+         * */
+        inline std::uint64_t advance()
+        {
+            return globalEpoch.fetch_add(1);
+        }
+
+        /**
+         *  @brief  Checks if data retired in the given epoch can be freed,
+         *          that is, no reader pinned that epoch or an older one.
+         * */
+        bool isQuiescent(std::uint64_t retireEpoch)
+        {
+            for (int b = 0; b < MAX_BLOCKS; ++b)
+            {
+                slot_t *block = blocks[b].load(std::memory_order_acquire);
+                if (!block)
+                    break;
+                for (int i = 0; i < BLOCK_SLOTS; ++i)
+                    if (block[i].epoch.load() <= retireEpoch)
+                        return false;
+            }
+            return true;
+        }
+    };
+
+    /**
+     *  @brief  Immutable node of a persistent (versioned) tree. Nodes are
+     *          shared between versions, a new version copies only the nodes
+     *          on the paths to the changed nodes.
+     *
+     *          Children are kept in chunks of at most CHUNK_SIZE nodes, which
+     *          are shared between versions too: copying a node copies the
+     *          references to its chunks, and changing a child copies only
+     *          the chunk holding it. Every child has a rank, increasing along
+     *          the children and never reused by the parent, by which the
+     *          writer finds it in O(log(children)).
+     * */
+    class DOMpersistentNode
+    {
+        friend class DOMversionedTree;
+
+    public:
+        static constexpr std::size_t CHUNK_SIZE = 64;
+
+    private:
+        struct child_t
+        {
+            std::uint64_t rank;
+            std::shared_ptr<const DOMpersistentNode> node;
+        };
+
+        struct chunk_t
+        {
+            std::vector<child_t> children;
+            std::uint64_t version;
+        };
+
+        struct chunk_ref_t
+        {
+            std::shared_ptr<const chunk_t> chunk;
+            std::size_t end;         // number of children up to the end of the chunk
+            std::uint64_t lastRank;  // rank of the last child of the chunk
+        };
+
+        DOMnodeUID uid;
+        DOMsymbol tagName;
+        bool innerDataNode;
+        std::string innerData;
+        std::vector<std::pair<DOMsymbol, std::string>> attributes;
+        std::vector<chunk_ref_t> chunks; // none of them empty
+        std::uint64_t nextRank = 0;
+
+        // version which created the node or the chunk, the writer modifies in
+        // place only the nodes and chunks of the version it is building
+        std::uint64_t version;
+
+        /**
+         *  @brief  Returns the index of the chunk which holds the child of
+         *          the rank if there is one, chunks.size() if the rank is past
+         *          the last child.
+         * */
+        std::size_t findChunk(std::uint64_t rank) const
+        {
+            auto i = std::lower_bound(chunks.begin(), chunks.end(), rank,
+                                      [](const chunk_ref_t &chunk, std::uint64_t r) { return chunk.lastRank < r; });
+            return std::size_t(i - chunks.begin());
+        }
+
+    public:
+        DOMpersistentNode(DOMnodeUID uid, DOMsymbol tagName, bool innerDataNode, std::uint64_t version)
+            : uid(uid), tagName(tagName), innerDataNode(innerDataNode), version(version) {}
+
+        inline DOMnodeUID getUID() const
+        {
+            return uid;
+        }
+
+        /**
+         *  @brief  Returns interned tag name, NO_SYMBOL for inner-data nodes.
+         * */
+        inline DOMsymbol getTagSymbol() const
+        {
+            return tagName;
+        }
+
+        inline bool isInnerDataNode() const
+        {
+            return innerDataNode;
+        }
+
+        inline const std::string &getInnerData() const
+        {
+            return innerData;
+        }
+
+        /**
+         *  @brief  Returns pointer to value of the attribute, nullptr if the
+         *          attribute does not exist.
+         *  @param  attribute   interned name of the attribute
+         * */
+        const std::string *findAttribute(DOMsymbol attribute) const
+        {
+            for (const auto &i : attributes)
+                if (i.first == attribute)
+                    return &i.second;
+            return nullptr;
+        }
+
+        /**
+         *  @brief  Returns all attributes as {interned name, value} pairs.
+         * */
+        inline const std::vector<std::pair<DOMsymbol, std::string>> &getAllAttributes() const
+        {
+            return attributes;
+        }
+
+        inline std::size_t getChildCount() const
+        {
+            return (chunks.empty() ? 0 : chunks.back().end);
+        }
+
+        /**
+         *  @brief  Returns the i-th child, in O(log(children)).
+         * */
+        const DOMpersistentNode *getChild(std::size_t i) const
+        {
+            if (chunks.size() == 1)
+                return chunks.front().chunk->children[i].node.get();
+            auto chunk = std::upper_bound(chunks.begin(), chunks.end(), i,
+                                          [](std::size_t n, const chunk_ref_t &c) { return n < c.end; });
+            std::size_t begin = (chunk == chunks.begin() ? 0 : std::prev(chunk)->end);
+            return chunk->chunk->children[i - begin].node.get();
+        }
+    };
+
+    /**
+     *  @brief  Immutable view of one version of a DOMversionedTree. Taking a
+     *          snapshot is O(1) and lock-free, the version stays valid and
+     *          unchanged as long as the snapshot is held, whatever the writer
+     *          does meanwhile. Snapshots must be released before the tree
+     *          they were taken from is destroyed.
+     * */
+    class DOMsnapshot
+    {
+        friend class DOMversionedTree;
+
+    public:
+        struct version_t
+        {
+            std::shared_ptr<const DOMpersistentNode> root;
+            std::uint64_t number;
+        };
+
+    private:
+        DOMepochManager *epochs = nullptr;
+        DOMepochManager::pin_t pin = nullptr;
+        const version_t *version = nullptr;
+        const DOMsymbolTable *symbols = nullptr;
+
+        DOMsnapshot(DOMepochManager *epochs, DOMepochManager::pin_t pin,
+                    const version_t *version, const DOMsymbolTable *symbols)
+            : epochs(epochs), pin(pin), version(version), symbols(symbols) {}
+
+    public:
+        DOMsnapshot() {}
+
+        DOMsnapshot(const DOMsnapshot &other)
+            : epochs(other.epochs), version(other.version), symbols(other.symbols)
+        {
+            if (other.pin)
+                pin = epochs->pin(DOMepochManager::pinnedEpoch(other.pin));
+        }
+
+        DOMsnapshot(DOMsnapshot &&other)
+            : epochs(other.epochs), pin(other.pin), version(other.version), symbols(other.symbols)
+        {
+            other.pin = nullptr;
+        }
+
+        DOMsnapshot &operator=(DOMsnapshot other)
+        {
+            std::swap(epochs, other.epochs);
+            std::swap(pin, other.pin);
+            std::swap(version, other.version);
+            std::swap(symbols, other.symbols);
+            return *this;
+        }
+
+        ~DOMsnapshot()
+        {
+            if (pin)
+                DOMepochManager::unpin(pin);
+        }
+
+        /**
+         *  @brief  Returns the root node of the version.
+         * */
+        inline const DOMpersistentNode *getRoot() const
+        {
+            return version->root.get();
+        }
+
+        /**
+         *  @brief  Returns the number of the version, increasing with commits.
+         * */
+        inline std::uint64_t getVersion() const
+        {
+            return version->number;
+        }
+
+        /**
+         *  @brief  Returns tag name of the node, empty for inner-data nodes.
+         * */
+        inline const std::string &getTagName(const DOMpersistentNode &node) const
+        {
+            static const std::string noName;
+            return (node.isInnerDataNode() ? noName : symbols->name(node.getTagSymbol()));
+        }
+
+        /**
+         *  @brief  Returns value of the attribute, empty string if it does
+         *          not exist.
+         * */
+        std::string_view getAttribute(const DOMpersistentNode &node, std::string_view attribute) const
+        {
+            const std::string *value = node.findAttribute(symbols->find(attribute));
+            return (value ? std::string_view(*value) : std::string_view());
+        }
+
+        /**
+         *  @brief  Returns the symbol table the names are interned in.
+         * */
+        inline const DOMsymbolTable &getSymbols() const
+        {
+            return *symbols;
+        }
+    };
+
+    /**
+     *  @brief  Multi-version tree for one writer and many concurrent readers.
+     *
+     *          Readers take snapshots which are never blocked and never see
+     *          partial updates. The writer edits a private working version,
+     *          path-copying only the nodes it changes (all the other nodes
+     *          are shared with older versions), and publishes it atomically
+     *          with commit(). Old versions are retired through epoch based
+     *          reclamation and freed once no snapshot can refer to them.
+     *
+     *          All the writer methods must be called from one thread at a
+     *          time, snapshot() may be called from any thread.
+     *
+     *          DOMtree itself takes no snapshots: its nodes are edited in
+     *          place through the slot table, which readers would see half
+     *          done. A versioned tree is instead started from a DOMtree,
+     *          keeping its UIDs, and edited through the same operations
+     *          (attributes, inner data, adding, moving and deleting subtrees).
+     * */
+    class DOMversionedTree
+    {
+    private:
+        typedef DOMsnapshot::version_t version_t;
+        typedef DOMpersistentNode::chunk_t chunk_t;
+        typedef DOMpersistentNode::child_t child_t;
+        typedef std::shared_ptr<const DOMpersistentNode> node_ptr_t;
+
+        // parent of a node of the working version and rank of the node among
+        // the children of the parent
+        struct place_t
+        {
+            DOMnodeUID parent;
+            std::uint64_t rank;
+        };
+
+        std::shared_ptr<DOMsymbolTable> symbols;
+        DOMepochManager epochs;
+        std::atomic<const version_t *> current;
+        std::vector<std::pair<std::uint64_t, const version_t *>> retired;
+        std::uint64_t versionCounter = 0;
+
+        // writer state
+        std::shared_ptr<DOMpersistentNode> working;
+        std::unordered_map<DOMnodeUID, place_t> places;
+        DOMnodeUID nextUID = 0;
+
+        /**
+         *  @brief  Returns a copy of the node belonging to working version.
+         * */
+        std::shared_ptr<DOMpersistentNode> copyNode(const DOMpersistentNode &node)
+        {
+            auto copy = std::make_shared<DOMpersistentNode>(node);
+            copy->version = versionCounter;
+            return copy;
+        }
+
+        /**
+         *  @brief  Returns the chunk of children of the node, first copied
+         *          into the working version if it belongs to an older one.
+         *          The node must belong to the working version.
+         * */
+        chunk_t *writableChunk(DOMpersistentNode &node, std::size_t c)
+        {
+            auto &ref = node.chunks[c];
+            if (ref.chunk->version != versionCounter)
+            {
+                auto copy = std::make_shared<chunk_t>(*ref.chunk);
+                copy->version = versionCounter;
+                ref.chunk = std::move(copy);
+            }
+            // chunks of the working version are not visible to readers
+            return const_cast<chunk_t *>(ref.chunk.get());
+        }
+
+        /**
+         *  @brief  Returns the position of the child of the rank in the chunk.
+         * */
+        static inline std::vector<child_t>::iterator findChild(chunk_t &chunk, std::uint64_t rank)
+        {
+            return std::lower_bound(chunk.children.begin(), chunk.children.end(), rank,
+                                    [](const child_t &child, std::uint64_t r) { return child.rank < r; });
+        }
+
+        /**
+         *  @brief  Returns the reference to the child of the rank, in a
+         *          chunk of the working version.
+         * */
+        inline node_ptr_t &childOf(DOMpersistentNode &node, std::uint64_t rank)
+        {
+            return findChild(*writableChunk(node, node.findChunk(rank)), rank)->node;
+        }
+
+        /**
+         *  @brief  Adds the child after the last child of the node.
+         *  @return rank of the child
+         * */
+        std::uint64_t appendChild(DOMpersistentNode &node, node_ptr_t child)
+        {
+            std::uint64_t rank = node.nextRank++;
+            if (node.chunks.empty() || node.chunks.back().chunk->children.size() == DOMpersistentNode::CHUNK_SIZE)
+            {
+                auto chunk = std::make_shared<chunk_t>();
+                chunk->version = versionCounter;
+                node.chunks.push_back({std::move(chunk), node.getChildCount(), rank});
+            }
+            chunk_t *chunk = writableChunk(node, node.chunks.size() - 1);
+            chunk->children.push_back({rank, std::move(child)});
+            ++node.chunks.back().end;
+            node.chunks.back().lastRank = rank;
+            return rank;
+        }
+
+        /**
+         *  @brief  Merges the chunk c + 1 into the chunk c.
+         * */
+        void mergeChunks(DOMpersistentNode &node, std::size_t c)
+        {
+            chunk_t *chunk = writableChunk(node, c);
+            const chunk_t &next = *node.chunks[c + 1].chunk;
+            chunk->children.insert(chunk->children.end(), next.children.begin(), next.children.end());
+            node.chunks[c].end = node.chunks[c + 1].end;
+            node.chunks[c].lastRank = node.chunks[c + 1].lastRank;
+            node.chunks.erase(node.chunks.begin() + std::ptrdiff_t(c + 1));
+        }
+
+        /**
+         *  @brief  Removes the child of the rank from the node. The chunk it
+         *          was in is merged with a neighbour if they fit in one, so
+         *          any two neighbouring chunks hold more than CHUNK_SIZE
+         *          children.
+         *  @return the child
+         * */
+        node_ptr_t removeChild(DOMpersistentNode &node, std::uint64_t rank)
+        {
+            std::size_t c = node.findChunk(rank);
+            chunk_t *chunk = writableChunk(node, c);
+            auto i = findChild(*chunk, rank);
+            node_ptr_t child = std::move(i->node);
+            chunk->children.erase(i);
+            for (std::size_t j = c; j < node.chunks.size(); ++j)
+                --node.chunks[j].end;
+
+            auto size = [&](std::size_t j) { return node.chunks[j].chunk->children.size(); };
+            if (chunk->children.empty())
+                node.chunks.erase(node.chunks.begin() + std::ptrdiff_t(c));
+            else if (c + 1 < node.chunks.size() && size(c) + size(c + 1) <= DOMpersistentNode::CHUNK_SIZE)
+                mergeChunks(node, c);
+            else if (c > 0 && size(c - 1) + size(c) <= DOMpersistentNode::CHUNK_SIZE)
+                mergeChunks(node, c - 1);
+            return child;
+        }
+
+        /**
+         *  @brief  Returns the node with given UID in the working version,
+         *          copying the nodes on the path from the root to it, and the
+         *          chunks holding them, if they belong to older versions, in
+         *          O(depth * (CHUNK_SIZE + children / CHUNK_SIZE)). nullptr if
+         *          node does not exist.
+         * */
+        DOMpersistentNode *writable(DOMnodeUID uid)
+        {
+            auto place = places.find(uid);
+            if (place == places.end())
+                return nullptr;
+
+            if (!working)
+            {
+                ++versionCounter;
+                working = copyNode(*current.load(std::memory_order_relaxed)->root);
+            }
+
+            std::vector<std::uint64_t> ranks; // of the nodes from the node up to the root
+            for (; place->second.parent != -1; place = places.find(place->second.parent))
+                ranks.push_back(place->second.rank);
+
+            DOMpersistentNode *node = working.get();
+            for (auto rank = ranks.rbegin(); rank != ranks.rend(); ++rank)
+            {
+                node_ptr_t &child = childOf(*node, *rank);
+                if (child->version != versionCounter)
+                    child = copyNode(*child);
+                // nodes of the working version are not visible to readers
+                node = const_cast<DOMpersistentNode *>(child.get());
+            }
+            return node;
+        }
+
+        /**
+         *  @brief  Frees the retired versions no snapshot can refer to.
+         * */
+        void collect()
+        {
+            std::size_t kept = 0;
+            for (auto &i : retired)
+            {
+                if (epochs.isQuiescent(i.first))
+                    delete i.second;
+                else
+                    retired[kept++] = i;
+            }
+            retired.resize(kept);
+        }
+
+        /**
+         *  @brief  Forgets the parents of all nodes of the subtree.
+         * */
+        void forgetSubtree(const DOMpersistentNode &subtree_root)
+        {
+            std::vector<const DOMpersistentNode *> stack{&subtree_root};
+            while (!stack.empty())
+            {
+                const DOMpersistentNode *node = stack.back();
+                stack.pop_back();
+                places.erase(node->uid);
+                for (const auto &chunk : node->chunks)
+                    for (const auto &child : chunk.chunk->children)
+                        stack.push_back(child.node.get());
+            }
+        }
+
+    public:
+        /**
+         *  @brief  Constructor, the first version is a copy of the tree.
+         *  @param  tree    the tree to start with, its UIDs are kept
+         * */
+        explicit DOMversionedTree(const DOMtree &tree)
+            : symbols(tree.shareSymbols())
+        {
+            // build bottom-up, children before their parent
+            std::vector<std::pair<DOMnodeUID, bool>> stack{{0, false}};
+            std::unordered_map<DOMnodeUID, std::shared_ptr<DOMpersistentNode>> built;
+            while (!stack.empty())
+            {
+                auto [uid, expanded] = stack.back();
+                const DOMnode &node = tree.getNode(uid);
+                if (!expanded)
+                {
+                    stack.back().second = true;
+                    for (DOMnodeUID child : node.getChildrenUID())
+                        stack.push_back({child, false});
+                    continue;
+                }
+                stack.pop_back();
+
+                auto copy = std::make_shared<DOMpersistentNode>(
+                    uid, node.getTagSymbol(), node.isInnerDataNode(), versionCounter);
+                copy->innerData = node.getInnerData();
+                for (const auto &attribute : node.getAllAttributes())
+                    copy->attributes.emplace_back(symbols->find(attribute.first), attribute.second);
+                for (DOMnodeUID child : node.getChildrenUID())
+                {
+                    places[child] = {uid, appendChild(*copy, std::move(built[child]))};
+                    built.erase(child);
+                }
+                nextUID = std::max(nextUID, uid + 1);
+                built[uid] = std::move(copy);
+            }
+            places[0] = {-1, 0};
+            current.store(new version_t{std::move(built[0]), versionCounter});
+        }
+
+        DOMversionedTree(const DOMversionedTree &) = delete;
+        DOMversionedTree &operator=(const DOMversionedTree &) = delete;
+
+        /**
+         *  @brief  Destructor, all snapshots must have been released.
+         * */
+        ~DOMversionedTree()
+        {
+            for (auto &i : retired)
+                delete i.second;
+            delete current.load();
+        }
+
+        /**
+         *  @brief  Returns snapshot of the latest committed version in O(1).
+         *          Lock-free, can be called from any thread.
+         * */
+        DOMsnapshot snapshot()
+        {
+            DOMepochManager::pin_t pin = epochs.pin();
+            const version_t *version = current.load();
+            return DOMsnapshot(&epochs, pin, version, symbols.get());
+        }
+
+        /**
+         *  @brief  Publishes the working version, readers taking a snapshot
+         *          afterwards see all the changes made since the last commit.
+         *  @return number of the committed version
+         * */
+        std::uint64_t commit()
+        {
+            if (working)
+            {
+                const version_t *old = current.exchange(new version_t{std::move(working), versionCounter});
+                retired.emplace_back(epochs.advance(), old);
+                working.reset();
+            }
+            collect();
+            return current.load(std::memory_order_relaxed)->number;
+        }
+
+        /**
+         *  @brief  Sets a new value to existing attribute or adds a new one.
+         *  @return false if node does not exist or is an inner-data node
+         * */
+        bool setAttribute(DOMnodeUID uid, std::string_view attribute, std::string_view value)
+        {
+            DOMpersistentNode *node = writable(uid);
+            if (!node || node->innerDataNode)
+                return false;
+
+            DOMsymbol name = symbols->intern(attribute);
+            for (auto &i : node->attributes)
+            {
+                if (i.first == name)
+                {
+                    i.second = value;
+                    return true;
+                }
+            }
+            node->attributes.emplace_back(name, value);
+            return true;
+        }
+
+        /**
+         *  @brief  Removes the attribute if it exists.
+         *  @return false if node does not exist
+         * */
+        bool removeAttribute(DOMnodeUID uid, std::string_view attribute)
+        {
+            DOMpersistentNode *node = writable(uid);
+            if (!node)
+                return false;
+
+            DOMsymbol name = symbols->find(attribute);
+            for (auto i = node->attributes.begin(); i != node->attributes.end(); ++i)
+            {
+                if (i->first == name)
+                {
+                    node->attributes.erase(i);
+                    break;
+                }
+            }
+            return true;
+        }
+
+        /**
+         *  @brief  Replaces the data of an inner-data node.
+         *  @return false if node does not exist or is not an inner-data node
+         * */
+        bool setInnerData(DOMnodeUID uid, std::string_view data)
+        {
+            DOMpersistentNode *node = writable(uid);
+            if (!node || !node->innerDataNode)
+                return false;
+            node->innerData = data;
+            return true;
+        }
+
+        /**
+         *  @brief  Adds a node as the last child of the parent.
+         *  @return UID of the new node, -1 if parent does not exist
+         * */
+        DOMnodeUID addNode(DOMnodeUID parent, std::string_view tagName)
+        {
+            DOMpersistentNode *node = writable(parent);
+            if (!node || node->innerDataNode)
+                return -1;
+
+            DOMnodeUID uid = nextUID++;
+            places[uid] = {parent, appendChild(*node, std::make_shared<DOMpersistentNode>(
+                                                          uid, symbols->intern(tagName), false, versionCounter))};
+            return uid;
+        }
+
+        /**
+         *  @brief  Adds an inner-data node as the last child of the parent.
+         *  @return UID of the new node, -1 if parent does not exist
+         * */
+        DOMnodeUID addInnerDataNode(DOMnodeUID parent, std::string_view data)
+        {
+            DOMpersistentNode *node = writable(parent);
+            if (!node || node->innerDataNode)
+                return -1;
+
+            DOMnodeUID uid = nextUID++;
+            auto child = std::make_shared<DOMpersistentNode>(
+                uid, DOMsymbolTable::NO_SYMBOL, true, versionCounter);
+            child->innerData = data;
+            places[uid] = {parent, appendChild(*node, std::move(child))};
+            return uid;
+        }
+
+        /**
+         *  @brief  Deletes the subtree from the working version. Older versions
+         *          and the snapshots of them keep it.
+         *  @return false if the node does not exist or is the root
+         * */
+        bool deleteSubtree(DOMnodeUID subtree_root)
+        {
+            auto place = places.find(subtree_root);
+            if (place == places.end() || place->second.parent == -1)
+                return false;
+
+            DOMpersistentNode *parent = writable(place->second.parent);
+            node_ptr_t subtree = removeChild(*parent, place->second.rank);
+            forgetSubtree(*subtree);
+            return true;
+        }
+
+        /**
+         *  @brief  Moves the subtree to be the last child of the new parent.
+         *          The nodes of the subtree are not copied, older versions and
+         *          the snapshots of them keep it at its former place.
+         *  @return false if either node does not exist, the subtree is the
+         *          root, or the new parent is an inner-data node or lies in
+         *          the subtree
+         * */
+        bool moveSubtree(DOMnodeUID subtree_root, DOMnodeUID new_parent)
+        {
+            auto place = places.find(subtree_root);
+            if (place == places.end() || place->second.parent == -1 || !exists(new_parent))
+                return false;
+            for (DOMnodeUID node = new_parent; node != -1; node = places.find(node)->second.parent)
+                if (node == subtree_root)
+                    return false;
+
+            DOMpersistentNode *target = writable(new_parent);
+            if (target->innerDataNode)
+                return false;
+            DOMpersistentNode *parent = writable(place->second.parent);
+            node_ptr_t subtree = removeChild(*parent, place->second.rank);
+            place->second = {new_parent, appendChild(*target, std::move(subtree))};
+            return true;
+        }
+
+        /**
+         *  @brief  Checks if the node exists in the working version.
+         * */
+        inline bool exists(DOMnodeUID uid) const
+        {
+            return places.find(uid) != places.end();
+        }
+
+        /**
+         *  @brief  Returns the symbol table the names are interned in.
+         * */
+        inline DOMsymbolTable &getSymbols() const
+        {
+            return *symbols;
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
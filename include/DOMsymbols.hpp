@@ -0,0 +1,150 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_SYMBOLS
+#define DOM_PARSER_DOM_SYMBOLS
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace dom_parser
+{
+    /// @brief   Integer id of an interned name.
+    typedef std::uint32_t DOMsymbol;
+
+    /**
+     *  @brief  Table of interned tag and attribute names. Every distinct
+     *          name is stored once and identified by a DOMsymbol, so equal
+     *          names compare as equal integers.
+     *
+     *          A table can be shared by many trees (for example all the
+     *          documents of a batch) and by many threads. Interning takes a
+     *          lock, reading a name by its id does not.
+     * */
+    class DOMsymbolTable
+    {
+    private:
+        // names are stored in chunks of growing size which never move,
+        // chunk k holds FIRST_CHUNK << k names
+        static constexpr std::uint32_t FIRST_CHUNK = 64;
+        static constexpr int MAX_CHUNKS = 26;
+
+        std::atomic<std::string *> chunks[MAX_CHUNKS];
+        std::atomic<std::uint32_t> count;
+
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string_view, DOMsymbol> ids;
+
+        /**
+         *  @brief  Finds chunk and offset in the chunk of the id.
+         * */
+        static inline void locate(DOMsymbol id, int &chunk, std::uint32_t &offset)
+        {
+            std::uint64_t i = std::uint64_t(id) + FIRST_CHUNK;
+            chunk = 63 - __builtin_clzll(i) - 6; // 6 = log2(FIRST_CHUNK)
+            offset = std::uint32_t(i - (std::uint64_t(FIRST_CHUNK) << chunk));
+        }
+
+    public:
+        /// @brief   Id returned for names which are not in the table.
+        static constexpr DOMsymbol NO_SYMBOL = 0xFFFFFFFF;
+
+        DOMsymbolTable() : count(0)
+        {
+            for (auto &chunk : chunks)
+                chunk.store(nullptr, std::memory_order_relaxed);
+        }
+
+        DOMsymbolTable(const DOMsymbolTable &) = delete;
+        DOMsymbolTable &operator=(const DOMsymbolTable &) = delete;
+
+        ~DOMsymbolTable()
+        {
+            for (auto &chunk : chunks)
+                delete[] chunk.load(std::memory_order_relaxed);
+        }
+
+        /**
+         *  @brief  Returns the id of the name, adding it to the table if
+         *          it was not present.
+         *  @param  name    the name to intern
+         * */
+        DOMsymbol intern(std::string_view name)
+        {
+            {
+                std::shared_lock<std::shared_mutex> lock(mutex);
+                auto i = ids.find(name);
+                if (i != ids.end())
+                    return i->second;
+            }
+
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            auto i = ids.find(name); // might have been added meanwhile
+            if (i != ids.end())
+                return i->second;
+
+            DOMsymbol id = count.load(std::memory_order_relaxed);
+            int chunk;
+            std::uint32_t offset;
+            locate(id, chunk, offset);
+            if (offset == 0)
+                chunks[chunk].store(new std::string[FIRST_CHUNK << chunk], std::memory_order_release);
+
+            std::string &stored = chunks[chunk].load(std::memory_order_relaxed)[offset];
+            stored = name;
+            ids.emplace(std::string_view(stored), id);
+            count.store(id + 1, std::memory_order_release);
+            return id;
+        }
+
+        /**
+         *  @brief  Returns the id of the name without adding it.
+         *  @return id of the name, NO_SYMBOL if the name is not interned
+         * */
+        inline DOMsymbol find(std::string_view name) const
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto i = ids.find(name);
+            return (i != ids.end() ? i->second : NO_SYMBOL);
+        }
+
+        /**
+         *  @brief  Returns the name of the given id. The reference stays
+         *          valid as long as the table.
+         * */
+        inline const std::string &name(DOMsymbol id) const
+        {
+            int chunk;
+            std::uint32_t offset;
+            locate(id, chunk, offset);
+            return chunks[chunk].load(std::memory_order_acquire)[offset];
+        }
+
+        /**
+         *  @brief  Returns number of interned names.
+         * */
+        inline std::size_t size() const
+        {
+            return count.load(std::memory_order_acquire);
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
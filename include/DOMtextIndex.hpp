@@ -0,0 +1,492 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_TEXT_INDEX
+#define DOM_PARSER_DOM_TEXT_INDEX
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "DOMarena.hpp"
+#include "DOMnode.hpp"
+#include "DOMnodeTable.hpp"
+#include "DOMthreads.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Inverted index of the inner-data of a tree: each word maps to
+     *          the posting list of the inner-data nodes holding it. A word is
+     *          a run of ASCII letters and digits and of non-ASCII bytes, so
+     *          UTF-8 letters are kept within words; words are case-sensitive.
+     *
+     *          A posting list holds the UIDs in increasing order, each coded
+     *          as a varint of its difference to the previous one. UIDs added
+     *          out of order wait in a short list merged by the next lookup.
+     *
+     *          Like DOMindex, entries are added eagerly and dropped lazily:
+     *          the lookups skip the nodes which were deleted, the lists of
+     *          the words a node lost are checked against the text of their
+     *          nodes, and all the lists are swept once about half of their
+     *          entries may be stale. An index which cannot follow the changes
+     *          of the tree is marked stale and rebuilt by the next lookup.
+     * */
+    class DOMtextIndex : public DOMattributeObserver
+    {
+    private:
+        typedef std::vector<DOMnodeUID> list_t;
+
+        struct posting_t
+        {
+            std::vector<std::uint8_t> bytes;
+            std::uint32_t count = 0;
+            DOMnodeUID last = -1;
+            // added below last, merged by the next lookup
+            list_t pending;
+            // some node lost the word since the list was last filtered
+            bool lost = false;
+        };
+
+        // lists built by one thread from a range of slots
+        typedef std::unordered_map<std::string_view, list_t> part_t;
+
+        // minimum number of stale entries before all the lists are swept
+        static constexpr std::size_t SWEEP_SLACK = 4096;
+
+        // minimum number of slots scanned by one thread when building
+        static constexpr std::uint64_t BUILD_GRAIN = 16384;
+
+        std::shared_ptr<DOMobserverList> observerSlot;
+        DOMnodeTable *nodes;
+
+        // keys are views of the inner-data stored in the arenas of the tree,
+        // which is never modified in place
+        std::unordered_map<std::string_view, posting_t> words;
+
+        // number of entries, and an estimate of how many of them are stale
+        std::size_t entries = 0;
+        std::size_t garbage = 0;
+        bool stale = true;
+
+        // inner-data may be replaced by several threads at once
+        std::mutex mutex;
+
+        static inline bool isWordByte(unsigned char c)
+        {
+            return c >= 0x80 || unsigned((c | 0x20) - 'a') < 26 || unsigned(c - '0') < 10;
+        }
+
+        /**
+         *  @brief  Returns the live inner-data node of the UID, nullptr if it
+         *          was deleted.
+         * */
+        inline DOMnode *live(DOMnodeUID uid) const
+        {
+            if (uidSlot(uid) >= nodes->size())
+                return nullptr;
+            DOMnode *node = nodes->get(uidSlot(uid));
+            return (node->getUID() == uid && node->isInnerDataNode() ? node : nullptr);
+        }
+
+        static inline void put(std::vector<std::uint8_t> &bytes, std::uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                bytes.push_back(std::uint8_t(value | 0x80));
+                value >>= 7;
+            }
+            bytes.push_back(std::uint8_t(value));
+        }
+
+        static inline std::uint64_t get(const std::uint8_t *&byte)
+        {
+            std::uint64_t value = 0;
+            for (unsigned shift = 0;; shift += 7)
+            {
+                value |= std::uint64_t(*byte & 0x7f) << shift;
+                if (!(*byte++ & 0x80))
+                    return value;
+            }
+        }
+
+        /**
+         *  @brief  Adds the node to the list, unless it was the last one
+         *          added.
+         * */
+        inline void add(posting_t &posting, DOMnodeUID uid)
+        {
+            if (uid == posting.last || (!posting.pending.empty() && posting.pending.back() == uid))
+                return;
+            if (uid > posting.last)
+            {
+                put(posting.bytes, std::uint64_t(uid - posting.last));
+                posting.last = uid;
+                ++posting.count;
+            }
+            else
+                posting.pending.push_back(uid);
+            ++entries;
+        }
+
+        /**
+         *  @brief  Replaces the list with the sorted UIDs.
+         * */
+        static void encode(posting_t &posting, const list_t &uids)
+        {
+            posting.bytes.clear();
+            posting.last = -1;
+            for (DOMnodeUID uid : uids)
+            {
+                put(posting.bytes, std::uint64_t(uid - posting.last));
+                posting.last = uid;
+            }
+            posting.bytes.shrink_to_fit();
+            posting.count = std::uint32_t(uids.size());
+            posting.pending.clear();
+        }
+
+        /**
+         *  @brief  Decodes the list to the sorted UIDs of the live nodes
+         *          holding the word, dropping the others from the list.
+         * */
+        void read(posting_t &posting, std::string_view word, list_t &uids)
+        {
+            uids.clear();
+            uids.reserve(posting.count + posting.pending.size());
+            const std::uint8_t *byte = posting.bytes.data();
+            DOMnodeUID previous = -1;
+            for (std::uint32_t i = 0; i < posting.count; ++i)
+            {
+                previous += DOMnodeUID(get(byte));
+                uids.push_back(previous);
+            }
+            std::size_t listed = uids.size() + posting.pending.size();
+            bool changed = !posting.pending.empty();
+            if (changed) // a node may have got the word again
+            {
+                uids.insert(uids.end(), posting.pending.begin(), posting.pending.end());
+                std::sort(uids.begin(), uids.end());
+                uids.erase(std::unique(uids.begin(), uids.end()), uids.end());
+            }
+
+            std::size_t kept = 0;
+            for (DOMnodeUID uid : uids)
+            {
+                DOMnode *node = live(uid);
+                if (node && (!posting.lost || containsWord(node->getInnerData(), word)))
+                    uids[kept++] = uid;
+            }
+            changed = changed || kept != uids.size();
+            uids.resize(kept);
+            entries -= listed - kept;
+            posting.lost = false;
+            if (changed)
+                encode(posting, uids);
+        }
+
+        /**
+         *  @brief  Drops the invalid entries of all the lists.
+         * */
+        void sweep()
+        {
+            list_t uids;
+            for (auto i = words.begin(); i != words.end();)
+            {
+                read(i->second, i->first, uids);
+                i = (uids.empty() ? words.erase(i) : std::next(i));
+            }
+            garbage = 0;
+        }
+
+        /**
+         *  @brief  Counts entries which turned stale, sweeping the lists
+         *          when about half of the entries are.
+         * */
+        inline void collect(std::size_t n)
+        {
+            garbage += n;
+            if (garbage > entries / 2 + SWEEP_SLACK)
+                sweep();
+        }
+
+        /**
+         *  @brief  Adds the words of the nodes in the slots [lo, hi) to the
+         *          lists.
+         * */
+        void scan(std::uint64_t lo, std::uint64_t hi, part_t &part) const
+        {
+            for (std::uint64_t slot = lo; slot < hi; ++slot)
+            {
+                DOMnode *node = nodes->get(slot);
+                if (node->getUID() < 0 || !node->isInnerDataNode())
+                    continue;
+                forEachWord(node->getInnerData(), [&](std::string_view word)
+                            {
+                                list_t &uids = part[word];
+                                if (uids.empty() || uids.back() != node->getUID()) // repeated in the text
+                                    uids.push_back(node->getUID());
+                            });
+            }
+        }
+
+    public:
+        /**
+         *  @brief  Calls f for each word of the text, in order.
+         * */
+        template <class F>
+        static void forEachWord(std::string_view text, F &&f)
+        {
+            std::size_t i = 0;
+            while (true)
+            {
+                while (i < text.size() && !isWordByte(text[i]))
+                    ++i;
+                if (i == text.size())
+                    return;
+                std::size_t begin = i;
+                while (i < text.size() && isWordByte(text[i]))
+                    ++i;
+                f(text.substr(begin, i - begin));
+            }
+        }
+
+        /**
+         *  @brief  Checks if the text holds the word.
+         * */
+        static bool containsWord(std::string_view text, std::string_view word)
+        {
+            bool found = false;
+            forEachWord(text, [&](std::string_view w) { found = found || w == word; });
+            return found;
+        }
+
+        /**
+         *  @brief  Constructor of an index to be built by build().
+         *  @param  arena   arena of the tree, the index observes the
+         *                  inner-data set on the nodes of the tree
+         *  @param  nodes   slots of the nodes of the tree
+         * */
+        DOMtextIndex(DOMarena &arena, DOMnodeTable *nodes)
+            : observerSlot(arena.shareObserverSlot()), nodes(nodes)
+        {
+            observerSlot->add(this);
+        }
+
+        DOMtextIndex(const DOMtextIndex &) = delete;
+        DOMtextIndex &operator=(const DOMtextIndex &) = delete;
+
+        ~DOMtextIndex()
+        {
+            observerSlot->remove(this);
+        }
+
+        /**
+         *  @brief  Marks the index stale, to be rebuilt by the next lookup.
+         *  @param  table   slots of the nodes of the tree, which may have
+         *                  been replaced
+         * */
+        void invalidate(DOMnodeTable *table)
+        {
+            nodes = table;
+            stale = true;
+            words.clear();
+            entries = garbage = 0;
+        }
+
+        /**
+         *  @brief  Rebuilds the index from all the nodes of the tree. Big
+         *          trees are scanned by several threads, each filling lists of
+         *          its own from a range of slots; the lists are merged in slot
+         *          order and coded at the end.
+         *  @param  threads     maximum number of threads to use
+         * */
+        void build(unsigned threads)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            invalidate(nodes);
+            std::uint64_t size = nodes->size();
+            std::size_t ranges = parallelRanges(threads, size, BUILD_GRAIN);
+            std::vector<part_t> parts(ranges);
+            parallelSlices(ranges, size, [&](std::size_t r, std::uint64_t lo, std::uint64_t hi)
+                           { scan(lo, hi, parts[r]); });
+
+            part_t &all = parts[0];
+            for (std::size_t r = 1; r < ranges; ++r)
+                for (auto &word : parts[r])
+                {
+                    list_t &uids = all[word.first];
+                    uids.insert(uids.end(), word.second.begin(), word.second.end());
+                }
+            words.reserve(all.size());
+            for (auto &word : all)
+            {
+                // slots of reused generations have greater UIDs
+                if (!std::is_sorted(word.second.begin(), word.second.end()))
+                    std::sort(word.second.begin(), word.second.end());
+                encode(words[word.first], word.second);
+                entries += word.second.size();
+                list_t().swap(word.second);
+            }
+            stale = false;
+        }
+
+        /**
+         *  @brief  Checks if the index has to be rebuilt before lookups.
+         * */
+        inline bool isStale() const
+        {
+            return stale;
+        }
+
+        /**
+         *  @brief  Adds the words of a new node of the tree.
+         * */
+        void nodeAdded(const DOMnode &node)
+        {
+            if (stale || !node.isInnerDataNode())
+                return;
+            std::lock_guard<std::mutex> lock(mutex);
+            forEachWord(node.getInnerData(), [&](std::string_view word) { add(words[word], node.getUID()); });
+        }
+
+        /**
+         *  @brief  Adds the words of new nodes of the tree, under one lock.
+         * */
+        void nodesAdded(const std::vector<DOMnode *> &added)
+        {
+            if (stale)
+                return;
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const DOMnode *node : added)
+                if (node->isInnerDataNode())
+                    forEachWord(node->getInnerData(), [&](std::string_view word) { add(words[word], node->getUID()); });
+        }
+
+        /**
+         *  @brief  Counts the nodes deleted from the tree, their entries
+         *          turned stale.
+         * */
+        void nodesDeleted(std::size_t n)
+        {
+            if (stale)
+                return;
+            std::lock_guard<std::mutex> lock(mutex);
+            collect(n);
+        }
+
+        void attributeChanged(DOMnode & /*node*/, DOMsymbol /*name*/, std::string_view /*previous*/,
+                              std::string_view /*value*/) override
+        {
+        }
+
+        void innerDataChanged(DOMnode &node, std::string_view previous, std::string_view data) override
+        {
+            if (stale || previous == data)
+                return;
+            std::lock_guard<std::mutex> lock(mutex);
+            forEachWord(data, [&](std::string_view word)
+                        {
+                            if (!containsWord(previous, word))
+                                add(words[word], node.getUID());
+                        });
+            std::size_t lost = 0;
+            forEachWord(previous, [&](std::string_view word)
+                        {
+                            if (containsWord(data, word))
+                                return;
+                            auto i = words.find(word);
+                            if (i != words.end())
+                            {
+                                i->second.lost = true;
+                                ++lost;
+                            }
+                        });
+            collect(lost);
+        }
+
+        /**
+         *  @brief  Appends the UIDs of the inner-data nodes holding all the
+         *          words of the query to the vector, in increasing order.
+         *          Each word takes O(k) for the k nodes holding it. The index
+         *          must not be stale.
+         *  @param  query   one or more words; nothing is found if it has none
+         * */
+        void findText(std::string_view query, std::vector<DOMnodeUID> &found)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<std::pair<std::string_view, posting_t *>> queried;
+            bool missing = false;
+            forEachWord(query, [&](std::string_view word)
+                        {
+                            auto i = words.find(word);
+                            if (i == words.end())
+                                missing = true;
+                            else
+                                queried.emplace_back(i->first, &i->second);
+                        });
+            if (missing || queried.empty())
+                return;
+            // shortest lists first, the intersection only shrinks
+            std::sort(queried.begin(), queried.end(), [](const auto &a, const auto &b)
+                      { return a.second->count + a.second->pending.size() < b.second->count + b.second->pending.size(); });
+
+            list_t result, uids;
+            read(*queried[0].second, queried[0].first, result);
+            for (std::size_t q = 1; q < queried.size() && !result.empty(); ++q)
+            {
+                read(*queried[q].second, queried[q].first, uids);
+                result.erase(std::set_intersection(result.begin(), result.end(), uids.begin(), uids.end(),
+                                                   result.begin()),
+                             result.end());
+            }
+            found.insert(found.end(), result.begin(), result.end());
+        }
+
+        /**
+         *  @brief  Returns the number of distinct words.
+         * */
+        inline std::size_t getWordCount() const
+        {
+            return words.size();
+        }
+
+        /**
+         *  @brief  Returns the number of entries of the lists, stale ones
+         *          included.
+         * */
+        inline std::size_t getEntryCount() const
+        {
+            return entries;
+        }
+
+        /**
+         *  @brief  Returns the bytes taken by the coded lists.
+         * */
+        std::size_t getMemoryUsage() const
+        {
+            std::size_t bytes = 0;
+            for (const auto &word : words)
+                bytes += word.second.bytes.capacity() + word.second.pending.capacity() * sizeof(DOMnodeUID);
+            return bytes;
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
@@ -0,0 +1,115 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_THREADS
+#define DOM_PARSER_DOM_THREADS
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Returns the number of ranges a job over count items is split
+     *          into: one per grain of items, at most threads, at least 1.
+     * */
+    inline std::size_t parallelRanges(unsigned threads, std::uint64_t count, std::uint64_t grain = 1)
+    {
+        return std::size_t(std::max<std::uint64_t>(1, std::min<std::uint64_t>(threads, count / grain)));
+    }
+
+    /**
+     *  @brief  Runs job(r) for every range r in [0, ranges), each on a
+     *          thread of its own; the caller takes range 0. Ranges whose
+     *          thread could not be started are run by the caller after its
+     *          own. Returns once all the ranges are done, then rethrows the
+     *          first exception thrown by a range, if any.
+     * */
+    template <typename job_t>
+    void parallelRun(std::size_t ranges, job_t &&job)
+    {
+        if (ranges == 0)
+            return;
+        std::vector<std::exception_ptr> errors(ranges);
+        auto run = [&](std::size_t r)
+        {
+            try
+            {
+                job(r);
+            }
+            catch (...)
+            {
+                errors[r] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        std::size_t started = 1;
+        try
+        {
+            workers.reserve(ranges - 1);
+            for (; started < ranges; ++started)
+                workers.emplace_back(run, started);
+        }
+        catch (...) // out of threads, the rest is run here
+        {
+        }
+        run(0);
+        for (std::size_t r = started; r < ranges; ++r)
+            run(r);
+        for (auto &worker : workers)
+            worker.join();
+
+        for (auto &error : errors)
+            if (error)
+                std::rethrow_exception(error);
+    }
+
+    /**
+     *  @brief  Splits [0, count) into ranges slices of the same size, the
+     *          last one taking the remainder, and runs job(r, lo, hi) for
+     *          every slice as parallelRun() does.
+     * */
+    template <typename count_t, typename job_t>
+    void parallelSlices(std::size_t ranges, count_t count, job_t &&job)
+    {
+        count_t step = count / count_t(std::max<std::size_t>(ranges, 1));
+        parallelRun(ranges, [&](std::size_t r)
+                    { job(r, step * count_t(r), (r + 1 == ranges ? count : step * count_t(r + 1))); });
+    }
+
+    /**
+     *  @brief  Runs job(w, i) for every item i in [0, count). The items are
+     *          taken one by one by workers workers, so that uneven items are
+     *          balanced; w is the worker taking the item, for state kept per
+     *          worker.
+     * */
+    template <typename job_t>
+    void parallelEach(std::size_t workers, std::size_t count, job_t &&job)
+    {
+        std::atomic<std::size_t> taken{0};
+        parallelRun(std::min(workers, count), [&](std::size_t w)
+                    {
+                        for (std::size_t i; (i = taken.fetch_add(1, std::memory_order_relaxed)) < count;)
+                            job(w, i);
+                    });
+    }
+
+} // namespace dom_parser
+
+#endif
@@ -15,26 +15,80 @@
 #ifndef DOM_PARSER_DOM_TREE
 #define DOM_PARSER_DOM_TREE
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
-#include <queue>
 
+#include "DOMarena.hpp"
+#include "DOMhash.hpp"
+#include "DOMindex.hpp"
 #include "DOMnode.hpp"
+#include "DOMnodeTable.hpp"
+#include "DOMnumberCache.hpp"
+#include "DOMtextIndex.hpp"
+#include "DOMthreads.hpp"
 
 namespace dom_parser
 {
+    class DOMtreeWorker;
+    class DOMtreeBatch;
+
     class DOMtree
     {
+        friend class DOMtreeWorker;
+        friend class DOMtreeBatch;
+
     private:
-        std::vector<std::shared_ptr<DOMnode>> nodes;
-        int nodes_counter = 0;
+        // nodes live as long as the arena, clones of the tree keep it alive
+        // as they share its strings
+        std::shared_ptr<DOMarena> arena;
+
+        // placeholder stored in the slots of deleted nodes
+        DOMnode *deletedNode;
+
+        // slots of the nodes, vacant UIDs and their count
+        std::unique_ptr<DOMnodeTable> nodes;
+
+        // guards the arena registry while workers are created
+        std::unique_ptr<std::mutex> workersMutex;
+
+        // guards the relabeling of concurrent refreshIntervalLabels() calls
+        std::unique_ptr<std::mutex> labelsMutex;
+
+        // secondary indexes, nullptr when not enabled
+        std::unique_ptr<DOMindex> index;
+
+        // hashes of the subtrees, nullptr when not enabled
+        std::unique_ptr<DOMhashes> hashes;
 
-        std::queue<DOMnodeUID> vacantUIDs;
-        // DOMnode deletedNode = DOMnode("", -1, -1);
-        // std::unique_ptr<DOMnode> deletedNodeP(DOMnode("", -1, -1));
+        // words of the inner-data, nullptr when not enabled
+        std::unique_ptr<DOMtextIndex> textIndex;
 
-#define DOM_TREE_DELETED_NODE DOMnode("", -1, -1)
+        // parsed numbers, nullptr when not enabled
+        std::unique_ptr<DOMnumberCache> numbers;
+
+        // interval labels, a node is an ancestor of another iff its labels
+        // enclose the labels of the other
+        bool labelsEnabled = false;
+        bool labelsDirty = true;
+
+        // subtrees bigger than this are not relabeled on move, labels of
+        // the whole tree are recomputed lazily instead
+        static constexpr std::uint32_t LABEL_MOVE_LIMIT = 256;
+
+        // minimum number of nodes relocated by one thread when compacting
+        static constexpr DOMnodeUID COMPACT_GRAIN = 16384;
+
+        // minimum number of nodes created by one thread when copying subtrees
+        static constexpr std::size_t COPY_GRAIN = 16384;
 
         /**
          * @brief   Gets reference to the node at the pointer in vector
@@ -42,7 +96,32 @@ namespace dom_parser
          * */
         inline DOMnode &_nodes(DOMnodeUID uid)
         {
-            return *(nodes[uid].get());
+            return *nodes->get(uidSlot(uid));
+        }
+
+        /**
+         * @brief   Stores a freshly created node in the slot of its UID.
+         * @param   UID     UID of the node
+         * @param   node    the node, allocated from the arena of the tree
+         * */
+        inline void storeNode(DOMnodeUID UID, DOMnode *node)
+        {
+            nodes->set(uidSlot(UID), node);
+        }
+
+        /**
+         * @brief   Creates a node for the UID, in the memory of the dead node
+         *          which had the slot before if there is one, in the arena
+         *          otherwise.
+         * @param   args    arguments forwarded to the constructor of DOMnode
+         * */
+        template <class... Args>
+        static DOMnode *createNode(DOMnodeTable &table, DOMarena &arena, DOMnodeUID UID, Args &&...args)
+        {
+            static_assert(std::is_trivially_destructible_v<DOMnode>, "dead nodes are overwritten in place");
+            if (DOMnode *memory = table.takeRecycled(uidSlot(UID)))
+                return new (memory) DOMnode(std::forward<Args>(args)...);
+            return arena.create<DOMnode>(std::forward<Args>(args)...);
         }
 
         /**
@@ -50,26 +129,506 @@ namespace dom_parser
         */
         inline DOMnodeUID generateUID()
         {
-            ++nodes_counter;
+            if (nodes->count() == 0) // added to fix a possible bug in which multiple root DOM
+            {                        // elements could occur if once root node is deleted.
+                nodes->reset();
+                nodes->setGeneration(0, 0); // the root is always 0
+                nodes->addCount(1);
+                return 0;
+            }
+            nodes->addCount(1);
 
-            if (nodes_counter == 1) // added to fix a possible bug in which multiple root DOM
-                return 0;           // elements could occur if once root node is deleted.
-            if (vacantUIDs.empty())
-                return nodes_counter - 1;
+            std::uint64_t slot = nodes->popVacant();
+            if (slot == DOMnodeTable::NO_SLOT)
+                slot = nodes->reserve(1);
+            return makeNodeUID(slot, nodes->getGeneration(slot));
+        }
 
-            DOMnodeUID uid = vacantUIDs.front();
-            vacantUIDs.pop();
-            return uid;
+        /**
+         * @brief   Checks if the secondary indexes are enabled, rebuilding
+         *          them first if they could not follow the changes of the tree.
+         * */
+        bool indexReady()
+        {
+            if (!index)
+                return false;
+            if (index->isStale())
+                index->build(std::thread::hardware_concurrency());
+            return true;
         }
 
         /**
-         * @brief   Checks existance of a node with given UID.
+         * @brief   Checks existance of a node with given UID, a stale UID of
+         *          a deleted node whose slot was reused does not exist.
          * @param   node     The node UID.
          * @return  true or false accordingly
          */
-        inline bool checkNodeExistance(DOMnodeUID node)
+        inline bool checkNodeExistance(DOMnodeUID node) const
+        {
+            return (node >= 0 && uidSlot(node) < nodes->size() && nodes->get(uidSlot(node))->getUID() == node);
+        }
+
+        /**
+         * @brief   Checks if the subtree can be moved under the new parent,
+         *          that is, both exist, new parent is not an inner-data node
+         *          and it is not in the subtree.
+         * */
+        bool checkMove(DOMnodeUID subtree_root, DOMnodeUID new_parent)
+        {
+            if (!checkNodeExistance(subtree_root) || !checkNodeExistance(new_parent))
+                return false;
+            if (_nodes(new_parent).isInnerDataNode()) // inner-data nodes have no children
+                return false;
+            if (subtree_root == 0)
+                return false;
+            if (subtree_root == new_parent)
+                return false;
+
+            // labels are not recomputed here, a run of moves would
+            // otherwise relabel the whole tree again and again
+            if (labelsEnabled && !labelsDirty)
+                return !labelsEnclose(_nodes(subtree_root), _nodes(new_parent));
+            return !walkIsAncestor(subtree_root, new_parent);
+        }
+
+        /**
+         * @brief   Checks if the labels of a enclose the labels of b.
+         * */
+        static inline bool labelsEnclose(DOMnode &a, DOMnode &b)
+        {
+            return a.getPreLabel() < b.getPreLabel() && b.getPostLabel() < a.getPostLabel();
+        }
+
+        /**
+         * @brief   Checks if a is a proper ancestor of b by walking up from b.
+         * */
+        bool walkIsAncestor(DOMnodeUID a, DOMnodeUID b)
+        {
+            for (DOMnodeUID node = _nodes(b).getParent(); node != -1; node = _nodes(node).getParent())
+                if (node == a)
+                    return true;
+            return false;
+        }
+
+        /**
+         * @brief   Returns pointer to the node, nullptr for -1.
+         * */
+        inline DOMnode *nodeOrNull(DOMnodeUID uid)
+        {
+            return (uid != -1 ? &_nodes(uid) : nullptr);
+        }
+
+        /**
+         * @brief   Finds the free label interval (lo, hi) around the node,
+         *          bounded by its siblings or by the labels of its parent.
+         * */
+        inline void labelGap(DOMnode &node, std::uint64_t &lo, std::uint64_t &hi)
+        {
+            DOMnode &parent = _nodes(node.getParent());
+            DOMnode *prev = nodeOrNull(node.getPrevSibling());
+            DOMnode *next = nodeOrNull(node.getNextSibling());
+            lo = (prev ? prev->getPostLabel() : parent.getPreLabel());
+            hi = (next ? next->getPreLabel() : parent.getPostLabel());
+        }
+
+        /**
+         * @brief   Assigns labels in depth-first order to the subtree, spaced
+         *          evenly starting after lo.
+         * @param   subtree_root    root of the subtree
+         * @param   lo              label before the first label of subtree
+         * @param   spacing         distance between consecutive labels
+         * */
+        void assignLabels(DOMnode &subtree_root, std::uint64_t lo, std::uint64_t spacing)
+        {
+            std::uint64_t label = lo;
+            DOMnode *node = &subtree_root;
+            while (true)
+            {
+                label += spacing;
+                node->setLabels(label, 0); // pre
+                if (node->getFirstChild() != -1)
+                {
+                    node = &_nodes(node->getFirstChild());
+                    continue;
+                }
+                while (true)
+                {
+                    label += spacing;
+                    node->setLabels(node->getPreLabel(), label); // post
+                    if (node == &subtree_root)
+                        return;
+                    if (node->getNextSibling() != -1)
+                    {
+                        node = &_nodes(node->getNextSibling());
+                        break;
+                    }
+                    node = &_nodes(node->getParent());
+                }
+            }
+        }
+
+        /**
+         * @brief   Counts nodes of the subtree, stops counting past limit.
+         * */
+        std::uint32_t countSubtree(const DOMnode &subtree_root, std::uint32_t limit) const
+        {
+            std::uint32_t count = 0;
+            const DOMnode *node = &subtree_root;
+            while (true)
+            {
+                if (++count > limit)
+                    return count;
+                if (node->getFirstChild() != -1)
+                {
+                    node = &getNode(node->getFirstChild());
+                    continue;
+                }
+                while (node != &subtree_root && node->getNextSibling() == -1)
+                    node = &getNode(node->getParent());
+                if (node == &subtree_root)
+                    return count;
+                node = &getNode(node->getNextSibling());
+            }
+        }
+
+        /**
+         * @brief   Updates the labels of a subtree which was just linked at
+         *          its position. If there is no room between its neighbours
+         *          or the subtree is big, labels are marked for lazy relabeling.
+         * */
+        void updateLabels(DOMnode &subtree_root)
+        {
+            if (!labelsEnabled || labelsDirty)
+                return;
+
+            std::uint32_t count = countSubtree(subtree_root, LABEL_MOVE_LIMIT);
+            std::uint64_t lo, hi;
+            labelGap(subtree_root, lo, hi);
+            if (count > LABEL_MOVE_LIMIT || hi <= lo || (hi - lo) <= 2 * std::uint64_t(count))
+            {
+                labelsDirty = true;
+                return;
+            }
+            assignLabels(subtree_root, lo, (hi - lo) / (2 * std::uint64_t(count) + 1));
+        }
+
+        /**
+         * @brief   Relabels the whole tree with evenly spread labels.
+         * */
+        void relabel()
+        {
+            std::uint64_t count = std::uint64_t(nodes->count());
+            assignLabels(_nodes(0), 0, (std::uint64_t(1) << 62) / (2 * count + 2));
+            labelsDirty = false;
+        }
+
+        /**
+         * @brief   Unlinks node from its parent and links it to the new parent
+         *          next to the reference node, all in O(1).
+         * @param   node        node to be moved
+         * @param   new_parent  UID of the new parent
+         * @param   reference   child of new parent next to which node is placed,
+         *                      nullptr to place it as the last child
+         * @param   after       place node after the reference instead of before
+         * */
+        void relink(DOMnode &node, DOMnodeUID new_parent, DOMnode *reference, bool after)
+        {
+            if (hashes)
+            {
+                hashes->nodeChanged(node.getParent());
+                hashes->nodeChanged(new_parent);
+            }
+            _nodes(node.getParent()).unlinkChild(node);
+
+            DOMnode *before = reference;
+            if (reference && after)
+            {
+                DOMnodeUID next = reference->getNextSibling();
+                before = (next != -1 ? &_nodes(next) : nullptr);
+            }
+            _nodes(new_parent).linkChild(node, before);
+            node.setParent(new_parent);
+            updateLabels(node);
+        }
+
+        /**
+         * @brief   Adds a node next to the reference node.
+         * @param   reference   UID of the sibling
+         * @param   tagName     Interned tag name of the node.
+         * @param   after       insert after the reference instead of before
+         * */
+        DOMnodeUID insertNodeAt(DOMnodeUID reference, DOMsymbol tagName, bool after)
+        {
+            if (!checkNodeExistance(reference) || reference == 0)
+                return -1;
+
+            DOMnodeUID parent = _nodes(reference).getParent();
+            DOMnodeUID UID = generateUID();
+            storeNode(UID, createNode(*nodes, *arena, UID, tagName, UID, parent, arena.get()));
+
+            DOMnode *before = &_nodes(reference);
+            if (after)
+            {
+                DOMnodeUID next = before->getNextSibling();
+                before = (next != -1 ? &_nodes(next) : nullptr);
+            }
+            _nodes(parent).linkChild(_nodes(UID), before);
+            updateLabels(_nodes(UID));
+            if (index)
+                index->nodeAdded(_nodes(UID));
+            if (hashes)
+                hashes->nodeAdded(_nodes(UID));
+
+            return UID;
+        }
+
+        /**
+         * @brief   Copies the nodes of the new slots [lo, hi) to the arena.
+         * @param   order       old UIDs of the nodes, indexed by new slots, -1
+         *                      for retired slots
+         * @param   renumbered  new UIDs of the nodes, indexed by old slots
+         * */
+        void relocateRange(const std::vector<DOMnodeUID> &order, const std::vector<DOMnodeUID> &renumbered,
+                           DOMnodeUID lo, DOMnodeUID hi, DOMarena &target, DOMnodeTable &table)
+        {
+            for (DOMnodeUID slot = lo; slot < hi; ++slot)
+            {
+                if (order[slot] == -1)
+                    continue;
+                DOMnode &node = _nodes(order[slot]);
+                DOMnodeUID parent = node.getParent();
+                table.set(slot, target.create<DOMnode>(node, renumbered[uidSlot(order[slot])],
+                                                       (parent != -1 ? renumbered[uidSlot(parent)] : -1), &target));
+            }
+        }
+
+        /**
+         * @brief   Links the children of the relocated nodes of the new slots
+         *          [lo, hi), each node is linked by the range of its parent.
+         * */
+        void linkRange(const std::vector<DOMnodeUID> &order, const std::vector<DOMnodeUID> &renumbered,
+                       DOMnodeUID lo, DOMnodeUID hi, DOMnodeTable &table)
+        {
+            for (DOMnodeUID slot = lo; slot < hi; ++slot)
+            {
+                if (order[slot] == -1)
+                    continue;
+                DOMnode &parent = *table.get(slot);
+                for (DOMnodeUID child : _nodes(order[slot]).getChildrenUID())
+                    parent.linkChild(*table.get(uidSlot(renumbered[uidSlot(child)])));
+            }
+        }
+
+        /**
+         * @brief   Marks the nodes of the subtree dead, walking it in
+         *          post-order over the sibling links so that a node is buried
+         *          after all its links were followed. Does not allocate.
+         * @param   subtree_root    root of the subtree, its siblings are not
+         *                          visited
+         * @param   chain           chain collecting the vacant slots
+         * */
+        void burySubtree(DOMnode &subtree_root, DOMnodeTable::vacant_chain_t &chain)
+        {
+            DOMnode *node = &subtree_root;
+            while (true)
+            {
+                while (node->getFirstChild() != -1)
+                    node = &_nodes(node->getFirstChild());
+                while (true)
+                {
+                    bool last = (node == &subtree_root);
+                    DOMnodeUID next = node->getNextSibling();
+                    DOMnodeUID parent = node->getParent();
+                    nodes->bury(uidSlot(node->getUID()), chain);
+                    if (last)
+                        return;
+                    if (next != -1)
+                    {
+                        node = &_nodes(next);
+                        break;
+                    }
+                    node = &_nodes(parent);
+                }
+            }
+        }
+
+        /**
+         * @brief   Notifies the indexes, the hashes and the observers of the
+         *          attributes of a node created with its attributes.
+         * */
+        void notifyCopied(DOMnode &node, DOMattributeObserver *observer)
+        {
+            if (index)
+                index->nodeAdded(node);
+            if (hashes)
+                hashes->nodeAdded(node);
+            if (textIndex)
+                textIndex->nodeAdded(node);
+            if (!observer)
+                return;
+            DOMattributeRange attributes = node.getAllAttributes();
+            for (std::uint32_t a = 0; a < attributes.size(); ++a)
+                observer->attributeChanged(node, attributes.symbolAt(a), std::string_view(), attributes.valueAt(a));
+        }
+
+        /**
+         * @brief   Copies the subtree of the source tree as the last child of
+         *          new_parent. Small subtrees are copied in one walk, every
+         *          copy being linked under the copy of its parent as soon as
+         *          it is created. Big ones are listed in pre-order first, then
+         *          the UIDs of all the copies are taken at once, and ranges of
+         *          the copies are created and linked by several threads.
+         * @param   source      tree of the subtree, may be this tree
+         * @param   copyData    copy the data to this tree instead of sharing
+         *                      it with the original
+         * @param   threads     maximum number of threads to use
+         * @return  UID of the copy of subtree_root, -1 if either node does not
+         *          exist or new_parent is an inner-data node
+         * */
+        DOMnodeUID copySubtree(const DOMtree &source, DOMnodeUID subtree_root, DOMnodeUID new_parent,
+                               bool copyData, unsigned threads)
         {
-            return (node < nodes.size() && _nodes(node).getUID() != -1);
+            if (!source.checkNodeExistance(subtree_root) || !checkNodeExistance(new_parent) ||
+                _nodes(new_parent).isInnerDataNode())
+                return -1;
+
+            // names of the source interned in this tree, each one once
+            const DOMsymbolTable &sourceSymbols = source.getSymbols();
+            bool remap = (&sourceSymbols != &getSymbols());
+            std::vector<DOMsymbol> names(remap ? sourceSymbols.size() : 0, DOMsymbolTable::NO_SYMBOL);
+            auto rename = [&](const DOMnode &node)
+            {
+                if (!remap || node.isInnerDataNode())
+                    return;
+                DOMattributeRange attributes = node.getAllAttributes();
+                for (std::uint32_t a = 0; a <= attributes.size(); ++a)
+                {
+                    DOMsymbol name = (a == 0 ? node.getTagSymbol() : attributes.symbolAt(a - 1));
+                    if (names[name] == DOMsymbolTable::NO_SYMBOL)
+                        names[name] = getSymbols().intern(sourceSymbols.name(name));
+                }
+            };
+            const DOMsymbol *map = (remap ? names.data() : nullptr);
+            DOMattributeObserver *observer = arena->getObserver();
+            const DOMnode &sourceRoot = source.getNode(subtree_root);
+            DOMnode *copied = nullptr;
+
+            if (threads <= 1 || source.countSubtree(sourceRoot, 2 * COPY_GRAIN) <= 2 * COPY_GRAIN)
+            {
+                std::vector<DOMnode *> open; // copies of the ancestors of the node
+                const DOMnode *node = &sourceRoot;
+                while (true)
+                {
+                    rename(*node);
+                    DOMnodeUID UID = generateUID();
+                    DOMnode *copy = createNode(*nodes, *arena, UID, *node, UID,
+                                               (open.empty() ? new_parent : open.back()->getUID()), arena.get(),
+                                               map, copyData);
+                    storeNode(UID, copy);
+                    if (open.empty())
+                        copied = copy;
+                    else
+                        open.back()->linkChild(*copy);
+                    notifyCopied(*copy, observer);
+                    if (node->getFirstChild() != -1)
+                    {
+                        open.push_back(copy);
+                        node = &source.getNode(node->getFirstChild());
+                        continue;
+                    }
+                    while (node != &sourceRoot && node->getNextSibling() == -1)
+                    {
+                        node = &source.getNode(node->getParent());
+                        open.pop_back();
+                    }
+                    if (node == &sourceRoot)
+                        break;
+                    node = &source.getNode(node->getNextSibling());
+                }
+            }
+            else
+            {
+                // pre-order list of the nodes, with their parents
+                static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+                std::vector<const DOMnode *> order;
+                std::vector<std::size_t> parents;
+                const DOMnode *node = &sourceRoot;
+                std::size_t parent = NONE;
+                while (true)
+                {
+                    std::size_t i = order.size();
+                    order.push_back(node);
+                    parents.push_back(parent);
+                    rename(*node);
+                    if (node->getFirstChild() != -1)
+                    {
+                        parent = i;
+                        node = &source.getNode(node->getFirstChild());
+                        continue;
+                    }
+                    while (i != 0 && order[i]->getNextSibling() == -1)
+                        i = parents[i];
+                    if (i == 0)
+                        break;
+                    parent = parents[i];
+                    node = &source.getNode(order[i]->getNextSibling());
+                }
+                std::size_t count = order.size();
+                std::vector<std::size_t> sizes(count, 1); // of the subtrees
+                for (std::size_t i = count; i-- > 1;)
+                    sizes[parents[i]] += sizes[i];
+
+                // vacant slots first, then a block of fresh ones
+                std::vector<DOMnodeUID> uids(count);
+                std::size_t taken = 0;
+                for (std::uint64_t slot; taken < count && (slot = nodes->popVacant()) != DOMnodeTable::NO_SLOT;
+                     ++taken)
+                    uids[taken] = makeNodeUID(slot, nodes->getGeneration(slot));
+                if (taken < count)
+                    for (std::uint64_t slot = nodes->reserve(count - taken); taken < count; ++slot, ++taken)
+                        uids[taken] = makeNodeUID(slot, nodes->getGeneration(slot));
+                nodes->addCount(DOMnodeUID(count));
+
+                std::vector<DOMnode *> copies(count);
+                auto createRange = [&](DOMarena &target, std::size_t lo, std::size_t hi)
+                {
+                    for (std::size_t i = lo; i < hi; ++i)
+                    {
+                        copies[i] = createNode(*nodes, target, uids[i], *order[i], uids[i],
+                                               (i == 0 ? new_parent : uids[parents[i]]), &target, map, copyData);
+                        storeNode(uids[i], copies[i]);
+                    }
+                };
+                // the children of a node are linked by the range of the node
+                auto linkRange = [&](std::size_t lo, std::size_t hi)
+                {
+                    for (std::size_t i = lo; i < hi; ++i)
+                    {
+                        std::size_t child = i + 1;
+                        for (std::uint32_t k = 0; k < order[i]->getChildCount(); ++k, child += sizes[child])
+                            copies[i]->linkChild(*copies[child]);
+                    }
+                };
+
+                // every thread creates its nodes in an arena of its own
+                std::size_t ranges = parallelRanges(threads, count, COPY_GRAIN);
+                std::vector<std::shared_ptr<DOMarena>> arenas;
+                for (std::size_t r = 0; r < ranges; ++r)
+                    arenas.push_back(createArena());
+
+                parallelSlices(ranges, count, [&](std::size_t r, std::size_t lo, std::size_t hi)
+                               { createRange(*arenas[r], lo, hi); });
+                parallelSlices(ranges, count, [&](std::size_t, std::size_t lo, std::size_t hi)
+                               { linkRange(lo, hi); });
+                for (DOMnode *copy : copies)
+                    notifyCopied(*copy, observer);
+                copied = copies[0];
+            }
+
+            // linked last, new_parent may be inside the subtree
+            _nodes(new_parent).linkChild(*copied);
+            updateLabels(*copied);
+            return copied->getUID();
         }
 
     public:
@@ -77,18 +636,102 @@ namespace dom_parser
          * @brief   Constructor of empty tree. @a Depriciated @a method - beware
          *          of undefined behaviour when used this contructor without proper
          *          knowledge.
+         * @param   resource    memory resource for the nodes, nullptr for a
+         *                      per-tree bump arena.
+         * @param   symbols     symbol table for tag and attribute names, it can
+         *                      be shared by many trees. nullptr for a table
+         *                      owned by this tree.
          */
-        DOMtree() {}
+        DOMtree(std::pmr::memory_resource *resource = nullptr,
+                std::shared_ptr<DOMsymbolTable> symbols = nullptr)
+            : arena(std::make_shared<DOMarena>(resource, std::move(symbols))),
+              deletedNode(arena->create<DOMnode>(DOMsymbolTable::NO_SYMBOL, -1, -1, arena.get())),
+              nodes(std::make_unique<DOMnodeTable>(deletedNode)),
+              workersMutex(std::make_unique<std::mutex>()),
+              labelsMutex(std::make_unique<std::mutex>()) {}
 
         /**
          * @brief   Constructor of the tree with an initial root node.
          * @param   rootName    Name of the root node.
+         * @param   resource    memory resource for the nodes, nullptr for a
+         *                      per-tree bump arena.
+         * @param   symbols     symbol table for tag and attribute names, it can
+         *                      be shared by many trees. nullptr for a table
+         *                      owned by this tree.
+         */
+        DOMtree(std::string_view root, std::pmr::memory_resource *resource = nullptr,
+                std::shared_ptr<DOMsymbolTable> symbols = nullptr)
+            : DOMtree(resource, std::move(symbols))
+        {
+            DOMnodeUID UID = generateUID();
+            storeNode(UID, createNode(*nodes, *arena, UID, getSymbols().intern(root), UID, -1, arena.get())); // root
+        }
+
+        /**
+         * @brief   Constructor of the tree with an initial root node whose
+         *          name is already interned in the given symbol table.
+         * @param   root        Interned name of the root node.
+         * @param   symbols     symbol table for tag and attribute names.
+         * @param   resource    memory resource for the nodes, nullptr for a
+         *                      per-tree bump arena.
+         */
+        DOMtree(DOMsymbol root, std::shared_ptr<DOMsymbolTable> symbols,
+                std::pmr::memory_resource *resource = nullptr)
+            : DOMtree(resource, std::move(symbols))
+        {
+            DOMnodeUID UID = generateUID();
+            storeNode(UID, createNode(*nodes, *arena, UID, root, UID, -1, arena.get())); // root
+        }
+
+        /**
+         *    Copying of trees is removed, a copy which shares nodes with the
+         *    original would silently reflect changes made to the other one.
+         *    Trees are moved in O(1), or copied explicitly with clone().
+         */
+        DOMtree(const DOMtree &tree) = delete;
+        DOMtree &operator=(const DOMtree &tree) = delete;
+        DOMtree(DOMtree &&tree) = default;
+        DOMtree &operator=(DOMtree &&tree) = default;
+
+        /**
+         * @brief   Returns the memory resource the nodes of the tree are
+         *          allocated from.
+         */
+        inline std::pmr::memory_resource *getResource() const
+        {
+            return arena->getResource();
+        }
+
+        /**
+         * @brief   Returns the symbol table in which names used by the
+         *          tree are interned.
+         */
+        inline DOMsymbolTable &getSymbols() const
+        {
+            return arena->getSymbols();
+        }
+
+        /**
+         * @brief   Returns shared pointer to the symbol table of the tree,
+         *          to be passed on to other trees of the same batch.
          */
-        DOMtree(std::string root)
+        inline const std::shared_ptr<DOMsymbolTable> &shareSymbols() const
         {
-            nodes.push_back(
-                std::shared_ptr<DOMnode>(
-                    new DOMnode(root, generateUID(), -1))); // root
+            return arena->shareSymbols();
+        }
+
+        /**
+         * @brief   Creates an arena which lives as long as the tree, for a
+         *          thread storing strings of nodes of the tree while other
+         *          threads do too. May be called concurrently.
+         */
+        std::shared_ptr<DOMarena> createArena()
+        {
+            auto created = std::make_shared<DOMarena>(arena->getUserResource(), arena->shareSymbols());
+            std::lock_guard<std::mutex> lock(*workersMutex);
+            arena->share(created); // strings of the arena live as long as the tree
+            created->shareObserver(*arena);
+            return created;
         }
 
         /**
@@ -98,20 +741,31 @@ namespace dom_parser
          * @return  DOMnodeID   if node added succefully
          *          -1          if parent does not exist
          */
-        DOMnodeUID addNode(DOMnodeUID parent, std::string tagName)
+        DOMnodeUID addNode(DOMnodeUID parent, std::string_view tagName)
+        {
+            return addNode(parent, getSymbols().intern(tagName));
+        }
+
+        /**
+         * @brief   Adds a node within the tree.
+         * @param   parent   Parent node UID.
+         * @param   tagName  Interned tag name of the node.
+         * @return  DOMnodeID   if node added succefully
+         *          -1          if parent does not exist
+         */
+        DOMnodeUID addNode(DOMnodeUID parent, DOMsymbol tagName)
         {
             if (!checkNodeExistance(parent))
                 return -1;
 
             DOMnodeUID UID = generateUID();
-            std::shared_ptr<DOMnode> node(new DOMnode(tagName, UID, parent));
-
-            if (UID < nodes.size())                      // If a vacant space if filled then use [] operator
-                nodes[UID] = std::move(node);            // otherwise push_back to the end of the vector.
-            else                                         // Condition added to make sure that UID and iterator
-                nodes.push_back(std::move(node));        // position is consistent.
-
-            _nodes(parent).addChild(UID);
+            storeNode(UID, createNode(*nodes, *arena, UID, tagName, UID, parent, arena.get()));
+            _nodes(parent).linkChild(_nodes(UID));
+            updateLabels(_nodes(UID));
+            if (index)
+                index->nodeAdded(_nodes(UID));
+            if (hashes)
+                hashes->nodeAdded(_nodes(UID));
 
             return UID;
         }
@@ -123,24 +777,53 @@ namespace dom_parser
          * @return  DOMnodeID   if node added succefully
          *          -1          if parent does not exist
          */
-        DOMnodeUID addInnerDataNode(DOMnodeUID parent, std::string data)
+        DOMnodeUID addInnerDataNode(DOMnodeUID parent, std::string_view data)
         {
             if (!checkNodeExistance(parent))
                 return -1;
 
             DOMnodeUID UID = generateUID();
-            std::shared_ptr<DOMnode> node(new DOMnode(UID, parent, data));
+            storeNode(UID, createNode(*nodes, *arena, UID, UID, parent, data, arena.get()));
+            _nodes(parent).linkChild(_nodes(UID));
+            updateLabels(_nodes(UID));
+            if (hashes)
+                hashes->nodeAdded(_nodes(UID));
+            if (textIndex)
+                textIndex->nodeAdded(_nodes(UID));
 
-            if (UID < nodes.size())                      // If a vacant space if filled then use [] operator
-                nodes[UID] = std::move(node);            // otherwise push_back to the end of the vector.
-            else                                         // Condition added to make sure that UID and iterator
-                nodes.push_back(std::move(node));        // position is consistent.
+            return UID;
+        }
 
-            _nodes(parent).addChild(UID);
+        /**
+         * @brief   Adds a node as the previous sibling of another node in O(1).
+         * @param   reference   UID of the sibling to insert before.
+         * @param   tagName     Tag name of the node.
+         * @return  DOMnodeID   if node added succefully
+         *          -1          if reference does not exist or is the root
+         */
+        DOMnodeUID insertNodeBefore(DOMnodeUID reference, std::string_view tagName)
+        {
+            return insertNodeAt(reference, getSymbols().intern(tagName), false);
+        }
 
-            return UID;
+        /**
+         * @brief   Adds a node as the next sibling of another node in O(1).
+         * @param   reference   UID of the sibling to insert after.
+         * @param   tagName     Tag name of the node.
+         * @return  DOMnodeID   if node added succefully
+         *          -1          if reference does not exist or is the root
+         */
+        DOMnodeUID insertNodeAfter(DOMnodeUID reference, std::string_view tagName)
+        {
+            return insertNodeAt(reference, getSymbols().intern(tagName), true);
         }
 
+        /**
+         * @brief   Starts a batch of mutations which are applied together by
+         *          DOMtreeBatch::commit().
+         */
+        DOMtreeBatch batch();
+
         /**
          * @brief   Returns a reference to the node with given UID.
          * @param   node    UID of the node.
@@ -151,7 +834,37 @@ namespace dom_parser
         }
 
         /**
-         * @brief   Moves a whole subtree from one parent node to another.
+         * @brief   Returns a const reference to the node with given UID.
+         * @param   node    UID of the node.
+         */
+        inline const DOMnode &getNode(DOMnodeUID node) const
+        {
+            return *nodes->get(uidSlot(node));
+        }
+
+        /**
+         * @brief   Returns number of nodes in the tree.
+         */
+        inline std::int64_t getNodeCount() const
+        {
+            return nodes->count();
+        }
+
+        /**
+         * @brief   Checks if the UID refers to a live node of the tree, in O(1).
+         *          UIDs of deleted nodes stay invalid even when their slots
+         *          are reused.
+         * @param   node    UID of the node.
+         */
+        inline bool isValid(DOMnodeUID node) const
+        {
+            return checkNodeExistance(node);
+        }
+
+        /**
+         * @brief   Moves a whole subtree from one parent node to another,
+         *          the subtree becomes the last child of the new parent.
+         *          Relinking is O(1) regardless of number of siblings.
          * @param   subtree_root     Subtree root node UID.
          * @param   new_parent       New parent node of the subtree.
          * @return  true    if moving is successful
@@ -159,55 +872,106 @@ namespace dom_parser
          */
         bool moveSubtree(DOMnodeUID subtree_root, DOMnodeUID new_parent)
         {
-            if (!checkNodeExistance(subtree_root) || !checkNodeExistance(new_parent))
-                return false;
-            if (subtree_root == 0)
-                return false;
-            if (subtree_root == new_parent)
+            if (!checkMove(subtree_root, new_parent))
                 return false;
 
-            std::vector<DOMnodeUID> ancestors = getAncestorList(new_parent);
-            for (DOMnodeUID ancestor : ancestors)
-                if (ancestor == subtree_root)
-                    return false;
-
-            DOMnodeUID old_parent = _nodes(subtree_root).getParent();
-            _nodes(old_parent).removeChild(subtree_root);
-            _nodes(new_parent).addChild(subtree_root);
-            _nodes(subtree_root).setParent(new_parent);
+            relink(_nodes(subtree_root), new_parent, nullptr, false);
             return true;
         }
 
         /**
-         * @brief   Deletes the subtree with the given node as root.
-         *          Deletes the single node if no child nodes present.
-         * @param   subtree_root Subtree root node.
+         * @brief   Moves a whole subtree so that it becomes the previous
+         *          sibling of the reference node.
+         * @param   subtree_root     Subtree root node UID.
+         * @param   reference        Node before which the subtree is placed.
+         * @return  true    if moving is successful
+         *          false   if moving is unsuccessful due to problem in input.
          */
-        void deleteSubtree(DOMnodeUID subtree_root)
+        bool moveSubtreeBefore(DOMnodeUID subtree_root, DOMnodeUID reference)
         {
-            if (!checkNodeExistance(subtree_root))
-                return;
-
-            DOMnodeUID current_node; // = subtree_root;
-            std::queue<DOMnodeUID> node_queue;
-            node_queue.push(subtree_root);
-
-            while (!node_queue.empty())
-            {
-                current_node = node_queue.front();
-
-                for (DOMnodeUID node : _nodes(current_node).getChildrenUID())
-                    node_queue.push(node);
-                node_queue.pop();
+            if (!checkNodeExistance(reference) || reference == subtree_root ||
+                !checkMove(subtree_root, _nodes(reference).getParent()))
+                return false;
 
-                vacantUIDs.push(current_node);
-                nodes[current_node] = std::shared_ptr<DOMnode>(new DOM_TREE_DELETED_NODE);
-                nodes_counter--;
-            }
+            relink(_nodes(subtree_root), _nodes(reference).getParent(), &_nodes(reference), false);
+            return true;
         }
 
         /**
-         * @brief   Returns std::vector of ancestors of the given node.
+         * @brief   Moves a whole subtree so that it becomes the next
+         *          sibling of the reference node.
+         * @param   subtree_root     Subtree root node UID.
+         * @param   reference        Node after which the subtree is placed.
+         * @return  true    if moving is successful
+         *          false   if moving is unsuccessful due to problem in input.
+         */
+        bool moveSubtreeAfter(DOMnodeUID subtree_root, DOMnodeUID reference)
+        {
+            if (!checkNodeExistance(reference) || reference == subtree_root ||
+                !checkMove(subtree_root, _nodes(reference).getParent()))
+                return false;
+
+            relink(_nodes(subtree_root), _nodes(reference).getParent(), &_nodes(reference), true);
+            return true;
+        }
+
+        /**
+         * @brief   Deletes the subtree with the given node as root.
+         *          Deletes the single node if no child nodes present.
+         *          The slots of the nodes are marked dead in place and handed
+         *          to the free list in one step, memory of the nodes is reused
+         *          by the nodes added later. Does not allocate unless run by
+         *          several threads.
+         * @param   subtree_root Subtree root node.
+         * @param   threads      number of threads to share the children
+         *                       subtrees of the root between
+         */
+        void deleteSubtree(DOMnodeUID subtree_root, unsigned threads = 1)
+        {
+            if (!checkNodeExistance(subtree_root))
+                return;
+
+            DOMnode &root = _nodes(subtree_root);
+            if (root.getParent() != -1)
+            {
+                if (hashes)
+                    hashes->nodeChanged(root.getParent());
+                _nodes(root.getParent()).unlinkChild(root);
+            }
+
+            if (threads <= 1 || root.getChildCount() < 2)
+            {
+                DOMnodeTable::vacant_chain_t chain;
+                burySubtree(root, chain);
+                nodes->releaseChain(chain);
+                if (index)
+                    index->nodesDeleted(std::size_t(chain.count));
+                if (textIndex)
+                    textIndex->nodesDeleted(std::size_t(chain.count));
+                return;
+            }
+
+            std::int64_t before = nodes->count();
+
+            // children subtrees are taken one by one by the threads, each
+            // thread collects its own chain of vacant slots, the last chain
+            // takes the root
+            std::vector<DOMnodeUID> children(root.getChildrenUID().begin(), root.getChildrenUID().end());
+            std::vector<DOMnodeTable::vacant_chain_t> chains(parallelRanges(threads, children.size()) + 1);
+            parallelEach(chains.size() - 1, children.size(), [&](std::size_t w, std::size_t i)
+                         { burySubtree(_nodes(children[i]), chains[w]); });
+
+            nodes->bury(uidSlot(subtree_root), chains.back());
+            for (auto &chain : chains)
+                nodes->releaseChain(chain);
+            if (index)
+                index->nodesDeleted(std::size_t(before - nodes->count()));
+            if (textIndex)
+                textIndex->nodesDeleted(std::size_t(before - nodes->count()));
+        }
+
+        /**
+         * @brief   Returns std::vector of ancestors of the given node.
          * @param   node     The node UID.
          */
         std::vector<DOMnodeUID> getAncestorList(DOMnodeUID node)
@@ -223,19 +987,1346 @@ namespace dom_parser
         }
 
         /**
-         * @brief   Operator overload for =
-         * */
-        DOMtree &operator=(const DOMtree &tree)
+         * @brief   Enables or disables the pre/post-order interval labels.
+         *          While enabled, the labels are kept up to date on mutation
+         *          (or recomputed lazily when there is no room left), which
+         *          makes isAncestor() and the cycle check of the moves O(1).
+         *          Moving a subtree costs O(subtree size) for small subtrees.
+         * @param   enable  true to enable labels
+         */
+        void enableIntervalLabels(bool enable = true)
+        {
+            labelsEnabled = enable;
+            labelsDirty = true;
+        }
+
+        /**
+         * @brief   Checks if a is a proper ancestor of b. Uses the interval
+         *          labels when enabled, relabeling the tree first if required,
+         *          otherwise walks up from b. Does not allocate.
+         * @param   a   UID of the supposed ancestor
+         * @param   b   UID of the node
+         * @return  false if either node does not exist
+         */
+        bool isAncestor(DOMnodeUID a, DOMnodeUID b)
+        {
+            if (!checkNodeExistance(a) || !checkNodeExistance(b))
+                return false;
+            if (!labelsEnabled)
+                return walkIsAncestor(a, b);
+            if (labelsDirty)
+                relabel();
+            return labelsEnclose(_nodes(a), _nodes(b));
+        }
+
+        /**
+         * @brief   Brings the interval labels up to date, if enabled. The pre
+         *          labels (DOMnode::getPreLabel()) then order the nodes in
+         *          document order, until the tree is modified. Can be called
+         *          by concurrent readers of a tree which is not modified: the
+         *          labels are recomputed once, under a lock, and reading the
+         *          tree afterwards, isAncestor() included, writes nothing.
+         * @return  true if interval labels are enabled
+         */
+        bool refreshIntervalLabels()
+        {
+            if (!labelsEnabled)
+                return false;
+            std::lock_guard<std::mutex> lock(*labelsMutex);
+            if (labelsDirty)
+                relabel();
+            return true;
+        }
+
+        /**
+         * @brief   Enables the secondary indexes of the tree, built from its
+         *          nodes (by several threads for big trees) and kept up to date
+         *          by the additions of nodes and by the attributes set on the
+         *          nodes, so that lookups by tag, id or class take O(k) for k
+         *          results instead of a walk of the tree. Deleted nodes and
+         *          changed attributes are dropped from the indexes lazily.
+         *          Replaces indexes enabled before.
+         * @param   tags            index nodes by tag name
+         * @param   idAttribute     name of the id attribute to index, such as
+         *                          "android:id", empty for no id index
+         * @param   classAttribute  name of the whitespace separated token list
+         *                          attribute to index, empty for none
+         * @param   threads         maximum number of threads to build with
+         */
+        void enableIndexes(bool tags = true, std::string_view idAttribute = "id",
+                           std::string_view classAttribute = "class",
+                           unsigned threads = std::thread::hardware_concurrency())
+        {
+            index.reset();
+            index = std::make_unique<DOMindex>(
+                *arena, nodes.get(), tags,
+                (idAttribute.empty() ? DOMsymbolTable::NO_SYMBOL : getSymbols().intern(idAttribute)),
+                (classAttribute.empty() ? DOMsymbolTable::NO_SYMBOL : getSymbols().intern(classAttribute)));
+            index->build(threads);
+        }
+
+        /**
+         * @brief   Returns the secondary indexes of the tree, rebuilt first if
+         *          they could not follow its changes, nullptr if not enabled.
+         */
+        DOMindex *getIndexes()
+        {
+            return (indexReady() ? index.get() : nullptr);
+        }
+
+        /**
+         * @brief   Drops the secondary indexes of the tree.
+         */
+        void disableIndexes()
+        {
+            index.reset();
+        }
+
+        /**
+         * @brief   Enables the Merkle hashes of the subtrees of the tree,
+         *          computed now (by several threads for big trees, so best
+         *          right after loading it) and kept up to date by the changes
+         *          of the tree: a change marks the path to the root dirty and
+         *          the next getHash() recomputes that path only. Equal
+         *          subtrees, of this tree or of any other, have equal hashes.
+         *          Replaces hashes enabled before.
+         * @param   wide        compute 128-bit hashes instead of 64-bit
+         * @param   threads     maximum number of threads to build with
+         */
+        void enableHashes(bool wide = false, unsigned threads = std::thread::hardware_concurrency())
+        {
+            hashes.reset();
+            hashes = std::make_unique<DOMhashes>(*arena, nodes.get(), wide);
+            hashes->build(threads);
+        }
+
+        /**
+         * @brief   Returns the hash of the subtree of the node, in O(1) if
+         *          the subtree did not change since the last call. An empty
+         *          DOMhash if hashes are not enabled or the node does not
+         *          exist.
+         * @param   node    UID of the node.
+         */
+        DOMhash getHash(DOMnodeUID node = 0)
+        {
+            if (!hashes || !checkNodeExistance(node))
+                return DOMhash();
+            if (hashes->isStale())
+                hashes->build(std::thread::hardware_concurrency());
+            return hashes->getHash(_nodes(node));
+        }
+
+        /**
+         * @brief   Drops the hashes of the subtrees.
+         */
+        void disableHashes()
+        {
+            hashes.reset();
+        }
+
+        /**
+         * @brief   Enables the inverted index of the words of the inner-data,
+         *          built now (by several threads for big trees, each filling
+         *          partial lists merged at the end) and kept up to date by the
+         *          inner-data nodes added and the inner-data replaced, so that
+         *          findText() takes O(k) for k results instead of a walk of the
+         *          tree. Deleted nodes are dropped from the index lazily.
+         *          Replaces an index enabled before.
+         * @param   threads     maximum number of threads to build with
+         */
+        void enableTextIndex(unsigned threads = std::thread::hardware_concurrency())
+        {
+            textIndex.reset();
+            textIndex = std::make_unique<DOMtextIndex>(*arena, nodes.get());
+            textIndex->build(threads);
+        }
+
+        /**
+         * @brief   Drops the inverted index of the inner-data.
+         */
+        void disableTextIndex()
+        {
+            textIndex.reset();
+        }
+
+        /**
+         * @brief   Returns UIDs of the inner-data nodes holding all the words
+         *          of the query, words being runs of letters and digits (see
+         *          DOMtextIndex). In increasing order of UID and O(k) per word
+         *          with the text index, in slot order walking all the nodes
+         *          without it.
+         * @param   query   one or more words, such as "goldenrod"
+         */
+        std::vector<DOMnodeUID> findText(std::string_view query)
+        {
+            std::vector<DOMnodeUID> found;
+            if (textIndex)
+            {
+                if (textIndex->isStale())
+                    textIndex->build(std::thread::hardware_concurrency());
+                textIndex->findText(query, found);
+                return found;
+            }
+            std::vector<std::string_view> words;
+            DOMtextIndex::forEachWord(query, [&](std::string_view word) { words.push_back(word); });
+            if (words.empty())
+                return found;
+            for (std::uint64_t slot = 0; slot < nodes->size(); ++slot)
+            {
+                DOMnode *node = nodes->get(slot);
+                if (node == deletedNode || !node->isInnerDataNode())
+                    continue;
+                if (std::all_of(words.begin(), words.end(), [&](std::string_view word)
+                                { return DOMtextIndex::containsWord(node->getInnerData(), word); }))
+                    found.push_back(node->getUID());
+            }
+            return found;
+        }
+
+        /**
+         * @brief   Enables the cache of the numbers parsed by the typed
+         *          accessors of the tree, getAttributeAs() and the like, so
+         *          that reading a number again costs a lookup in the slot of
+         *          its node instead of a parse. Entries are dropped when their
+         *          attribute or inner-data changes.
+         */
+        void enableNumberCache()
+        {
+            numbers = std::make_unique<DOMnumberCache>(*arena, nodes.get());
+        }
+
+        /**
+         * @brief   Drops the cache of the parsed numbers.
+         */
+        void disableNumberCache()
+        {
+            numbers.reset();
+        }
+
+        /**
+         * @brief   Returns value of the said attribute of the node parsed as
+         *          a number of type T (see parseNumber()), through the number
+         *          cache if enabled. Returns nothing if the node or the
+         *          attribute does not exist or it is not such a number.
+         * @param   node        UID of the node
+         * @param   attribute   Name of the attribute
+         */
+        template <class T>
+        std::optional<T> getAttributeAs(DOMnodeUID node, std::string_view attribute)
+        {
+            DOMsymbol name = getSymbols().find(attribute);
+            if (!checkNodeExistance(node) || name == DOMsymbolTable::NO_SYMBOL)
+                return std::nullopt;
+            return (numbers ? numbers->getNumber<T>(_nodes(node), name) : _nodes(node).getAttributeAs<T>(name));
+        }
+
+        /**
+         * @brief   Returns the text of the node (see DOMnode::getTextNode())
+         *          parsed as a number of type T, through the number cache if
+         *          enabled. Returns nothing if the node does not exist, has no
+         *          text or it is not such a number.
+         * @param   node    UID of the node
+         */
+        template <class T>
+        std::optional<T> getInnerDataAs(DOMnodeUID node)
+        {
+            const DOMnode *text = (checkNodeExistance(node) ? _nodes(node).getTextNode() : nullptr);
+            if (!text)
+                return std::nullopt;
+            return (numbers ? numbers->getNumber<T>(*text, DOMsymbolTable::NO_SYMBOL) : text->getInnerDataAs<T>());
+        }
+
+        /**
+         * @brief   Returns value of the said attribute of the node parsed as
+         *          a number with a unit such as "10dp", through the number
+         *          cache if enabled. Returns nothing if the node or the
+         *          attribute does not exist or it is not such a dimension.
+         * @param   node        UID of the node
+         * @param   attribute   Name of the attribute
+         */
+        std::optional<DOMdimension> getAttributeDimension(DOMnodeUID node, std::string_view attribute)
+        {
+            DOMsymbol name = getSymbols().find(attribute);
+            if (!checkNodeExistance(node) || name == DOMsymbolTable::NO_SYMBOL)
+                return std::nullopt;
+            if (numbers)
+                return numbers->getDimension(_nodes(node), name);
+            DOMdimension dimension;
+            const std::string_view *value = _nodes(node).findAttribute(name);
+            if (!value || !parseDimension(*value, dimension))
+                return std::nullopt;
+            return dimension;
+        }
+
+        /**
+         * @brief   Parses the said attribute of each of the nodes as a number
+         *          of type T, looking the name up once for the whole column.
+         * @param   uids        UIDs of the nodes
+         * @param   attribute   Name of the attribute
+         * @param   values      filled with the value of each node, missing
+         *                      where getAttributeAs() returns nothing
+         * @param   missing     value of the nodes without such a number
+         * @return  number of the nodes with such a number
+         */
+        template <class T>
+        std::size_t getAttributesAs(const std::vector<DOMnodeUID> &uids, std::string_view attribute,
+                                    std::vector<T> &values, T missing = T())
+        {
+            values.assign(uids.size(), missing);
+            DOMsymbol name = getSymbols().find(attribute);
+            if (name == DOMsymbolTable::NO_SYMBOL)
+                return 0;
+            std::size_t parsed = 0;
+            for (std::size_t i = 0; i < uids.size(); ++i)
+            {
+                if (!checkNodeExistance(uids[i]))
+                    continue;
+                std::optional<T> value = (numbers ? numbers->getNumber<T>(_nodes(uids[i]), name)
+                                                  : _nodes(uids[i]).getAttributeAs<T>(name));
+                if (value)
+                {
+                    values[i] = *value;
+                    ++parsed;
+                }
+            }
+            return parsed;
+        }
+
+        /**
+         * @brief   Parses the text of each of the nodes (see
+         *          DOMnode::getTextNode()) as a number of type T, such as the
+         *          prices of all the <P_RETAILPRICE> elements at once.
+         * @param   uids        UIDs of the nodes
+         * @param   values      filled with the value of each node, missing
+         *                      where getInnerDataAs() returns nothing
+         * @param   missing     value of the nodes without such a number
+         * @return  number of the nodes with such a number
+         */
+        template <class T>
+        std::size_t getInnerDataAs(const std::vector<DOMnodeUID> &uids, std::vector<T> &values, T missing = T())
+        {
+            values.assign(uids.size(), missing);
+            std::size_t parsed = 0;
+            for (std::size_t i = 0; i < uids.size(); ++i)
+            {
+                const DOMnode *text = (checkNodeExistance(uids[i]) ? _nodes(uids[i]).getTextNode() : nullptr);
+                if (!text)
+                    continue;
+                std::optional<T> value = (numbers ? numbers->getNumber<T>(*text, DOMsymbolTable::NO_SYMBOL)
+                                                  : text->getInnerDataAs<T>());
+                if (value)
+                {
+                    values[i] = *value;
+                    ++parsed;
+                }
+            }
+            return parsed;
+        }
+
+        /**
+         * @brief   Returns UIDs of the element nodes with the tag name, in no
+         *          particular order. O(k) with the tag index, walks all the
+         *          nodes without it.
+         * @param   tagName     Tag name of the nodes.
+         */
+        std::vector<DOMnodeUID> getElementsByTagName(std::string_view tagName)
+        {
+            std::vector<DOMnodeUID> found;
+            DOMsymbol tag = getSymbols().find(tagName);
+            if (tag == DOMsymbolTable::NO_SYMBOL)
+                return found;
+            if (indexReady() && index->hasTags())
+            {
+                index->findTag(tag, found);
+                return found;
+            }
+            for (std::uint64_t slot = 0; slot < nodes->size(); ++slot)
+            {
+                DOMnode *node = nodes->get(slot);
+                if (node != deletedNode && !node->isInnerDataNode() && node->getTagSymbol() == tag)
+                    found.push_back(node->getUID());
+            }
+            return found;
+        }
+
+        /**
+         * @brief   Returns UID of the node whose id attribute (see
+         *          enableIndexes(), "id" if ids are not indexed) has the value,
+         *          any of them if there are many. O(1) with the id index,
+         *          walks all the nodes without it.
+         * @param   id      value of the id attribute
+         * @return  -1 if there is no such node
+         */
+        DOMnodeUID getElementById(std::string_view id)
+        {
+            if (id.empty())
+                return -1;
+            if (indexReady() && index->getIdAttribute() != DOMsymbolTable::NO_SYMBOL)
+                return index->findId(id);
+            DOMsymbol attribute = getSymbols().find("id");
+            for (std::uint64_t slot = 0; slot < nodes->size(); ++slot)
+            {
+                const std::string_view *value = nodes->get(slot)->findAttribute(attribute);
+                if (value && *value == id && nodes->get(slot) != deletedNode)
+                    return nodes->get(slot)->getUID();
+            }
+            return -1;
+        }
+
+        /**
+         * @brief   Returns UIDs of the nodes whose class attribute (see
+         *          enableIndexes(), "class" if classes are not indexed) holds
+         *          the class name among its whitespace separated tokens, in no
+         *          particular order. O(k) with the class index, walks all the
+         *          nodes without it.
+         * @param   className   the class name, a single token
+         */
+        std::vector<DOMnodeUID> getElementsByClassName(std::string_view className)
+        {
+            std::vector<DOMnodeUID> found;
+            if (className.empty())
+                return found;
+            if (indexReady() && index->getClassAttribute() != DOMsymbolTable::NO_SYMBOL)
+            {
+                index->findClass(className, found);
+                return found;
+            }
+            DOMsymbol attribute = getSymbols().find("class");
+            for (std::uint64_t slot = 0; slot < nodes->size(); ++slot)
+            {
+                const std::string_view *value = nodes->get(slot)->findAttribute(attribute);
+                if (value && DOMindex::containsToken(*value, className) && nodes->get(slot) != deletedNode)
+                    found.push_back(nodes->get(slot)->getUID());
+            }
+            return found;
+        }
+
+        /**
+         * @brief   Checks if the node is in the subtree rooted at subtree_root,
+         *          the root itself included.
+         * @param   node            UID of the node
+         * @param   subtree_root    UID of the subtree root
+         */
+        inline bool isInSubtree(DOMnodeUID node, DOMnodeUID subtree_root)
+        {
+            return (node == subtree_root && checkNodeExistance(node)) || isAncestor(subtree_root, node);
+        }
+
+        /**
+         * @brief   Returns an independent copy of the tree with the same UIDs.
+         *          Nodes are copied in O(n), their data is copy-on-write: the
+         *          clone shares the symbol table, inner-data and attribute
+         *          values with this tree (which are never modified in place)
+         *          and keeps them alive, new values set on either tree are
+         *          stored in the arena of that tree only.
+         */
+        DOMtree clone() const
+        {
+            DOMtree copy(arena->getUserResource(), arena->shareSymbols());
+            copy.arena->share(arena);
+
+            std::uint64_t size = nodes->size();
+            if (size > 0)
+                copy.nodes->reserve(size);
+            for (std::uint64_t slot = 0; slot < size; ++slot)
+            {
+                copy.nodes->setGeneration(slot, nodes->getGeneration(slot));
+                if (nodes->get(slot) != deletedNode)
+                    copy.nodes->set(slot, copy.arena->create<DOMnode>(*nodes->get(slot), copy.arena.get()));
+            }
+            for (std::uint64_t slot = size; slot-- > 0;) // lowest slots are reused first
+                if (nodes->isRetired(slot))
+                    copy.nodes->retire(slot);
+                else if (nodes->get(slot) == deletedNode)
+                    copy.nodes->pushVacant(slot);
+            for (std::uint64_t slot = 0; slot < size; ++slot)
+                if (nodes->get(slot) != deletedNode)
+                    for (DOMnodeUID child : nodes->get(slot)->getChildrenUID())
+                        copy.nodes->get(slot)->linkChild(copy._nodes(child));
+
+            copy.nodes->addCount(nodes->count());
+            copy.labelsEnabled = labelsEnabled;
+            copy.labelsDirty = labelsDirty;
+            return copy;
+        }
+
+        /**
+         * @brief   Copies a subtree of the tree as the last child of a node, in
+         *          one pass: the UIDs of all the copies are taken at once, the
+         *          names are reused and the data (inner-data and values of the
+         *          attributes) is shared with the original, as strings of a
+         *          tree are never modified in place. Big subtrees are copied by
+         *          several threads, a user supplied memory resource of the
+         *          tree must then be thread-safe. new_parent may be inside the
+         *          subtree.
+         * @param   subtree_root    root of the subtree to copy
+         * @param   new_parent      parent of the copy
+         * @param   threads         maximum number of threads to use
+         * @return  UID of the copy of subtree_root, -1 if either node does not
+         *          exist or new_parent is an inner-data node
+         */
+        DOMnodeUID cloneSubtree(DOMnodeUID subtree_root, DOMnodeUID new_parent,
+                                unsigned threads = std::thread::hardware_concurrency())
+        {
+            return copySubtree(*this, subtree_root, new_parent, false, threads);
+        }
+
+        /**
+         * @brief   Copies a subtree of another tree as the last child of a node
+         *          of this tree, in one pass like cloneSubtree(). Names are
+         *          interned in this tree once per distinct name, or reused as
+         *          they are when the trees share the symbol table. The data is
+         *          copied, the other tree may be destroyed afterwards.
+         * @param   other           tree to copy from, not modified
+         * @param   subtree_root    root of the subtree to copy, in other
+         * @param   new_parent      parent of the copy, in this tree
+         * @param   threads         maximum number of threads to use
+         * @return  UID of the copy of subtree_root, -1 if either node does not
+         *          exist or new_parent is an inner-data node
+         */
+        DOMnodeUID graft(const DOMtree &other, DOMnodeUID subtree_root, DOMnodeUID new_parent,
+                         unsigned threads = std::thread::hardware_concurrency())
+        {
+            return copySubtree(other, subtree_root, new_parent, true, threads);
+        }
+
+        /**
+         * @brief   Renumbers the live nodes in depth-first order and moves
+         *          them, with their data, to a fresh arena in that order. Dead
+         *          slots and memory of the deleted nodes are released (unless
+         *          clones of the tree still share it), so that traversals get
+         *          their locality back after heavy churn. Big trees are copied
+         *          by several threads, a user supplied memory resource of the
+         *          tree must then be thread-safe. Invalidates references to
+         *          the nodes.
+         * @param   threads     maximum number of threads to use
+         * @return  new UIDs indexed by slots of the old UIDs (uidSlot()),
+         *          -1 for slots of no node. The slots of the new UIDs follow
+         *          the depth-first order. A node keeps its UID if it stays
+         *          in its slot, otherwise the generation of the slot is
+         *          bumped past the node it held, so that handles taken
+         *          before compaction never refer to another node after it.
+         *          Retired slots and slots whose generations are exhausted
+         *          are skipped.
+         */
+        std::vector<DOMnodeUID> compact(unsigned threads = std::thread::hardware_concurrency())
+        {
+            std::uint64_t size = nodes->size();
+            std::vector<DOMnodeUID> renumbered(size, -1);
+            std::vector<DOMnodeUID> order;
+            order.reserve(nodes->count());
+            // generation of a new slot holding the node (-1 for none): past
+            // the node the old slot held unless it is the same node, -1 if
+            // the slot is retired or that would exhaust its generations
+            auto generation = [this, size](std::uint64_t slot, DOMnodeUID uid) -> std::int64_t
+            {
+                if (slot >= size) // never handed out
+                    return 0;
+                if (nodes->isRetired(slot))
+                    return -1;
+                std::uint32_t current = nodes->getGeneration(slot);
+                const DOMnode *held = nodes->get(slot);
+                if (held == deletedNode || held->getUID() == uid)
+                    return current;
+                return (current == DOMnodeTable::MAX_GENERATION ? -1 : std::int64_t(current) + 1);
+            };
+            if (checkNodeExistance(0))
+            {
+                DOMnode *node = &_nodes(0);
+                while (true) // pre-order walk over the sibling links
+                {
+                    while (generation(order.size(), node->getUID()) < 0)
+                        order.push_back(-1); // retired
+                    renumbered[uidSlot(node->getUID())] =
+                        makeNodeUID(order.size(), std::uint32_t(generation(order.size(), node->getUID())));
+                    order.push_back(node->getUID());
+                    if (node->getFirstChild() != -1)
+                    {
+                        node = &_nodes(node->getFirstChild());
+                        continue;
+                    }
+                    while (node->getUID() != 0 && node->getNextSibling() == -1)
+                        node = &_nodes(node->getParent());
+                    if (node->getUID() == 0)
+                        break;
+                    node = &_nodes(node->getNextSibling());
+                }
+            }
+
+            auto target = std::make_shared<DOMarena>(arena->getUserResource(), arena->shareSymbols());
+            target->shareObserver(*arena);
+            DOMnode *vacant = target->create<DOMnode>(DOMsymbolTable::NO_SYMBOL, -1, -1, target.get());
+            auto table = std::make_unique<DOMnodeTable>(vacant);
+            DOMnodeUID count = DOMnodeUID(order.size());
+            if (count > 0)
+            {
+                // the old slots past the nodes are kept vacant with their
+                // generations, handles of their deleted nodes stay invalid
+                table->reserve(std::max<std::uint64_t>(count, size));
+                for (std::uint64_t slot = 0; slot < std::uint64_t(count); ++slot)
+                    if (order[slot] == -1)
+                        table->retire(slot);
+                    else
+                        table->setGeneration(slot, uidGeneration(renumbered[uidSlot(order[slot])]));
+                for (std::uint64_t slot = size; slot-- > std::uint64_t(count);) // lowest slots are reused first
+                {
+                    std::int64_t next = generation(slot, -1);
+                    if (next < 0)
+                        table->retire(slot);
+                    else
+                    {
+                        table->setGeneration(slot, std::uint32_t(next));
+                        table->pushVacant(slot);
+                    }
+                }
+                table->addCount(nodes->count());
+            }
+
+            std::size_t ranges = parallelRanges(threads, std::uint64_t(count), COMPACT_GRAIN);
+            if (ranges == 1)
+            {
+                relocateRange(order, renumbered, 0, count, *target, *table);
+                linkRange(order, renumbered, 0, count, *table);
+            }
+            else
+            {
+                // every thread fills contiguous UIDs from an arena of its own
+                std::vector<std::shared_ptr<DOMarena>> arenas;
+                for (std::size_t r = 0; r < ranges; ++r)
+                {
+                    arenas.push_back(std::make_shared<DOMarena>(arena->getUserResource(), arena->shareSymbols()));
+                    arenas.back()->shareObserver(*arena);
+                    target->share(arenas.back());
+                }
+
+                parallelSlices(ranges, count, [&](std::size_t r, DOMnodeUID lo, DOMnodeUID hi)
+                               { relocateRange(order, renumbered, lo, hi, *arenas[r], *table); });
+                parallelSlices(ranges, count, [&](std::size_t, DOMnodeUID lo, DOMnodeUID hi)
+                               { linkRange(order, renumbered, lo, hi, *table); });
+            }
+
+            arena = std::move(target);
+            deletedNode = vacant;
+            nodes = std::move(table);
+            if (index) // keys of the index refer to the old arena
+                index->invalidate(nodes.get());
+            if (hashes)
+                hashes->invalidate(nodes.get());
+            if (textIndex)
+                textIndex->invalidate(nodes.get());
+            if (numbers) // UIDs are reused by other nodes
+                numbers->invalidate(nodes.get());
+            return renumbered;
+        }
+    };
+
+    /**
+     *  @brief  Handle through which one thread adds nodes to a tree while
+     *          other threads do the same through handles of their own, for
+     *          example to build disjoint subtrees in parallel.
+     *
+     *          Every worker takes UIDs in blocks from the tree (or reuses the
+     *          vacant ones from the lock-free free list), allocates its nodes
+     *          from an arena of its own and links a new node under its parent
+     *          holding only the lock striped by the parent UID, so there is no
+     *          lock global to the tree. Nodes never move once stored.
+     *
+     *          While workers are active, the tree itself must not be modified
+     *          other than through workers, and a worker must only be used by
+     *          one thread at a time. Interval labels and secondary indexes
+     *          are recomputed lazily after a concurrent build. A user supplied memory resource of
+     *          the tree must be thread-safe.
+     * */
+    class DOMtreeWorker
+    {
+    private:
+        static constexpr int UID_BLOCK = 256;
+
+        DOMtree *tree;
+        DOMnodeTable *nodes;
+        std::shared_ptr<DOMarena> arena;
+
+        // unused part of the block of slots taken from the tree
+        std::uint64_t nextSlot = 0;
+        std::uint64_t blockEnd = 0;
+
+        /**
+         * @brief   Generates a new DOMnodeUID, preferring vacant ones.
+         */
+        inline DOMnodeUID generateUID()
+        {
+            std::uint64_t slot = nodes->popVacant();
+            if (slot == DOMnodeTable::NO_SLOT)
+            {
+                if (nextSlot == blockEnd)
+                {
+                    nextSlot = nodes->reserve(UID_BLOCK);
+                    blockEnd = nextSlot + UID_BLOCK;
+                }
+                slot = nextSlot++;
+            }
+            return makeNodeUID(slot, nodes->getGeneration(slot));
+        }
+
+        /**
+         * @brief   Stores the node and links it as the last child of parent.
+         */
+        DOMnodeUID link(DOMnodeUID parent, DOMnode *node)
+        {
+            nodes->set(uidSlot(node->getUID()), node);
+            nodes->addCount(1);
+            {
+                std::lock_guard<std::mutex> lock(nodes->stripe(parent));
+                nodes->get(uidSlot(parent))->linkChild(*node);
+            }
+            return node->getUID();
+        }
+
+    public:
+        /**
+         * @brief   Constructor, may be called concurrently for one tree.
+         * @param   tree    the tree to add nodes to, must outlive the worker
+         */
+        explicit DOMtreeWorker(DOMtree &tree)
+            : tree(&tree), nodes(tree.nodes.get()), arena(tree.createArena())
         {
-            this->nodes = tree.nodes;
-            this->nodes_counter = tree.nodes_counter;
-            this->vacantUIDs = tree.vacantUIDs;
+            std::lock_guard<std::mutex> lock(*tree.workersMutex);
+            tree.labelsDirty = true;
+            if (tree.index && !tree.index->isStale()) // rebuilt after the concurrent build
+                tree.index->invalidate(nodes);
+            if (tree.hashes && !tree.hashes->isStale())
+                tree.hashes->invalidate(nodes);
+            if (tree.textIndex && !tree.textIndex->isStale())
+                tree.textIndex->invalidate(nodes);
+            if (tree.numbers && !tree.numbers->isStale()) // not locked, emptied after the workers
+                tree.numbers->invalidate(nodes);
+        }
+
+        DOMtreeWorker(const DOMtreeWorker &) = delete;
+        DOMtreeWorker &operator=(const DOMtreeWorker &) = delete;
 
-            return *this;
+        /**
+         * @brief   Destructor, returns the unused UIDs to the tree.
+         */
+        ~DOMtreeWorker()
+        {
+            while (nextSlot < blockEnd)
+                nodes->pushVacant(nextSlot++);
+        }
+
+        /**
+         * @brief   Adds a node within the tree.
+         * @param   parent   Parent node UID.
+         * @param   tagName  Tag name of the node.
+         * @return  DOMnodeID   if node added succefully
+         *          -1          if parent does not exist
+         */
+        DOMnodeUID addNode(DOMnodeUID parent, std::string_view tagName)
+        {
+            return addNode(parent, arena->getSymbols().intern(tagName));
+        }
+
+        /**
+         * @brief   Adds a node within the tree.
+         * @param   parent   Parent node UID.
+         * @param   tagName  Interned tag name of the node.
+         * @return  DOMnodeID   if node added succefully
+         *          -1          if parent does not exist
+         */
+        DOMnodeUID addNode(DOMnodeUID parent, DOMsymbol tagName)
+        {
+            if (!tree->checkNodeExistance(parent))
+                return -1;
+            DOMnodeUID UID = generateUID();
+            return link(parent, DOMtree::createNode(*nodes, *arena, UID, tagName, UID, parent, arena.get()));
+        }
+
+        /**
+         * @brief   Adds a inner-data node within the tree under another node.
+         * @param   parent   Parent node UID.
+         * @param   data     inner-data
+         * @return  DOMnodeID   if node added succefully
+         *          -1          if parent does not exist
+         */
+        DOMnodeUID addInnerDataNode(DOMnodeUID parent, std::string_view data)
+        {
+            if (!tree->checkNodeExistance(parent))
+                return -1;
+            DOMnodeUID UID = generateUID();
+            return link(parent, DOMtree::createNode(*nodes, *arena, UID, UID, parent, data, arena.get()));
+        }
+
+        /**
+         * @brief   Returns a reference to the node with given UID, to set
+         *          attributes of the nodes added by this worker.
+         * @param   node    UID of the node.
+         */
+        inline DOMnode &getNode(DOMnodeUID node)
+        {
+            return *nodes->get(uidSlot(node));
         }
     };
 
+    /**
+     *  @brief  Mutations of a tree queued to be applied in one pass. Queuing
+     *          does not touch the tree, commit() checks all the operations at
+     *          once and applies them grouped by kind, in this order:
+     *
+     *          1. inserts, new nodes take a block of consecutive slots, with
+     *             the attribute changes of the new nodes,
+     *          2. moves, with the attribute changes of the existing nodes,
+     *          3. deletes, whose slots are released in one step.
+     *
+     *          Within a kind, operations keep their queue order. Bookkeeping
+     *          is done once per batch or per run of operations under the same
+     *          parent rather than once per operation: interval labels are
+     *          recomputed lazily, the secondary indexes, hashes and text
+     *          index take the new nodes at once, and the parent of a run is
+     *          checked and marked changed once. A batch kept for several
+     *          commits reuses its buffers.
+     *
+     *          Nodes added by the batch are referred to by pending handles,
+     *          negative values below -1 returned by the add methods, which can
+     *          be used in the later operations of the same batch and are
+     *          resolved by commit().
+     * */
+    class DOMtreeBatch
+    {
+    private:
+        struct insert_t
+        {
+            DOMnodeUID parent;
+            DOMnode *parentNode; // set by check() for existing parents
+            DOMsymbol tagName;
+            bool innerData;
+            std::size_t offset; // of inner-data in the text buffer
+            std::size_t length;
+        };
+
+        struct attribute_t
+        {
+            DOMnodeUID node;
+            DOMnode *target; // set by check() for existing nodes
+            DOMsymbol name;
+            bool remove;
+            std::size_t offset; // of value in the text buffer
+            std::size_t length;
+            std::size_t insertsBefore; // number of inserts queued before it
+        };
+
+        struct move_t
+        {
+            DOMnodeUID node;
+            DOMnodeUID parent;
+            DOMnode *subtreeNode; // set by check() for existing nodes
+            DOMnode *parentNode;
+            std::size_t attributesBefore; // number of attribute changes queued before it
+        };
+
+        DOMtree *tree;
+        std::vector<insert_t> inserts;
+        std::vector<attribute_t> attributes;
+        std::vector<move_t> moves;
+        std::vector<DOMnodeUID> deletes;
+        std::string text;
+
+        // UIDs and nodes of the inserted nodes, valid during commit
+        std::vector<DOMnodeUID> created;
+        std::vector<DOMnode *> createdNodes;
+
+        // attribute name interned last, batches tend to repeat names
+        std::string lastName;
+        DOMsymbol lastSymbol = DOMsymbolTable::NO_SYMBOL;
+
+        // string stored last in the text buffer, batches tend to repeat
+        // values too
+        std::size_t lastOffset = 0;
+        std::size_t lastLength = 0;
+
+        /**
+         * @brief   Interns the attribute name, the symbol table is only
+         *          looked up when the name differs from the last one.
+         */
+        inline DOMsymbol internName(std::string_view name)
+        {
+            if (lastSymbol == DOMsymbolTable::NO_SYMBOL || name != lastName)
+            {
+                lastSymbol = tree->getSymbols().intern(name);
+                lastName = name;
+            }
+            return lastSymbol;
+        }
+
+        /**
+         * @brief   Appends the string to the text buffer, unless it repeats
+         *          the string stored last.
+         * @return  offset of the string
+         */
+        inline std::size_t storeText(std::string_view string)
+        {
+            if (string.size() == lastLength && std::string_view(text).substr(lastOffset, lastLength) == string)
+                return lastOffset;
+            lastOffset = text.size();
+            lastLength = string.size();
+            text += string;
+            return lastOffset;
+        }
+
+        /**
+         * @brief   Checks that the handle refers to an existing node or to a
+         *          node added by the batch before the operation with the given
+         *          number of inserts.
+         */
+        inline bool checkHandle(DOMnodeUID handle, std::size_t insertsBefore) const
+        {
+            if (handle >= 0)
+                return tree->checkNodeExistance(handle);
+            return handle <= -2 && std::size_t(-2 - handle) < insertsBefore;
+        }
+
+        /**
+         * @brief   Checks the handle like checkHandle() and looks up the node
+         *          of an existing one, so that it is looked up only once. The
+         *          node is checked by the generation of its slot, the node
+         *          itself is not read until it is changed.
+         * @param   node    receives the node, nullptr for a pending handle
+         */
+        inline bool checkHandle(DOMnodeUID handle, std::size_t insertsBefore, DOMnode *&node) const
+        {
+            node = nullptr;
+            if (handle < 0)
+                return handle <= -2 && std::size_t(-2 - handle) < insertsBefore;
+            std::uint64_t slot = uidSlot(handle);
+            if (slot >= tree->nodes->size())
+                return false;
+            node = tree->nodes->get(slot);
+            return node != tree->deletedNode && tree->nodes->getGeneration(slot) == uidGeneration(handle);
+        }
+
+        /**
+         * @brief   Returns the UID of the handle, inserts must be applied.
+         */
+        inline DOMnodeUID resolve(DOMnodeUID handle) const
+        {
+            return (handle >= 0 ? handle : created[-2 - handle]);
+        }
+
+        /**
+         * @brief   Returns the node of the handle, given the node found by
+         *          check() for it. Inserts must be applied.
+         */
+        inline DOMnode *resolveNode(DOMnodeUID handle, DOMnode *checked) const
+        {
+            return (handle >= 0 ? checked : createdNodes[-2 - handle]);
+        }
+
+        /**
+         * @brief   Checks all the operations against the tree and keeps the
+         *          nodes looked up for the apply phase. The parent of a run
+         *          of inserts or moves under it is checked once, attribute
+         *          changes are checked among the moves in queue order, like
+         *          they are applied.
+         */
+        bool check()
+        {
+            for (std::size_t i = 0; i < inserts.size(); ++i)
+            {
+                DOMnodeUID parent = inserts[i].parent;
+                if (i > 0 && parent == inserts[i - 1].parent)
+                {
+                    inserts[i].parentNode = inserts[i - 1].parentNode;
+                    continue;
+                }
+                if (!checkHandle(parent, i, inserts[i].parentNode))
+                    return false;
+                if (parent >= 0 ? inserts[i].parentNode->isInnerDataNode() : inserts[-2 - parent].innerData)
+                    return false; // inner-data nodes have no children
+            }
+            // node checked last, a node is often changed and then moved
+            DOMnodeUID last = -1;
+            DOMnode *lastNode = nullptr;
+            auto checkNode = [&](DOMnodeUID handle, DOMnode *&node)
+            {
+                if (handle == last && handle != -1)
+                {
+                    node = lastNode;
+                    return true;
+                }
+                if (!checkHandle(handle, inserts.size(), node))
+                    return false;
+                last = handle;
+                lastNode = node;
+                return true;
+            };
+
+            std::size_t attribute = 0;
+            auto checkAttributes = [&](std::size_t attributesBefore)
+            {
+                for (; attribute < attributesBefore; ++attribute)
+                    if (!checkNode(attributes[attribute].node, attributes[attribute].target))
+                        return false;
+                return true;
+            };
+            for (std::size_t i = 0; i < moves.size(); ++i)
+            {
+                move_t &move = moves[i];
+                if (!checkAttributes(move.attributesBefore) || !checkNode(move.node, move.subtreeNode))
+                    return false;
+                if (i > 0 && move.parent == moves[i - 1].parent)
+                    move.parentNode = moves[i - 1].parentNode;
+                else if (!checkHandle(move.parent, inserts.size(), move.parentNode))
+                    return false;
+            }
+            if (!checkAttributes(attributes.size()))
+                return false;
+            for (DOMnodeUID node : deletes)
+                if (!checkHandle(node, inserts.size()))
+                    return false;
+            return true;
+        }
+
+        /**
+         * @brief   Applies the attribute change.
+         */
+        inline void applyAttribute(const attribute_t &attribute)
+        {
+            DOMnode *node = resolveNode(attribute.node, attribute.target);
+            if (attribute.remove)
+                node->removeAttribute(attribute.name);
+            else
+                node->setAttribute(attribute.name, std::string_view(text).substr(attribute.offset, attribute.length));
+        }
+
+        /**
+         * @brief   Applies the attribute changes of added nodes queued before
+         *          the given number of inserts, starting at position next.
+         */
+        void applyAddedAttributes(std::size_t &next, std::size_t insertsBefore)
+        {
+            for (; next < attributes.size() && attributes[next].insertsBefore <= insertsBefore; ++next)
+                if (attributes[next].node < 0)
+                    applyAttribute(attributes[next]);
+        }
+
+        /**
+         * @brief   Applies the attribute changes of existing nodes queued
+         *          before the given number of attribute changes, starting at
+         *          position next.
+         */
+        void applyExistingAttributes(std::size_t &next, std::size_t attributesBefore)
+        {
+            for (; next < attributesBefore; ++next)
+                if (attributes[next].node >= 0)
+                    applyAttribute(attributes[next]);
+        }
+
+        /**
+         * @brief   Creates the inserted nodes in fresh or vacant slots and
+         *          links them, a parent is looked up once for each run of
+         *          inserts under it. Attribute changes of the added nodes are
+         *          applied as soon as the nodes exist, while those are still
+         *          in cache, which gives the same result as applying them
+         *          after all the inserts.
+         */
+        void applyInserts()
+        {
+            DOMnodeTable &nodes = *tree->nodes;
+            DOMarena &arena = *tree->arena;
+
+            created.resize(inserts.size());
+            createdNodes.resize(inserts.size());
+            std::size_t vacant = 0;
+            for (; vacant < inserts.size(); ++vacant)
+            {
+                std::uint64_t slot = nodes.popVacant();
+                if (slot == DOMnodeTable::NO_SLOT)
+                    break;
+                created[vacant] = makeNodeUID(slot, nodes.getGeneration(slot));
+            }
+            if (vacant < inserts.size()) // the rest take one block of fresh slots
+            {
+                std::uint64_t first = nodes.reserve(inserts.size() - vacant);
+                for (std::size_t i = vacant; i < inserts.size(); ++i)
+                    created[i] = makeNodeUID(first + (i - vacant), nodes.getGeneration(first + (i - vacant)));
+            }
+            nodes.addCount(std::int64_t(inserts.size()));
+
+            // parents are always queued before their children, so nodes are
+            // created and linked in one pass
+            std::size_t attribute = 0;
+            for (std::size_t i = 0; i < inserts.size(); ++i)
+            {
+                const insert_t &insert = inserts[i];
+                DOMnodeUID UID = created[i];
+                DOMnodeUID parentUID = resolve(insert.parent);
+                DOMnode *parent = resolveNode(insert.parent, insert.parentNode);
+
+                DOMnode *node;
+                if (insert.innerData)
+                    node = DOMtree::createNode(nodes, arena, UID, UID, parentUID,
+                                               std::string_view(text).substr(insert.offset, insert.length), &arena);
+                else
+                    node = DOMtree::createNode(nodes, arena, UID, insert.tagName, UID, parentUID, &arena);
+                tree->storeNode(UID, node);
+                createdNodes[i] = node;
+                parent->linkChild(*node);
+                applyAddedAttributes(attribute, i + 1);
+            }
+            applyAddedAttributes(attribute, inserts.size());
+
+            // the caches take the new nodes at once
+            if (tree->index)
+                tree->index->nodesAdded(createdNodes);
+            if (tree->hashes)
+                tree->hashes->nodesAdded(createdNodes);
+            if (tree->textIndex)
+                tree->textIndex->nodesAdded(createdNodes);
+        }
+
+        /**
+         * @brief   Applies the moves, a run of moves under the same parent
+         *          at a time: the ancestors of the parent, which the run does
+         *          not change, are collected once to check the moves against
+         *          and the hashes are told about the parent once. Attribute
+         *          changes of existing nodes are applied among the moves in
+         *          queue order, so that a node changed and moved is visited
+         *          once, which gives the same result as applying them before
+         *          all the moves.
+         * @return  false if some move was skipped
+         */
+        bool applyMovesAndAttributes()
+        {
+            bool applied = true;
+            std::size_t attribute = 0;
+            std::vector<const DOMnode *> ancestors;
+            for (std::size_t run = 0, end; run < moves.size(); run = end)
+            {
+                DOMnode &parent = *resolveNode(moves[run].parent, moves[run].parentNode);
+                for (end = run + 1; end < moves.size() && moves[end].parent == moves[run].parent; ++end)
+                    ;
+
+                // a subtree can be moved under parent if its root is not
+                // the parent or one of its ancestors
+                ancestors.clear();
+                if (!parent.isInnerDataNode()) // inner-data nodes have no children
+                    for (DOMnode *node = &parent;; node = &tree->_nodes(node->getParent()))
+                    {
+                        ancestors.push_back(node);
+                        if (node->getParent() == -1)
+                            break;
+                    }
+
+                // old parent of the last move, runs tend to take siblings
+                DOMnodeUID previousUID = -1;
+                DOMnode *previous = nullptr;
+                for (std::size_t i = run; i < end; ++i)
+                {
+                    applyExistingAttributes(attribute, moves[i].attributesBefore);
+                    DOMnode &root = *resolveNode(moves[i].node, moves[i].subtreeNode);
+                    if (ancestors.empty() || root.getUID() == 0 ||
+                        std::find(ancestors.begin(), ancestors.end(), &root) != ancestors.end())
+                    {
+                        applied = false;
+                        continue;
+                    }
+                    if (root.getParent() != previousUID)
+                    {
+                        previousUID = root.getParent();
+                        previous = &tree->_nodes(previousUID);
+                        if (tree->hashes)
+                            tree->hashes->nodeChanged(previousUID);
+                    }
+                    previous->unlinkChild(root);
+                    parent.linkChild(root);
+                    root.setParent(parent.getUID());
+                }
+                if (tree->hashes && !ancestors.empty())
+                    tree->hashes->nodeChanged(parent.getUID());
+            }
+            applyExistingAttributes(attribute, attributes.size());
+            return applied;
+        }
+
+    public:
+        /**
+         * @brief   Constructor, prefer DOMtree::batch().
+         * @param   tree    the tree to mutate, must outlive the batch
+         */
+        explicit DOMtreeBatch(DOMtree &tree) : tree(&tree) {}
+
+        /**
+         * @brief   Queues adding a node as the last child of the parent.
+         * @param   parent   UID or pending handle of the parent.
+         * @param   tagName  Tag name of the node.
+         * @return  pending handle of the node
+         */
+        DOMnodeUID addNode(DOMnodeUID parent, std::string_view tagName)
+        {
+            return addNode(parent, tree->getSymbols().intern(tagName));
+        }
+
+        /**
+         * @brief   Queues adding a node as the last child of the parent.
+         * @param   parent   UID or pending handle of the parent.
+         * @param   tagName  Interned tag name of the node.
+         * @return  pending handle of the node
+         */
+        DOMnodeUID addNode(DOMnodeUID parent, DOMsymbol tagName)
+        {
+            inserts.push_back({parent, nullptr, tagName, false, 0, 0});
+            return -1 - DOMnodeUID(inserts.size());
+        }
+
+        /**
+         * @brief   Queues adding an inner-data node as the last child of the
+         *          parent.
+         * @param   parent   UID or pending handle of the parent.
+         * @param   data     inner-data
+         * @return  pending handle of the node
+         */
+        DOMnodeUID addInnerDataNode(DOMnodeUID parent, std::string_view data)
+        {
+            inserts.push_back({parent, nullptr, DOMsymbolTable::NO_SYMBOL, true, storeText(data), data.size()});
+            return -1 - DOMnodeUID(inserts.size());
+        }
+
+        /**
+         * @brief   Queues setting an attribute of the node.
+         * @param   node        UID or pending handle of the node.
+         * @param   attribute   Name of the attribute.
+         * @param   value       Value of the attribute.
+         */
+        void setAttribute(DOMnodeUID node, std::string_view attribute, std::string_view value)
+        {
+            attributes.push_back({node, nullptr, internName(attribute), false, storeText(value), value.size(),
+                                  inserts.size()});
+        }
+
+        /**
+         * @brief   Queues removing an attribute of the node.
+         * @param   node        UID or pending handle of the node.
+         * @param   attribute   Name of the attribute.
+         */
+        void removeAttribute(DOMnodeUID node, std::string_view attribute)
+        {
+            attributes.push_back({node, nullptr, internName(attribute), true, 0, 0, inserts.size()});
+        }
+
+        /**
+         * @brief   Queues moving the subtree under the new parent, as its
+         *          last child.
+         * @param   subtree_root    UID or pending handle of the subtree root.
+         * @param   new_parent      UID or pending handle of the new parent.
+         */
+        void moveSubtree(DOMnodeUID subtree_root, DOMnodeUID new_parent)
+        {
+            moves.push_back({subtree_root, new_parent, nullptr, nullptr, attributes.size()});
+        }
+
+        /**
+         * @brief   Queues deleting the subtree.
+         * @param   subtree_root    UID or pending handle of the subtree root.
+         */
+        void deleteSubtree(DOMnodeUID subtree_root)
+        {
+            deletes.push_back(subtree_root);
+        }
+
+        /**
+         * @brief   Makes room for the given numbers of operations of each
+         *          kind, so that queuing them does not reallocate.
+         */
+        void reserve(std::size_t addedNodes, std::size_t attributeChanges, std::size_t movedSubtrees = 0,
+                     std::size_t deletedSubtrees = 0)
+        {
+            inserts.reserve(inserts.size() + addedNodes);
+            attributes.reserve(attributes.size() + attributeChanges);
+            moves.reserve(moves.size() + movedSubtrees);
+            deletes.reserve(deletes.size() + deletedSubtrees);
+        }
+
+        /**
+         * @brief   Returns number of queued operations.
+         */
+        inline std::size_t size() const
+        {
+            return inserts.size() + attributes.size() + moves.size() + deletes.size();
+        }
+
+        /**
+         * @brief   Drops the queued operations.
+         */
+        void clear()
+        {
+            inserts.clear();
+            attributes.clear();
+            moves.clear();
+            deletes.clear();
+            text.clear();
+            lastOffset = lastLength = 0;
+            created.clear();
+            createdNodes.clear();
+        }
+
+        /**
+         * @brief   Applies the queued operations and clears the batch. If any
+         *          operation refers to a node which does not exist, nothing is
+         *          applied. Moves which would put a subtree into itself, given
+         *          the moves before them, are skipped.
+         * @param   resolved    if not nullptr, receives the UIDs of the added
+         *                      nodes, in the order they were queued
+         * @return  true    if all the operations were applied
+         *          false   if the batch was rejected or some move skipped
+         */
+        bool commit(std::vector<DOMnodeUID> *resolved = nullptr)
+        {
+            if (!check())
+            {
+                clear();
+                return false;
+            }
+
+            applyInserts();
+
+            // labels are recomputed lazily once instead of on every move
+            if (!inserts.empty() || !moves.empty() || !deletes.empty())
+                tree->labelsDirty = true;
+
+            bool applied = applyMovesAndAttributes();
+
+            DOMnodeTable::vacant_chain_t chain;
+            for (DOMnodeUID handle : deletes)
+            {
+                DOMnodeUID node = resolve(handle);
+                if (!tree->checkNodeExistance(node)) // in a subtree deleted before
+                    continue;
+                DOMnode &root = tree->_nodes(node);
+                if (root.getParent() != -1)
+                {
+                    if (tree->hashes)
+                        tree->hashes->nodeChanged(root.getParent());
+                    tree->_nodes(root.getParent()).unlinkChild(root);
+                }
+                tree->burySubtree(root, chain);
+            }
+            tree->nodes->releaseChain(chain);
+            if (tree->index)
+                tree->index->nodesDeleted(std::size_t(chain.count));
+            if (tree->textIndex)
+                tree->textIndex->nodesDeleted(std::size_t(chain.count));
+
+            if (resolved)
+                *resolved = created;
+            clear();
+            return applied;
+        }
+    };
+
+    inline DOMtreeBatch DOMtree::batch()
+    {
+        return DOMtreeBatch(*this);
+    }
+
 } // namespace dom_parser
 
-#undef DOM_TREE_DELETED_NODE
 #endif
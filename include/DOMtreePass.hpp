@@ -0,0 +1,292 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_TREE_PASS
+#define DOM_PARSER_DOM_TREE_PASS
+
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "DOMparallel.hpp"
+#include "DOMtree.hpp"
+#include "taskflow/taskflow.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Parallel pass over a subtree, top-down and bottom-up at once:
+     *
+     *              ctx    = pre(node, parent's ctx)
+     *              result = post(node, ctx, results of the children)
+     *
+     *          pre runs on a node before its children, post after all of
+     *          them, with the results of the children in document order.
+     *          post may also take (node, results) only. The context of the
+     *          root is computed from the initial context given to run(), the
+     *          result of the root is returned by run().
+     *
+     *          Nodes with subtrees of the cutoff size or bigger get a pre and
+     *          a post task each; the smaller subtrees are run sequentially,
+     *          runs of them under the same parent by one task. The graph of
+     *          tasks is built once and reused by every run, until the
+     *          structure of the tree changes and rebuild() is called. pre and
+     *          post are called concurrently for different nodes.
+     *
+     *          Ctx and Result must be default constructible and movable.
+     * */
+    template <class Ctx, class Result>
+    class DOMtreePass
+    {
+    public:
+        typedef std::function<Ctx(DOMnode &, const Ctx &)> pre_t;
+        typedef std::function<Result(DOMnode &, const Ctx &, std::vector<Result> &)> post_t;
+
+    private:
+        // node whose subtree is at least the cutoff, run by its own tasks
+        struct big_t
+        {
+            DOMnode *node;
+            std::size_t parent; // NONE for the root
+            std::size_t slot;   // position among the children of the parent
+            Ctx ctx;
+            std::vector<Result> results; // of the children
+        };
+
+        // consecutive small subtrees under the same big node
+        struct unit_t
+        {
+            std::size_t parent;
+            std::size_t slot; // of the first subtree
+            std::size_t begin, end; // items of the partition
+            std::size_t size;       // nodes in the items
+        };
+
+        static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+        DOMtree *tree;
+        DOMnodeUID root;
+        std::size_t workers;
+        std::size_t cutoff;
+
+        DOMpartition partition;
+        std::vector<big_t> bigs;
+        std::vector<unit_t> units;
+        tf::Taskflow taskflow;
+
+        // of the current run
+        pre_t pre;
+        post_t post;
+        const Ctx *init = nullptr;
+        Result rootResult;
+
+        /**
+         *  @brief  Runs the pass over the subtree sequentially.
+         *  @param  parentCtx   context of the parent of the subtree root
+         *  @return result of the subtree root
+         * */
+        Result runSubtree(DOMnode &subtree_root, const Ctx &parentCtx) const
+        {
+            struct frame_t
+            {
+                DOMnode *node;
+                Ctx ctx;
+                DOMnodeUID next; // next child to run
+            };
+            std::vector<frame_t> stack;
+            std::vector<std::vector<Result>> levels; // results of the children, per frame
+
+            stack.push_back({&subtree_root, pre(subtree_root, parentCtx), subtree_root.getFirstChild()});
+            levels.emplace_back();
+            while (true)
+            {
+                frame_t &top = stack.back();
+                if (top.next != -1)
+                {
+                    DOMnode &child = tree->getNode(top.next);
+                    top.next = child.getNextSibling();
+                    Ctx ctx = pre(child, top.ctx);
+                    stack.push_back({&child, std::move(ctx), child.getFirstChild()});
+                    if (levels.size() < stack.size())
+                        levels.emplace_back();
+                    levels[stack.size() - 1].clear();
+                    continue;
+                }
+                Result result = post(*top.node, top.ctx, levels[stack.size() - 1]);
+                stack.pop_back();
+                if (stack.empty())
+                    return result;
+                levels[stack.size() - 1].push_back(std::move(result));
+            }
+        }
+
+        /**
+         *  @brief  Builds the graph of tasks from the partition of the
+         *          subtree, cut at the cutoff.
+         * */
+        void build()
+        {
+            partition = DOMpartition(*tree, root, workers, cutoff);
+            bigs.clear();
+            units.clear();
+            taskflow.clear();
+
+            const std::vector<DOMpartition::item_t> &items = partition.getItems();
+            if (items.empty() || items.front().subtree)
+                return; // nothing to split, run() goes sequentially
+
+            // the parent of an item is a big node met before it
+            std::unordered_map<DOMnodeUID, std::size_t> index;
+            std::vector<std::size_t> children; // children met so far, per big node
+            for (std::size_t i = 0; i < items.size(); ++i)
+            {
+                const DOMpartition::item_t &item = items[i];
+                std::size_t parent = NONE, slot = 0;
+                if (i > 0)
+                {
+                    parent = index.at(item.node->getParent());
+                    slot = children[parent]++;
+                }
+                if (!item.subtree)
+                {
+                    index.emplace(item.node->getUID(), bigs.size());
+                    bigs.push_back({item.node, parent, slot, Ctx(), std::vector<Result>(item.node->getChildCount())});
+                    children.push_back(0);
+                }
+                else if (!units.empty() && units.back().parent == parent && units.back().end == i &&
+                         units.back().size + item.size <= partition.getGrain())
+                {
+                    units.back().end = i + 1;
+                    units.back().size += item.size;
+                }
+                else
+                    units.push_back({parent, slot, i, i + 1, item.size});
+            }
+
+            std::vector<tf::Task> preTasks(bigs.size()), postTasks(bigs.size());
+            for (std::size_t b = 0; b < bigs.size(); ++b)
+            {
+                preTasks[b] = taskflow.emplace([this, b]()
+                                               {
+                                                   big_t &big = bigs[b];
+                                                   big.ctx = pre(*big.node, big.parent == NONE ? *init : bigs[big.parent].ctx);
+                                               });
+                postTasks[b] = taskflow.emplace([this, b]()
+                                                {
+                                                    big_t &big = bigs[b];
+                                                    Result result = post(*big.node, big.ctx, big.results);
+                                                    if (big.parent == NONE)
+                                                        rootResult = std::move(result);
+                                                    else
+                                                        bigs[big.parent].results[big.slot] = std::move(result);
+                                                });
+                preTasks[b].precede(postTasks[b]);
+                if (bigs[b].parent != NONE)
+                {
+                    preTasks[bigs[b].parent].precede(preTasks[b]);
+                    postTasks[b].precede(postTasks[bigs[b].parent]);
+                }
+            }
+            for (std::size_t u = 0; u < units.size(); ++u)
+            {
+                tf::Task task = taskflow.emplace([this, u]()
+                                                 {
+                                                     const unit_t &unit = units[u];
+                                                     big_t &parent = bigs[unit.parent];
+                                                     const std::vector<DOMpartition::item_t> &items = partition.getItems();
+                                                     for (std::size_t i = unit.begin; i < unit.end; ++i)
+                                                         parent.results[unit.slot + i - unit.begin] =
+                                                             runSubtree(*items[i].node, parent.ctx);
+                                                 });
+                preTasks[units[u].parent].precede(task);
+                task.precede(postTasks[units[u].parent]);
+            }
+        }
+
+    public:
+        /**
+         *  @brief  Constructor, builds the graph of tasks for the subtree.
+         *  @param  tree    the tree, must outlive the pass
+         *  @param  root    UID of the root of the subtree
+         *  @param  workers number of workers the graph is made for
+         *  @param  cutoff  subtrees smaller than this are run sequentially,
+         *                  0 to pick it from the size of the tree and the
+         *                  number of workers
+         * */
+        explicit DOMtreePass(DOMtree &tree, DOMnodeUID root = 0,
+                             std::size_t workers = std::thread::hardware_concurrency(), std::size_t cutoff = 0)
+            : tree(&tree), root(root), workers(workers), cutoff(cutoff)
+        {
+            build();
+        }
+
+        // tasks of the graph refer to the pass
+        DOMtreePass(const DOMtreePass &) = delete;
+        DOMtreePass &operator=(const DOMtreePass &) = delete;
+
+        /**
+         *  @brief  Rebuilds the graph, to be called after nodes of the
+         *          subtree are added, moved or deleted.
+         * */
+        void rebuild()
+        {
+            build();
+        }
+
+        /**
+         *  @brief  Returns the number of tasks of the graph, 0 if the
+         *          subtree is run sequentially.
+         * */
+        inline std::size_t getTaskCount() const
+        {
+            return taskflow.num_tasks();
+        }
+
+        /**
+         *  @brief  Runs the pass, one run at a time.
+         *  @param  executor    executor to run the tasks on
+         *  @param  initial     context the root's context is computed from
+         *  @param  preFunction     Ctx(DOMnode &, const Ctx &parentCtx)
+         *  @param  postFunction    Result(DOMnode &, const Ctx &, std::vector<Result> &)
+         *                          or Result(DOMnode &, std::vector<Result> &)
+         *  @return result of the root, a default Result if the root is not
+         *          in the tree
+         * */
+        template <class Pre, class Post>
+        Result run(tf::Executor &executor, const Ctx &initial, Pre preFunction, Post postFunction)
+        {
+            pre = std::move(preFunction);
+            if constexpr (std::is_invocable_v<Post &, DOMnode &, std::vector<Result> &>)
+                post = [f = std::move(postFunction)](DOMnode &node, const Ctx &, std::vector<Result> &results)
+                { return f(node, results); };
+            else
+                post = std::move(postFunction);
+
+            if (partition.getItems().empty())
+                return Result();
+            if (bigs.empty() || executor.num_workers() < 2)
+                return runSubtree(tree->getNode(root), initial);
+
+            init = &initial;
+            executor.run(taskflow).wait();
+            init = nullptr;
+            return std::move(rootResult);
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
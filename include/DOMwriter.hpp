@@ -0,0 +1,283 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_WRITER
+#define DOM_PARSER_DOM_WRITER
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "DOMtree.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Buffered destination of the output: a stream, a file
+     *          descriptor or a buffer of the caller drained by a callback.
+     *          Small writes are copied into the buffer, which is handed over
+     *          whole when full; writes bigger than the buffer go straight
+     *          through. The destructor flushes what is left.
+     * */
+    class DOMoutputSink
+    {
+    public:
+        /**
+         *  @brief  Receives the filled part of the buffer, returns false if
+         *          the data could not be written.
+         * */
+        typedef std::function<bool(const char *, std::size_t)> flush_t;
+
+        static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+    private:
+        std::unique_ptr<char[]> owned; // buffer of the stream and fd sinks
+        char *buffer;
+        std::size_t capacity;
+        std::size_t used = 0;
+        flush_t drain;
+        bool failed = false;
+
+        inline void hand(const char *data, std::size_t size)
+        {
+            if (!failed && size > 0 && !drain(data, size))
+                failed = true;
+        }
+
+    public:
+        /**
+         *  @brief  Constructor of a sink writing to the stream.
+         *  @param  size    size of the buffer
+         * */
+        explicit DOMoutputSink(std::ostream &out, std::size_t size = BUFFER_SIZE)
+            : owned(new char[size]), buffer(owned.get()), capacity(size),
+              drain([&out](const char *data, std::size_t size)
+                    { return bool(out.write(data, std::streamsize(size))); })
+        {
+        }
+
+        /**
+         *  @brief  Constructor of a sink writing to the file descriptor,
+         *          which is left open.
+         *  @param  size    size of the buffer
+         * */
+        explicit DOMoutputSink(int fd, std::size_t size = BUFFER_SIZE)
+            : owned(new char[size]), buffer(owned.get()), capacity(size),
+              drain([fd](const char *data, std::size_t size)
+                    {
+                        while (size > 0)
+                        {
+#ifdef _WIN32
+                            int written = ::_write(fd, data, unsigned(size));
+#else
+                            ssize_t written = ::write(fd, data, size);
+#endif
+                            if (written < 0 && errno == EINTR)
+                                continue;
+                            if (written <= 0)
+                                return false;
+                            data += written;
+                            size -= std::size_t(written);
+                        }
+                        return true;
+                    })
+        {
+        }
+
+        /**
+         *  @brief  Constructor of a sink filling the buffer of the caller,
+         *          which is passed to flush whenever it is full and at the end.
+         *  @param  buffer  buffer to be filled, must outlive the sink
+         *  @param  size    size of the buffer, at least 1
+         *  @param  flush   receives the filled part of the buffer
+         * */
+        DOMoutputSink(char *buffer, std::size_t size, flush_t flush)
+            : buffer(buffer), capacity(size), drain(std::move(flush))
+        {
+        }
+
+        DOMoutputSink(const DOMoutputSink &) = delete;
+        DOMoutputSink &operator=(const DOMoutputSink &) = delete;
+
+        ~DOMoutputSink()
+        {
+            flush();
+        }
+
+        inline void write(const char *data, std::size_t size)
+        {
+            if (size <= capacity - used)
+            {
+                std::memcpy(buffer + used, data, size);
+                used += size;
+                return;
+            }
+            flush();
+            if (size >= capacity)
+                hand(data, size);
+            else
+            {
+                std::memcpy(buffer, data, size);
+                used = size;
+            }
+        }
+
+        inline void write(std::string_view data)
+        {
+            write(data.data(), data.size());
+        }
+
+        inline void put(char c)
+        {
+            if (used == capacity)
+                flush();
+            buffer[used++] = c;
+        }
+
+        /**
+         *  @brief  Hands the buffered data over to the destination.
+         * */
+        void flush()
+        {
+            hand(buffer, used);
+            used = 0;
+        }
+
+        /**
+         *  @brief  Returns false if the destination failed to take some data,
+         *          everything written after that is dropped.
+         * */
+        inline bool good() const
+        {
+            return !failed;
+        }
+    };
+
+    /**
+     *  @brief  Serializer of trees into a sink, the format of
+     *          DOMparser::getOutput(). The tree is walked through the parent
+     *          and sibling links of its nodes instead of recursion, so deep
+     *          documents take no stack; the indentation of every depth is a
+     *          prefix of one string grown to the deepest level reached.
+     * */
+    class DOMwriter
+    {
+    private:
+        std::string indent;
+        std::string newline;
+        std::string indentation; // initial indentation followed by indents
+        std::size_t initial;
+
+        inline void writeIndentation(DOMoutputSink &sink, std::size_t depth)
+        {
+            std::size_t length = initial + depth * indent.size();
+            while (indentation.size() < length)
+                indentation += indent;
+            sink.write(indentation.data(), length);
+        }
+
+    public:
+        /**
+         *  @brief  Constructor.
+         *  @param  minified    if the output is required to be in minified
+         *                      form, without indentation and newlines
+         *  @param  indent      string which denotes indentation
+         *  @param  indentation initial indentation of the output, that is
+         *                      the indentation applied on the root node
+         * */
+        DOMwriter(bool minified = false, std::string_view indent = "    ", std::string_view indentation = "")
+            : indent(minified ? "" : indent), newline(minified ? "" : "\n"),
+              indentation(minified ? "" : indentation), initial(this->indentation.size())
+        {
+        }
+
+        /**
+         *  @brief  Writes the subtree into the sink.
+         *  @param  tree    tree holding the subtree
+         *  @param  root    UID of the root of the subtree
+         *  @return 0 if written, -1 if the sink failed
+         * */
+        int write(const DOMtree &tree, DOMnodeUID root, DOMoutputSink &sink)
+        {
+            const DOMnode &subtree_root = tree.getNode(root);
+            const DOMnode *node = &subtree_root;
+            std::size_t depth = 0;
+            while (true)
+            {
+                writeIndentation(sink, depth);
+                if (node->isInnerDataNode())
+                {
+                    sink.write(node->getInnerData());
+                    sink.write(newline);
+                }
+                else
+                {
+                    sink.put('<');
+                    sink.write(node->getTagName());
+                    for (auto attribute : node->getAllAttributes())
+                    {
+                        sink.put(' ');
+                        sink.write(attribute.first);
+                        if (!attribute.second.empty())
+                        {
+                            sink.write("=\"", 2);
+                            sink.write(attribute.second);
+                            sink.put('"');
+                        }
+                    }
+                    if (node->getFirstChild() != -1)
+                    {
+                        sink.put('>');
+                        sink.write(newline);
+                        node = &tree.getNode(node->getFirstChild());
+                        ++depth;
+                        continue;
+                    }
+                    sink.write(" />", 3);
+                    sink.write(newline);
+                }
+
+                // close the elements left by the walk
+                while (node != &subtree_root && node->getNextSibling() == -1)
+                {
+                    node = &tree.getNode(node->getParent());
+                    --depth;
+                    writeIndentation(sink, depth);
+                    sink.write("</", 2);
+                    sink.write(node->getTagName());
+                    sink.put('>');
+                    sink.write(newline);
+                }
+                if (node == &subtree_root)
+                    break;
+                node = &tree.getNode(node->getNextSibling());
+            }
+            sink.flush();
+            return (sink.good() ? 0 : -1);
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
@@ -0,0 +1,1577 @@
+//    Copyright 2020 Mayank Mathur (mynk-9 at Github)
+
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+
+//        http://www.apache.org/licenses/LICENSE-2.0
+
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+#ifndef DOM_PARSER_DOM_XPATH
+#define DOM_PARSER_DOM_XPATH
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "DOMLexer.hpp"
+#include "DOMtree.hpp"
+
+namespace dom_parser
+{
+    /**
+     *  @brief  Match reported by the streaming evaluation of an XPath
+     *          expression.
+     * */
+    struct DOMxpathMatch
+    {
+        enum class kind_t
+        {
+            ELEMENT,
+            ATTRIBUTE,
+            TEXT
+        };
+
+        kind_t kind;
+        std::string name;                              // tag or attribute name, empty for text
+        std::string value;                             // string value of the element, value of the attribute or the text
+        std::map<std::string, std::string> attributes; // attributes of an element
+        std::size_t depth;                             // depth of the element, or of the element owning the match, 0 for root
+    };
+
+    /**
+     *  @brief  Compiled expression of a subset of XPath 1.0, evaluated on a
+     *          built tree or streamed over a file without building it.
+     *
+     *          Supported: location paths with the child (/) and descendant
+     *          (//) steps, name tests and *, @name and @* as the last step,
+     *          text() as the last step, and predicates on element steps:
+     *          [n], [last()], position() compared to a number, relative
+     *          paths (a/b, @a, text(), .) tested for existence or compared
+     *          to a literal with = != < <= > >=, contains() and
+     *          starts-with(), combined with and, or, not() and parentheses.
+     *          Comparisons are numeric when the literal is a number, or for
+     *          < <= > >=, and string comparisons otherwise. A path compares
+     *          true when any of the values it selects does, as in XPath.
+     *
+     *          Every expression of the subset is forward only, except for
+     *          those using last(), which needs the following siblings of a
+     *          node. Those can not be streamed.
+     * */
+    class DOMxpath
+    {
+    private:
+        enum truth_t : char
+        {
+            NO,
+            YES,
+            MAYBE
+        };
+
+        enum class op_t
+        {
+            EXISTS,
+            EQ,
+            NE,
+            LT,
+            LE,
+            GT,
+            GE,
+            CONTAINS,
+            STARTS_WITH
+        };
+
+        // what a step selects, or a path of a predicate ends at
+        enum class terminal_t
+        {
+            ELEMENT, // elements, or the string value of an element
+            ATTRIBUTE,
+            TEXT
+        };
+
+        enum class atom_kind_t
+        {
+            POSITION, // position() compared to a number
+            LAST,     // position() = last()
+            VALUE     // values of a relative path, compared to a literal
+        };
+
+        enum class expr_kind_t
+        {
+            ATOM,
+            AND,
+            OR,
+            NOT
+        };
+
+        // name tests are indexes into names, ANY is *
+        static constexpr int ANY = -1;
+
+        struct literal_t
+        {
+            std::string text;
+            double number = std::numeric_limits<double>::quiet_NaN();
+            bool numeric = false;
+        };
+
+        // relative path in a predicate: child steps, then the string value
+        // of the element reached, its attribute or its text nodes
+        struct relpath_t
+        {
+            std::vector<int> names;
+            terminal_t terminal = terminal_t::ELEMENT;
+            int attribute = ANY;
+        };
+
+        struct atom_t
+        {
+            atom_kind_t kind;
+            std::size_t predicate; // predicate the atom belongs to
+            op_t op = op_t::EXISTS;
+            literal_t literal;
+            relpath_t path;
+        };
+
+        struct expr_t
+        {
+            expr_kind_t kind;
+            int left, right; // operands, or index of the atom
+        };
+
+        struct step_t
+        {
+            bool descendant = false;
+            terminal_t kind = terminal_t::ELEMENT;
+            int name = ANY;
+            std::vector<atom_t> atoms;
+            std::vector<expr_t> nodes;
+            std::vector<int> predicates; // root node of every predicate
+            std::size_t counters = 0;    // offset of the position counters of the step
+        };
+
+        std::vector<std::string> names;
+        std::vector<step_t> steps;
+        bool absolute = false;
+        bool streamable = true;
+        std::size_t counterCount = 0; // position counters kept per element while streaming
+
+        // context of an absolute path, the parent of the root
+        static constexpr DOMnodeUID DOCUMENT = -2;
+
+        /**
+         *  @brief  Hand-written parser of the expressions.
+         * */
+        class parser_t
+        {
+        private:
+            std::string_view text;
+            std::size_t i = 0;
+            DOMxpath &xpath;
+
+            struct operand_t
+            {
+                enum
+                {
+                    PATH,
+                    LITERAL,
+                    POSITION,
+                    LAST
+                } kind;
+                relpath_t path;
+                literal_t literal;
+            };
+
+            static inline bool isNameChar(char c)
+            {
+                return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.' ||
+                       c == ':' || static_cast<unsigned char>(c) >= 0x80;
+            }
+
+            inline void skipSpaces()
+            {
+                while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i])))
+                    ++i;
+            }
+
+            inline bool peek(char c)
+            {
+                skipSpaces();
+                return i < text.size() && text[i] == c;
+            }
+
+            inline bool expect(char c)
+            {
+                if (!peek(c))
+                    return false;
+                ++i;
+                return true;
+            }
+
+            bool name(std::string_view &parsed)
+            {
+                std::size_t start = i;
+                if (i >= text.size() || text[i] == '-' || text[i] == '.' ||
+                    std::isdigit(static_cast<unsigned char>(text[i])))
+                    return false;
+                while (i < text.size() && isNameChar(text[i]))
+                    ++i;
+                parsed = text.substr(start, i - start);
+                return !parsed.empty();
+            }
+
+            int intern(std::string_view parsed)
+            {
+                for (std::size_t n = 0; n < xpath.names.size(); ++n)
+                    if (xpath.names[n] == parsed)
+                        return static_cast<int>(n);
+                xpath.names.emplace_back(parsed);
+                return static_cast<int>(xpath.names.size() - 1);
+            }
+
+            /**
+             *  @brief  Parses a name test, a name or *.
+             * */
+            bool nameTest(int &parsed)
+            {
+                std::string_view n;
+                if (i < text.size() && text[i] == '*')
+                {
+                    ++i;
+                    parsed = ANY;
+                    return true;
+                }
+                if (!name(n))
+                    return false;
+                parsed = intern(n);
+                return true;
+            }
+
+            /**
+             *  @brief  Checks for a function call with no arguments, such
+             *          as text(), and consumes it.
+             * */
+            bool call(std::string_view function)
+            {
+                std::size_t start = i;
+                std::string_view n;
+                if (name(n) && n == function && expect('(') && expect(')'))
+                    return true;
+                i = start;
+                return false;
+            }
+
+            bool keyword(std::string_view word)
+            {
+                skipSpaces();
+                if (text.substr(i, word.size()) != word ||
+                    (i + word.size() < text.size() && isNameChar(text[i + word.size()])))
+                    return false;
+                i += word.size();
+                return true;
+            }
+
+            bool literal(literal_t &parsed)
+            {
+                skipSpaces();
+                if (i >= text.size())
+                    return false;
+                if (text[i] == '"' || text[i] == '\'')
+                {
+                    char quote = text[i++];
+                    std::size_t end = text.find(quote, i);
+                    if (end == std::string_view::npos)
+                        return false;
+                    parsed.text = std::string(text.substr(i, end - i));
+                    parsed.number = toNumber(parsed.text);
+                    parsed.numeric = false;
+                    i = end + 1;
+                    return true;
+                }
+                std::size_t start = i;
+                if (text[i] == '-')
+                    ++i;
+                while (i < text.size() && (std::isdigit(static_cast<unsigned char>(text[i])) || text[i] == '.'))
+                    ++i;
+                parsed.text = std::string(text.substr(start, i - start));
+                parsed.number = toNumber(parsed.text);
+                parsed.numeric = true;
+                if (std::isnan(parsed.number))
+                {
+                    i = start;
+                    return false;
+                }
+                return true;
+            }
+
+            /**
+             *  @brief  Parses a relative path of a predicate.
+             * */
+            bool relpath(relpath_t &path)
+            {
+                skipSpaces();
+                if (i < text.size() && text[i] == '.' && (i + 1 >= text.size() || !isNameChar(text[i + 1])))
+                {
+                    ++i;
+                    return true;
+                }
+                while (true)
+                {
+                    if (i < text.size() && text[i] == '@')
+                    {
+                        ++i;
+                        path.terminal = terminal_t::ATTRIBUTE;
+                        return nameTest(path.attribute);
+                    }
+                    if (call("text"))
+                    {
+                        path.terminal = terminal_t::TEXT;
+                        return true;
+                    }
+                    int n;
+                    if (!nameTest(n))
+                        return false;
+                    path.names.push_back(n);
+                    if (i + 1 < text.size() && text[i] == '/' && text[i + 1] != '/')
+                        ++i;
+                    else
+                        return true;
+                }
+            }
+
+            bool operand(operand_t &parsed)
+            {
+                skipSpaces();
+                if (i >= text.size())
+                    return false;
+                char c = text[i];
+                if (c == '"' || c == '\'' || c == '-' || std::isdigit(static_cast<unsigned char>(c)) ||
+                    (c == '.' && i + 1 < text.size() && std::isdigit(static_cast<unsigned char>(text[i + 1]))))
+                {
+                    parsed.kind = operand_t::LITERAL;
+                    return literal(parsed.literal);
+                }
+                if (call("position"))
+                    return parsed.kind = operand_t::POSITION, true;
+                if (call("last"))
+                    return parsed.kind = operand_t::LAST, true;
+                parsed.kind = operand_t::PATH;
+                return relpath(parsed.path);
+            }
+
+            bool comparison(op_t &op)
+            {
+                skipSpaces();
+                std::string_view rest = text.substr(i);
+                static const std::pair<std::string_view, op_t> OPERATORS[] = {
+                    {"!=", op_t::NE}, {"<=", op_t::LE}, {">=", op_t::GE}, {"=", op_t::EQ}, {"<", op_t::LT}, {">", op_t::GT}};
+                for (const auto &candidate : OPERATORS)
+                    if (rest.substr(0, candidate.first.size()) == candidate.first)
+                    {
+                        i += candidate.first.size();
+                        op = candidate.second;
+                        return true;
+                    }
+                return false;
+            }
+
+            static op_t mirror(op_t op)
+            {
+                switch (op)
+                {
+                case op_t::LT:
+                    return op_t::GT;
+                case op_t::LE:
+                    return op_t::GE;
+                case op_t::GT:
+                    return op_t::LT;
+                case op_t::GE:
+                    return op_t::LE;
+                default:
+                    return op;
+                }
+            }
+
+            int node(step_t &step, expr_kind_t kind, int left, int right = -1)
+            {
+                step.nodes.push_back({kind, left, right});
+                return static_cast<int>(step.nodes.size() - 1);
+            }
+
+            int atom(step_t &step, atom_t &&parsed)
+            {
+                if (parsed.kind == atom_kind_t::LAST)
+                    xpath.streamable = false;
+                step.atoms.push_back(std::move(parsed));
+                return node(step, expr_kind_t::ATOM, static_cast<int>(step.atoms.size() - 1));
+            }
+
+            /**
+             *  @brief  Parses a comparison, a function call or a path.
+             * */
+            bool primary(step_t &step, std::size_t predicate, int &parsed)
+            {
+                atom_t a{atom_kind_t::VALUE, predicate, op_t::EXISTS, literal_t(), relpath_t()};
+                std::size_t start = i;
+                std::string_view function;
+                skipSpaces();
+                if (name(function) && (function == "contains" || function == "starts-with") && expect('('))
+                {
+                    a.op = (function == "contains" ? op_t::CONTAINS : op_t::STARTS_WITH);
+                    if (!relpath(a.path) || !expect(',') || !literal(a.literal) || !expect(')'))
+                        return false;
+                    parsed = atom(step, std::move(a));
+                    return true;
+                }
+                i = start;
+
+                operand_t left, right;
+                if (!operand(left))
+                    return false;
+                op_t op;
+                if (!comparison(op))
+                {
+                    if (left.kind == operand_t::LAST)
+                        a.kind = atom_kind_t::LAST;
+                    else if (left.kind == operand_t::PATH)
+                        a.path = std::move(left.path);
+                    else
+                        return false;
+                    parsed = atom(step, std::move(a));
+                    return true;
+                }
+                if (!operand(right))
+                    return false;
+                if (left.kind == operand_t::LITERAL)
+                {
+                    std::swap(left, right);
+                    op = mirror(op);
+                }
+
+                if (left.kind == operand_t::POSITION && right.kind == operand_t::LAST && op == op_t::EQ)
+                    a.kind = atom_kind_t::LAST;
+                else if (right.kind != operand_t::LITERAL)
+                    return false;
+                else if (left.kind == operand_t::POSITION && right.literal.numeric)
+                    a.kind = atom_kind_t::POSITION;
+                else if (left.kind == operand_t::PATH)
+                    a.path = std::move(left.path);
+                else
+                    return false;
+                a.op = op;
+                a.literal = std::move(right.literal);
+                parsed = atom(step, std::move(a));
+                return true;
+            }
+
+            bool unary(step_t &step, std::size_t predicate, int &parsed)
+            {
+                skipSpaces();
+                std::size_t start = i;
+                if (keyword("not") && expect('('))
+                {
+                    int operand;
+                    if (!disjunction(step, predicate, operand) || !expect(')'))
+                        return false;
+                    parsed = node(step, expr_kind_t::NOT, operand);
+                    return true;
+                }
+                i = start;
+                if (expect('('))
+                    return disjunction(step, predicate, parsed) && expect(')');
+                return primary(step, predicate, parsed);
+            }
+
+            bool conjunction(step_t &step, std::size_t predicate, int &parsed)
+            {
+                if (!unary(step, predicate, parsed))
+                    return false;
+                while (keyword("and"))
+                {
+                    int right;
+                    if (!unary(step, predicate, right))
+                        return false;
+                    parsed = node(step, expr_kind_t::AND, parsed, right);
+                }
+                return true;
+            }
+
+            bool disjunction(step_t &step, std::size_t predicate, int &parsed)
+            {
+                if (!conjunction(step, predicate, parsed))
+                    return false;
+                while (keyword("or"))
+                {
+                    int right;
+                    if (!conjunction(step, predicate, right))
+                        return false;
+                    parsed = node(step, expr_kind_t::OR, parsed, right);
+                }
+                return true;
+            }
+
+            bool predicate(step_t &step)
+            {
+                ++i; // [
+                std::size_t p = step.predicates.size();
+                int root;
+
+                // a number alone is a position
+                std::size_t start = i;
+                literal_t number;
+                if (literal(number) && number.numeric && peek(']'))
+                {
+                    atom_t a{atom_kind_t::POSITION, p, op_t::EQ, std::move(number), relpath_t()};
+                    root = atom(step, std::move(a));
+                }
+                else
+                {
+                    i = start;
+                    if (!disjunction(step, p, root))
+                        return false;
+                }
+                if (!expect(']'))
+                    return false;
+                step.predicates.push_back(root);
+                return true;
+            }
+
+            bool step(step_t &parsed)
+            {
+                skipSpaces();
+                if (i < text.size() && text[i] == '@')
+                {
+                    ++i;
+                    parsed.kind = terminal_t::ATTRIBUTE;
+                    return nameTest(parsed.name);
+                }
+                if (call("text"))
+                {
+                    parsed.kind = terminal_t::TEXT;
+                    return true;
+                }
+                if (!nameTest(parsed.name))
+                    return false;
+                while (peek('['))
+                    if (!predicate(parsed))
+                        return false;
+                return true;
+            }
+
+        public:
+            parser_t(std::string_view text, DOMxpath &xpath) : text(text), xpath(xpath) {}
+
+            /**
+             *  @brief  Parses the whole text into the steps of the expression.
+             * */
+            bool parse()
+            {
+                bool descendant = false;
+                if (peek('/'))
+                {
+                    ++i;
+                    xpath.absolute = true;
+                    if (i < text.size() && text[i] == '/')
+                    {
+                        ++i;
+                        descendant = true;
+                    }
+                }
+                while (true)
+                {
+                    xpath.steps.emplace_back();
+                    step_t &parsed = xpath.steps.back();
+                    parsed.descendant = descendant;
+                    if (!step(parsed))
+                        return false;
+                    parsed.counters = xpath.counterCount;
+                    xpath.counterCount += parsed.predicates.size();
+
+                    skipSpaces();
+                    if (i >= text.size())
+                        return true;
+                    // attributes and text nodes have no children
+                    if (text[i] != '/' || parsed.kind != terminal_t::ELEMENT)
+                        return false;
+                    ++i;
+                    descendant = (i < text.size() && text[i] == '/');
+                    i += descendant;
+                }
+            }
+        };
+
+        /**
+         *  @brief  Converts the string to a number as XPath does: a decimal
+         *          number surrounded by white space, NaN otherwise.
+         * */
+        static double toNumber(std::string_view value)
+        {
+            while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front())))
+                value.remove_prefix(1);
+            while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back())))
+                value.remove_suffix(1);
+            bool digits = false;
+            for (std::size_t c = 0; c < value.size(); ++c)
+            {
+                if (std::isdigit(static_cast<unsigned char>(value[c])))
+                    digits = true;
+                else if (value[c] != '.' && !(c == 0 && value[c] == '-'))
+                    return std::numeric_limits<double>::quiet_NaN();
+            }
+            double number;
+            if (!digits || std::count(value.begin(), value.end(), '.') > 1 ||
+                std::from_chars(value.data(), value.data() + value.size(), number).ec != std::errc())
+                return std::numeric_limits<double>::quiet_NaN();
+            return number;
+        }
+
+        static bool compareNumbers(double value, op_t op, double expected)
+        {
+            switch (op)
+            {
+            case op_t::EQ:
+                return value == expected;
+            case op_t::NE:
+                return value != expected;
+            case op_t::LT:
+                return value < expected;
+            case op_t::LE:
+                return value <= expected;
+            case op_t::GT:
+                return value > expected;
+            case op_t::GE:
+                return value >= expected;
+            default:
+                return false;
+            }
+        }
+
+        /**
+         *  @brief  Compares a value selected by the path of the atom with
+         *          the literal of the atom.
+         * */
+        static bool compare(std::string_view value, const atom_t &atom)
+        {
+            std::string_view expected = atom.literal.text;
+            switch (atom.op)
+            {
+            case op_t::EXISTS:
+                return true;
+            case op_t::CONTAINS:
+                return value.find(expected) != std::string_view::npos;
+            case op_t::STARTS_WITH:
+                return value.substr(0, expected.size()) == expected;
+            case op_t::EQ:
+            case op_t::NE:
+                if (!atom.literal.numeric)
+                    return (value == expected) == (atom.op == op_t::EQ);
+                return compareNumbers(toNumber(value), atom.op, atom.literal.number);
+            default:
+                return compareNumbers(toNumber(value), atom.op, atom.literal.number);
+            }
+        }
+
+        /**
+         *  @brief  Evaluates the expression of a predicate in three-valued
+         *          logic over the truth of its atoms.
+         * */
+        static truth_t evaluate(const step_t &step, int node, const truth_t *atoms)
+        {
+            const expr_t &e = step.nodes[node];
+            truth_t left, right;
+            switch (e.kind)
+            {
+            case expr_kind_t::ATOM:
+                return atoms[e.left];
+            case expr_kind_t::NOT:
+                left = evaluate(step, e.left, atoms);
+                return (left == MAYBE ? MAYBE : (left == YES ? NO : YES));
+            case expr_kind_t::AND:
+                left = evaluate(step, e.left, atoms);
+                if (left == NO)
+                    return NO;
+                right = evaluate(step, e.right, atoms);
+                if (right == NO)
+                    return NO;
+                return (left == YES && right == YES ? YES : MAYBE);
+            default:
+                left = evaluate(step, e.left, atoms);
+                if (left == YES)
+                    return YES;
+                right = evaluate(step, e.right, atoms);
+                if (right == YES)
+                    return YES;
+                return (left == NO && right == NO ? NO : MAYBE);
+            }
+        }
+
+        /**
+         *  @brief  Returns the truth of all the predicates of the step.
+         * */
+        static truth_t evaluate(const step_t &step, const truth_t *atoms)
+        {
+            truth_t all = YES;
+            for (int root : step.predicates)
+            {
+                truth_t t = evaluate(step, root, atoms);
+                if (t == NO)
+                    return NO;
+                if (t == MAYBE)
+                    all = MAYBE;
+            }
+            return all;
+        }
+
+        // ---- evaluation on a tree ----
+
+        typedef std::vector<DOMsymbol> bound_t;
+
+        /**
+         *  @brief  Looks the names of the expression up in the symbol table
+         *          of the tree.
+         * */
+        bound_t bind(const DOMtree &tree) const
+        {
+            bound_t bound(names.size());
+            for (std::size_t n = 0; n < names.size(); ++n)
+                bound[n] = tree.getSymbols().find(names[n]);
+            return bound;
+        }
+
+        static inline bool matchName(const bound_t &bound, int name, const DOMnode &node)
+        {
+            return !node.isInnerDataNode() &&
+                   (name == ANY || (bound[name] != DOMsymbolTable::NO_SYMBOL && node.getTagSymbol() == bound[name]));
+        }
+
+        /**
+         *  @brief  Returns the string value of the node, the text of the
+         *          inner data nodes in its subtree.
+         * */
+        static std::string stringValue(const DOMtree &tree, const DOMnode &root)
+        {
+            if (root.isInnerDataNode())
+                return std::string(root.getInnerData());
+            std::string value;
+            const DOMnode *node = &root;
+            while (true)
+            {
+                if (node->isInnerDataNode())
+                    value += node->getInnerData();
+                if (node->getFirstChild() != -1)
+                {
+                    node = &tree.getNode(node->getFirstChild());
+                    continue;
+                }
+                while (node != &root && node->getNextSibling() == -1)
+                    node = &tree.getNode(node->getParent());
+                if (node == &root)
+                    return value;
+                node = &tree.getNode(node->getNextSibling());
+            }
+        }
+
+        /**
+         *  @brief  Calls f with the values the path selects from the node,
+         *          until f returns true.
+         *  @return true if f did
+         * */
+        template <class F>
+        static bool anyValue(const DOMtree &tree, const bound_t &bound, const DOMnode &node, const relpath_t &path,
+                             std::size_t position, F &&f)
+        {
+            if (position < path.names.size())
+            {
+                for (DOMnodeUID child : node.getChildrenUID())
+                {
+                    const DOMnode &next = tree.getNode(child);
+                    if (matchName(bound, path.names[position], next) &&
+                        anyValue(tree, bound, next, path, position + 1, f))
+                        return true;
+                }
+                return false;
+            }
+            switch (path.terminal)
+            {
+            case terminal_t::ATTRIBUTE:
+                if (path.attribute == ANY)
+                {
+                    for (const auto &attribute : node.getAllAttributes())
+                        if (f(attribute.second))
+                            return true;
+                    return false;
+                }
+                else
+                {
+                    DOMsymbol name = bound[path.attribute];
+                    const std::string_view *value =
+                        (name == DOMsymbolTable::NO_SYMBOL ? nullptr : node.findAttribute(name));
+                    return value && f(*value);
+                }
+            case terminal_t::TEXT:
+                for (DOMnodeUID child : node.getChildrenUID())
+                {
+                    const DOMnode &next = tree.getNode(child);
+                    if (next.isInnerDataNode() && f(next.getInnerData()))
+                        return true;
+                }
+                return false;
+            default:
+                return f(stringValue(tree, node));
+            }
+        }
+
+        truth_t atomOnTree(const DOMtree &tree, const bound_t &bound, const DOMnode &node, const atom_t &atom,
+                           std::size_t position, std::size_t last) const
+        {
+            switch (atom.kind)
+            {
+            case atom_kind_t::POSITION:
+                return compareNumbers(static_cast<double>(position), atom.op, atom.literal.number) ? YES : NO;
+            case atom_kind_t::LAST:
+                return position == last ? YES : NO;
+            default:
+                return anyValue(tree, bound, node, atom.path, 0, [&atom](std::string_view value)
+                                { return compare(value, atom); })
+                           ? YES
+                           : NO;
+            }
+        }
+
+        /**
+         *  @brief  Appends the children of the parent selected by the step,
+         *          in order. The predicates filter the children one after
+         *          the other, positions are counted among the children left
+         *          by the previous predicates.
+         * */
+        void selectChildren(const DOMtree &tree, const bound_t &bound, DOMnodeUID parent, const step_t &step,
+                            std::vector<DOMnodeUID> &selected) const
+        {
+            std::vector<DOMnodeUID> children;
+            if (parent == DOCUMENT)
+            {
+                if (step.kind == terminal_t::ELEMENT && matchName(bound, step.name, tree.getNode(0)))
+                    children.push_back(0);
+            }
+            else
+            {
+                for (DOMnodeUID child : tree.getNode(parent).getChildrenUID())
+                {
+                    const DOMnode &node = tree.getNode(child);
+                    if (step.kind == terminal_t::TEXT ? node.isInnerDataNode() : matchName(bound, step.name, node))
+                        children.push_back(child);
+                }
+            }
+
+            std::vector<truth_t> atoms(step.atoms.size(), NO);
+            for (std::size_t p = 0; p < step.predicates.size() && !children.empty(); ++p)
+            {
+                std::vector<DOMnodeUID> kept;
+                for (std::size_t c = 0; c < children.size(); ++c)
+                {
+                    const DOMnode &node = tree.getNode(children[c]);
+                    for (std::size_t a = 0; a < step.atoms.size(); ++a)
+                        if (step.atoms[a].predicate == p)
+                            atoms[a] = atomOnTree(tree, bound, node, step.atoms[a], c + 1, children.size());
+                    if (evaluate(step, step.predicates[p], atoms.data()) == YES)
+                        kept.push_back(children[c]);
+                }
+                children.swap(kept);
+            }
+            selected.insert(selected.end(), children.begin(), children.end());
+        }
+
+        struct walk_frame_t
+        {
+            std::vector<DOMnodeUID> selected; // children selected by the step
+            std::size_t next;                 // next of them to be met
+            DOMnodeUID child;                 // next child to be visited
+        };
+
+        /**
+         *  @brief  Applies a step to contexts in document order, which may
+         *          contain one another, by walking their subtrees in pre-order.
+         *          The result is in document order and has no duplicates.
+         * */
+        void walkStep(const DOMtree &tree, const bound_t &bound, const std::vector<DOMnodeUID> &contexts,
+                      const step_t &step, std::vector<DOMnodeUID> &result) const
+        {
+            // contexts not yet met by the walk of an earlier one
+            std::unordered_set<DOMnodeUID> pending(contexts.begin(), contexts.end());
+            std::vector<walk_frame_t> stack;
+            for (DOMnodeUID context : contexts)
+            {
+                if (!pending.erase(context))
+                    continue;
+                stack.push_back({{}, 0, (context == DOCUMENT ? 0 : tree.getNode(context).getFirstChild())});
+                selectChildren(tree, bound, context, step, stack.back().selected);
+                while (!stack.empty())
+                {
+                    walk_frame_t &top = stack.back();
+                    if (top.child == -1)
+                    {
+                        stack.pop_back();
+                        continue;
+                    }
+                    DOMnodeUID uid = top.child;
+                    const DOMnode &node = tree.getNode(uid);
+                    top.child = node.getNextSibling();
+                    if (top.next < top.selected.size() && top.selected[top.next] == uid)
+                    {
+                        result.push_back(uid);
+                        ++top.next;
+                    }
+                    // the children of every node in the subtree are selected
+                    // by a descendant step, only those of contexts otherwise
+                    bool context = (pending.erase(uid) != 0);
+                    if (node.getFirstChild() == -1 || (!step.descendant && pending.empty() && !context))
+                        continue;
+                    stack.push_back({{}, 0, node.getFirstChild()});
+                    if (step.descendant || context)
+                        selectChildren(tree, bound, uid, step, stack.back().selected);
+                }
+            }
+        }
+
+        /**
+         *  @brief  Returns the nodes selected by the element and text steps,
+         *          and for an attribute step, the elements it applies to.
+         * */
+        std::vector<DOMnodeUID> run(const DOMtree &tree, const bound_t &bound, DOMnodeUID context) const
+        {
+            std::vector<DOMnodeUID> contexts{absolute ? DOCUMENT : context};
+            bool nested = false; // contexts may contain one another
+            for (const step_t &step : steps)
+            {
+                std::vector<DOMnodeUID> next;
+                if (step.kind == terminal_t::ATTRIBUTE)
+                {
+                    if (!step.descendant)
+                    {
+                        if (contexts.front() == DOCUMENT)
+                            contexts.clear();
+                        return contexts;
+                    }
+                    // attributes of the contexts and of their descendants
+                    std::unordered_set<DOMnodeUID> met;
+                    for (DOMnodeUID c : contexts)
+                    {
+                        if (met.count(c))
+                            continue;
+                        const DOMnode &root = tree.getNode(c == DOCUMENT ? 0 : c);
+                        const DOMnode *node = &root;
+                        while (true)
+                        {
+                            if (!node->isInnerDataNode() && met.insert(node->getUID()).second)
+                                next.push_back(node->getUID());
+                            if (node->getFirstChild() != -1)
+                            {
+                                node = &tree.getNode(node->getFirstChild());
+                                continue;
+                            }
+                            while (node != &root && node->getNextSibling() == -1)
+                                node = &tree.getNode(node->getParent());
+                            if (node == &root)
+                                break;
+                            node = &tree.getNode(node->getNextSibling());
+                        }
+                    }
+                    return next;
+                }
+                if (step.descendant || nested)
+                    walkStep(tree, bound, contexts, step, next);
+                else
+                    for (DOMnodeUID c : contexts)
+                        selectChildren(tree, bound, c, step, next);
+                contexts.swap(next);
+                nested = nested || step.descendant;
+                if (contexts.empty())
+                    break;
+            }
+            return contexts;
+        }
+
+        /**
+         *  @brief  Calls f with the name and value of the attributes of the
+         *          node selected by the last step.
+         * */
+        template <class F>
+        void forAttributes(const DOMtree &/*tree*/, const bound_t &bound, const DOMnode &node, F &&f) const
+        {
+            int name = steps.back().name;
+            if (name == ANY)
+            {
+                for (const auto &attribute : node.getAllAttributes())
+                    f(attribute.second);
+                return;
+            }
+            const std::string_view *value =
+                (bound[name] == DOMsymbolTable::NO_SYMBOL ? nullptr : node.findAttribute(bound[name]));
+            if (value)
+                f(*value);
+        }
+
+        // ---- streaming evaluation ----
+
+        class stream_t
+        {
+        private:
+            // match of an element by a step, with the matches of the
+            // previous step it may be reached from
+            struct instance_t
+            {
+                std::size_t step;
+                std::vector<truth_t> atoms;
+                std::vector<std::shared_ptr<instance_t>> supports;
+                truth_t own = MAYBE;      // the predicates
+                truth_t validity = MAYBE; // the predicates and some support
+            };
+            typedef std::shared_ptr<instance_t> instance_ptr;
+
+            // path of an atom, followed down the elements
+            struct watch_t
+            {
+                instance_ptr instance;
+                std::size_t atom;
+                std::size_t position;
+            };
+
+            // string value of an element, for an atom or an output
+            struct capture_t
+            {
+                instance_ptr instance; // nullptr for an output
+                std::size_t atom;      // or the output slot
+                std::size_t start;
+            };
+
+            struct frame_t
+            {
+                std::vector<std::vector<instance_ptr>> contexts; // per step, for the children of the element
+                std::vector<instance_ptr> instances;
+                std::vector<watch_t> watchers;
+                std::vector<watch_t> textWatchers;
+                std::vector<capture_t> captures;
+                std::vector<std::uint32_t> counters; // positions of the children, per step and predicate
+            };
+
+            struct output_t
+            {
+                DOMxpathMatch match;
+                instance_ptr instance;
+                bool ready;
+            };
+
+            const DOMxpath &xpath;
+            const std::function<void(const DOMxpathMatch &)> &callback;
+
+            // frames of the document and of the open elements, kept for reuse
+            std::vector<frame_t> frames;
+            std::size_t depth = 0;
+
+            // text of the elements whose string values are captured
+            std::string buffer;
+            std::size_t capturing = 0;
+
+            // outputs in document order, reported once they are known
+            std::deque<output_t> outputs;
+            std::size_t reported = 0;
+
+            instance_ptr document;
+
+            inline bool matchName(int name, const std::string &tag) const
+            {
+                return name == ANY || xpath.names[name] == tag;
+            }
+
+            static truth_t valid(instance_t &instance)
+            {
+                if (instance.validity != MAYBE)
+                    return instance.validity;
+                if (instance.own == NO)
+                    return instance.validity = NO;
+                truth_t support = NO;
+                for (const instance_ptr &s : instance.supports)
+                {
+                    truth_t t = valid(*s);
+                    if (t == YES)
+                    {
+                        support = YES;
+                        break;
+                    }
+                    if (t == MAYBE)
+                        support = MAYBE;
+                }
+                if (support == NO)
+                    return instance.validity = NO;
+                if (support == YES && instance.own == YES)
+                {
+                    instance.supports.clear(); // not needed any more
+                    return instance.validity = YES;
+                }
+                return MAYBE;
+            }
+
+            /**
+             *  @brief  Returns a match with the contexts as supports, keeping
+             *          only one if it is known to be valid.
+             *  @return nullptr if none of the contexts are valid
+             * */
+            instance_ptr support(std::size_t step, const std::vector<instance_ptr> &contexts)
+            {
+                instance_ptr instance = std::make_shared<instance_t>();
+                instance->step = step;
+                for (const instance_ptr &c : contexts)
+                {
+                    truth_t t = valid(*c);
+                    if (t == YES)
+                    {
+                        instance->supports.assign(1, c);
+                        break;
+                    }
+                    if (t == MAYBE)
+                        instance->supports.push_back(c);
+                }
+                if (instance->supports.empty())
+                    return nullptr;
+                return instance;
+            }
+
+            inline output_t &slot(std::size_t id)
+            {
+                return outputs[id - reported];
+            }
+
+            std::size_t reserve(DOMxpathMatch::kind_t kind, std::string_view name, std::string_view value,
+                                const instance_ptr &instance, bool ready)
+            {
+                outputs.push_back({{kind, std::string(name), std::string(value), {}, depth - 1}, instance, ready});
+                return reported + outputs.size() - 1;
+            }
+
+            /**
+             *  @brief  Reports the outputs at the front which are known.
+             * */
+            void flush()
+            {
+                while (!outputs.empty() && outputs.front().ready)
+                {
+                    truth_t t = valid(*outputs.front().instance);
+                    if (t == MAYBE)
+                        return;
+                    if (t == YES)
+                        callback(outputs.front().match);
+                    outputs.pop_front();
+                    ++reported;
+                }
+            }
+
+            /**
+             *  @brief  Follows the path of an atom to the element of the frame.
+             * */
+            void arrive(frame_t &frame, const instance_ptr &instance, std::size_t a, std::size_t position,
+                        const std::map<std::string, std::string> &attributes)
+            {
+                const atom_t &atom = xpath.steps[instance->step].atoms[a];
+                const relpath_t &path = atom.path;
+                if (position < path.names.size())
+                {
+                    frame.watchers.push_back({instance, a, position});
+                    return;
+                }
+                switch (path.terminal)
+                {
+                case terminal_t::ATTRIBUTE:
+                    for (const auto &attribute : attributes)
+                        if ((path.attribute == ANY || xpath.names[path.attribute] == attribute.first) &&
+                            compare(attribute.second, atom))
+                        {
+                            instance->atoms[a] = YES;
+                            return;
+                        }
+                    return;
+                case terminal_t::TEXT:
+                    frame.textWatchers.push_back({instance, a, position});
+                    return;
+                default:
+                    frame.captures.push_back({instance, a, buffer.size()});
+                    ++capturing;
+                }
+            }
+
+            void open(std::string &&name, std::map<std::string, std::string> &&attributes)
+            {
+                if (++depth == frames.size())
+                    frames.emplace_back();
+                frame_t &parent = frames[depth - 1];
+                frame_t &frame = frames[depth];
+                const std::vector<step_t> &steps = xpath.steps;
+                std::size_t last = steps.size() - 1;
+
+                frame.contexts.resize(steps.size());
+                for (auto &contexts : frame.contexts)
+                    contexts.clear();
+                frame.instances.clear();
+                frame.watchers.clear();
+                frame.textWatchers.clear();
+                frame.captures.clear();
+                frame.counters.assign(xpath.counterCount, 0);
+
+                // paths of the predicates of the ancestors
+                for (const watch_t &w : parent.watchers)
+                    if (w.instance->atoms[w.atom] == MAYBE &&
+                        matchName(steps[w.instance->step].atoms[w.atom].path.names[w.position], name))
+                        arrive(frame, w.instance, w.atom, w.position + 1, attributes);
+
+                std::size_t output = SIZE_MAX;
+                for (std::size_t k = 0; k < steps.size(); ++k)
+                {
+                    const step_t &step = steps[k];
+                    if (step.kind != terminal_t::ELEMENT || parent.contexts[k].empty() || !matchName(step.name, name))
+                        continue;
+                    instance_ptr instance = support(k, parent.contexts[k]);
+                    if (!instance)
+                        continue;
+                    instance->atoms.assign(step.atoms.size(), MAYBE);
+
+                    // positions and attributes are known now, the
+                    // predicates after the first one which fails on them
+                    // need not be followed
+                    for (std::size_t a = 0; a < step.atoms.size(); ++a)
+                    {
+                        const atom_t &atom = step.atoms[a];
+                        if (atom.kind == atom_kind_t::POSITION)
+                            instance->atoms[a] = compareNumbers(parent.counters[step.counters + atom.predicate] + 1.0,
+                                                                atom.op, atom.literal.number)
+                                                     ? YES
+                                                     : NO;
+                        else if (atom.path.names.empty() && atom.path.terminal == terminal_t::ATTRIBUTE)
+                        {
+                            arrive(frame, instance, a, 0, attributes);
+                            if (instance->atoms[a] == MAYBE)
+                                instance->atoms[a] = NO;
+                        }
+                    }
+                    std::size_t failed = 0;
+                    while (failed < step.predicates.size() &&
+                           evaluate(step, step.predicates[failed], instance->atoms.data()) != NO)
+                        ++failed;
+                    for (std::size_t a = 0; a < step.atoms.size(); ++a)
+                        if (instance->atoms[a] == MAYBE && step.atoms[a].predicate < failed)
+                            arrive(frame, instance, a, 0, attributes);
+                    instance->own = evaluate(step, instance->atoms.data());
+                    frame.instances.push_back(instance);
+                    if (instance->own == NO)
+                        continue;
+
+                    if (k == last)
+                    {
+                        output = reserve(DOMxpathMatch::kind_t::ELEMENT, name, std::string_view(), instance, false);
+                        frame.captures.push_back({nullptr, output, buffer.size()});
+                        ++capturing;
+                    }
+                    else
+                        frame.contexts[k + 1].push_back(instance);
+                }
+                for (std::size_t k = 0; k < steps.size(); ++k)
+                    if (steps[k].descendant)
+                        frame.contexts[k].insert(frame.contexts[k].end(), parent.contexts[k].begin(),
+                                                 parent.contexts[k].end());
+                if (depth == 1 && !xpath.absolute)
+                    frame.contexts[0].push_back(document); // relative paths start at the root
+
+                if (steps[last].kind == terminal_t::ATTRIBUTE && !frame.contexts[last].empty())
+                {
+                    instance_ptr instance = support(last, frame.contexts[last]);
+                    if (instance)
+                    {
+                        instance->own = YES;
+                        for (const auto &attribute : attributes)
+                            if (matchName(steps[last].name, attribute.first))
+                                reserve(DOMxpathMatch::kind_t::ATTRIBUTE, attribute.first, attribute.second, instance,
+                                        true);
+                    }
+                }
+                if (output != SIZE_MAX)
+                    slot(output).match.attributes = std::move(attributes);
+                flush();
+            }
+
+            void text(std::string &&data)
+            {
+                frame_t &frame = frames[depth];
+                std::size_t last = xpath.steps.size() - 1;
+                if (capturing)
+                    buffer += data;
+                for (const watch_t &w : frame.textWatchers)
+                    if (w.instance->atoms[w.atom] == MAYBE &&
+                        compare(data, xpath.steps[w.instance->step].atoms[w.atom]))
+                        w.instance->atoms[w.atom] = YES;
+
+                if (xpath.steps[last].kind == terminal_t::TEXT && !frame.contexts[last].empty())
+                {
+                    instance_ptr instance = support(last, frame.contexts[last]);
+                    if (instance)
+                    {
+                        instance->own = YES;
+                        reserve(DOMxpathMatch::kind_t::TEXT, std::string_view(), data, instance, true);
+                        flush();
+                    }
+                }
+            }
+
+            void close()
+            {
+                frame_t &frame = frames[depth];
+                frame_t &parent = frames[depth - 1];
+                for (const capture_t &c : frame.captures)
+                {
+                    std::string_view value = std::string_view(buffer).substr(c.start);
+                    if (!c.instance)
+                    {
+                        slot(c.atom).match.value = std::string(value);
+                        slot(c.atom).ready = true;
+                    }
+                    else if (c.instance->atoms[c.atom] == MAYBE &&
+                             compare(value, xpath.steps[c.instance->step].atoms[c.atom]))
+                        c.instance->atoms[c.atom] = YES;
+                }
+                capturing -= frame.captures.size();
+                if (!capturing)
+                    buffer.clear();
+
+                for (const instance_ptr &instance : frame.instances)
+                {
+                    const step_t &step = xpath.steps[instance->step];
+                    // paths which met no value do not hold
+                    for (truth_t &t : instance->atoms)
+                        if (t == MAYBE)
+                            t = NO;
+                    instance->own = evaluate(step, instance->atoms.data());
+                    // a sibling counts for the positions of a predicate
+                    // when it passes the predicates before it
+                    for (std::size_t p = 0; p < step.predicates.size(); ++p)
+                    {
+                        ++parent.counters[step.counters + p];
+                        if (evaluate(step, step.predicates[p], instance->atoms.data()) != YES)
+                            break;
+                    }
+                }
+                frame.instances.clear();
+                frame.watchers.clear();
+                frame.textWatchers.clear();
+                frame.captures.clear();
+                for (auto &contexts : frame.contexts)
+                    contexts.clear();
+                --depth;
+                flush();
+            }
+
+        public:
+            stream_t(const DOMxpath &xpath, const std::function<void(const DOMxpathMatch &)> &callback)
+                : xpath(xpath), callback(callback), frames(1), document(std::make_shared<instance_t>())
+            {
+                document->own = document->validity = YES;
+                frames[0].contexts.resize(xpath.steps.size());
+                frames[0].counters.assign(xpath.counterCount, 0);
+                if (xpath.absolute)
+                    frames[0].contexts[0].push_back(document);
+            }
+
+            /**
+             *  @brief  Reads the file, tag by tag as DOMparser does.
+             *  @return -2  error
+             *          0   if read successfully
+             * */
+            int read(const std::filesystem::path &path)
+            {
+                lexer _lexer(path);
+                auto _T = _lexer.next();
+                if (_T->token != lexer_token_values::T_OPENTAG)
+                    return -2; // root node required, error
+
+                std::string name;
+                std::map<std::string, std::string> attributes;
+                bool ended = false; // the root was closed
+                while (_T->token != lexer_token_values::T_FILEEND)
+                {
+                    if (_T->token == lexer_token_values::T_OPENTAG) // read tag
+                    {
+                        name.clear();
+                        attributes.clear();
+                        switch (_lexer.scan_tag(name, attributes))
+                        {
+                        case 0: // fail
+                            return -2;
+                        case -1: // closing tag
+                            if (depth == 0)
+                                return -2;
+                            close();
+                            ended = (depth == 0);
+                            break;
+                        case 1: // opening tag
+                            if (ended)
+                                return -2;
+                            open(std::move(name), std::move(attributes));
+                            break;
+                        case -2: // self closing tag
+                            if (ended)
+                                return -2;
+                            open(std::move(name), std::move(attributes));
+                            close();
+                            ended = (depth == 0);
+                            break;
+                        }
+                        _T = _lexer.next();
+                    }
+                    else // read innerData
+                    {
+                        std::string innerData;
+                        while (_T->token != lexer_token_values::T_OPENTAG &&
+                               _T->token != lexer_token_values::T_FILEEND)
+                        {
+                            innerData += _T->value;
+                            innerData += ' ';
+                            _T = _lexer.next();
+                        }
+                        innerData.pop_back(); // trim the last space
+                        if (ended)
+                            return -2;
+                        text(std::move(innerData));
+                    }
+                }
+                // elements left open, such as a <?xml ... ?> prolog, are
+                // closed by the end of the file, the parser keeps them too
+                while (depth > 0)
+                    close();
+                return 0;
+            }
+        };
+
+        DOMxpath() = default;
+
+    public:
+        /**
+         *  @brief  Compiles the expression.
+         *  @return the compiled expression, nullptr if the text is invalid
+         *          or outside of the supported subset
+         * */
+        static std::shared_ptr<const DOMxpath> compile(std::string_view text)
+        {
+            std::shared_ptr<DOMxpath> xpath(new DOMxpath());
+            parser_t parser(text, *xpath);
+            if (!parser.parse())
+                return nullptr;
+            return xpath;
+        }
+
+        /**
+         *  @brief  Checks if the expression can be streamed, which it can
+         *          unless it uses last().
+         * */
+        inline bool isStreamable() const
+        {
+            return streamable;
+        }
+
+        /**
+         *  @brief  Returns the nodes selected by the expression, in document
+         *          order: elements, inner data nodes for text(), and the
+         *          elements having the attribute for a last attribute step.
+         *  @param  tree        the tree
+         *  @param  context     context node of relative paths, absolute paths
+         *                      start at the parent of the root
+         * */
+        std::vector<DOMnodeUID> select(const DOMtree &tree, DOMnodeUID context = 0) const
+        {
+            std::vector<DOMnodeUID> selected;
+            if (!tree.isValid(context))
+                return selected;
+            bound_t bound = bind(tree);
+            selected = run(tree, bound, context);
+            if (steps.back().kind != terminal_t::ATTRIBUTE)
+                return selected;
+
+            std::vector<DOMnodeUID> owners;
+            for (DOMnodeUID uid : selected)
+            {
+                bool found = false;
+                forAttributes(tree, bound, tree.getNode(uid), [&found](std::string_view) { found = true; });
+                if (found)
+                    owners.push_back(uid);
+            }
+            return owners;
+        }
+
+        /**
+         *  @brief  Returns the string values of what the expression selects,
+         *          in document order: the text of the elements and of the
+         *          text nodes, and the values of the attributes.
+         *  @param  tree        the tree
+         *  @param  context     context node of relative paths
+         * */
+        std::vector<std::string> values(const DOMtree &tree, DOMnodeUID context = 0) const
+        {
+            std::vector<std::string> found;
+            if (!tree.isValid(context))
+                return found;
+            bound_t bound = bind(tree);
+            std::vector<DOMnodeUID> selected = run(tree, bound, context);
+            for (DOMnodeUID uid : selected)
+            {
+                if (steps.back().kind == terminal_t::ATTRIBUTE)
+                    forAttributes(tree, bound, tree.getNode(uid), [&found](std::string_view value)
+                                  { found.emplace_back(value); });
+                else
+                    found.push_back(stringValue(tree, tree.getNode(uid)));
+            }
+            return found;
+        }
+
+        /**
+         *  @brief  Evaluates the expression over a file without building its
+         *          tree, reading it with the lexer as DOMparser does.
+         *
+         *          Matches are reported in document order, as soon as the
+         *          predicates of the elements on their path are known, which
+         *          is at the latest when those elements close. The memory used
+         *          is bounded by the depth of the document and by the outputs
+         *          held inside an element whose predicates are not yet known,
+         *          so files much bigger than the memory can be filtered.
+         *          Relative paths start at the root.
+         *  @param  path        path of the file
+         *  @param  callback    called with every match, the match is valid
+         *                      during the call only
+         *  @return -2  if the file can not be read or is malformed; the
+         *              matches before the error have been reported
+         *          -1  if the expression can not be streamed
+         *          0   if read successfully
+         * */
+        int stream(const std::filesystem::path &path,
+                   const std::function<void(const DOMxpathMatch &)> &callback) const
+        {
+            if (!streamable)
+                return -1;
+            stream_t reader(*this, callback);
+            return reader.read(path);
+        }
+    };
+
+} // namespace dom_parser
+
+#endif
@@ -89,7 +89,7 @@ public:
         // print the output
         debug_print("Writing output...");
         fout.open(output_file);
-        fout << parser.getOutput();
+        parser.writeOutput(fout);
         fout.close();
         debug_print("Output is present in: " + output_file);
 
@@ -22,12 +22,23 @@ THE CODE HERE IS NOT DOCUMENTED.
 #include "DOMnode.hpp"
 #include "taskflow/taskflow.hpp"
 #include <CLI11/CLI11.hpp>
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <thread>
 #include <vector>
 #include "DOMtree.hpp"
+#include "DOMcolumns.hpp"
+#include "DOMcompressed.hpp"
+#include "DOMdiff.hpp"
+#include "DOMparallel.hpp"
+#include "DOMtreePass.hpp"
+#include "DOMselector.hpp"
+#include "DOMsnapshot.hpp"
+#include "DOMxpath.hpp"
+#include "DOMwriter.hpp"
 #include "benchmark/benchmark.h"
 
 using namespace std;
@@ -96,10 +107,10 @@ int dom_creation(int threads) {
   std::vector<tf::Task> tasks;
   tf::Taskflow taskflow;
 
-  dom_parser::DOMtree domtree = parser.getTree();
+  dom_parser::DOMtree domtree = parser.takeTree();
   dom_parser::DOMnodeUID uid = 0;
 
-  dom_parser::DOMnode node = domtree.getNode(uid);
+  dom_parser::DOMnode &node = domtree.getNode(uid);
 
   tf::Task root =
       taskflow
@@ -143,4 +154,675 @@ static void DomCreation(benchmark::State &state) {
 // Register the function as a benchmark
 BENCHMARK(DomCreation)->Name("")->DenseRange(1, 10, 1);
 
+// Moves every child of a wide parent (like the <table> of part.xml) under
+// another parent, one subtree at a time.
+static void BulkSubtreeMoves(benchmark::State &state) {
+  const int children = state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto tree = std::make_unique<dom_parser::DOMtree>("root");
+    dom_parser::DOMnodeUID from = tree->addNode(0, "table");
+    dom_parser::DOMnodeUID to = tree->addNode(0, "table");
+    std::vector<dom_parser::DOMnodeUID> rows;
+    rows.reserve(children);
+    for (int i = 0; i < children; i++)
+      rows.push_back(tree->addNode(from, "T"));
+    state.ResumeTiming();
+
+    // start from the middle so that removal is not at either end
+    for (int i = children / 2; i < children; i++)
+      tree->moveSubtree(rows[i], to);
+    for (int i = 0; i < children / 2; i++)
+      tree->moveSubtree(rows[i], to);
+    benchmark::DoNotOptimize(tree->getNode(to).getChildCount());
+
+    state.PauseTiming();
+    tree.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * children);
+}
+BENCHMARK(BulkSubtreeMoves)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// Deletes a wide two-level subtree, then refills the freed slots.
+static void BulkSubtreeDelete(benchmark::State &state) {
+  const int children = state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto tree = std::make_unique<dom_parser::DOMtree>("root");
+    dom_parser::DOMnodeUID table = tree->addNode(0, "table");
+    for (int i = 0; i < children; i++)
+      tree->addInnerDataNode(tree->addNode(table, "T"), "cell");
+    state.ResumeTiming();
+
+    tree->deleteSubtree(table);
+    benchmark::DoNotOptimize(tree->getNode(0).getChildCount());
+
+    state.PauseTiming();
+    tree.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * children * 2);
+}
+BENCHMARK(BulkSubtreeDelete)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// Rewrites a table with interval labels enabled: every row is marked and
+// moved under the other table, back and forth, directly (0) or through a
+// batch kept across the rewrites (1), without or with subtree hashes kept.
+static void BatchedRewrite(benchmark::State &state) {
+  const int rows = 20000;
+  dom_parser::DOMtree tree("root");
+  tree.enableIntervalLabels();
+  if (state.range(1))
+    tree.enableHashes();
+  dom_parser::DOMnodeUID tables[2] = {tree.addNode(0, "table"), tree.addNode(0, "table")};
+  std::vector<dom_parser::DOMnodeUID> uids;
+  for (int i = 0; i < rows; i++) {
+    uids.push_back(tree.addNode(tables[0], "tr"));
+    for (int j = 0; j < 4; j++)
+      tree.addInnerDataNode(tree.addNode(uids.back(), "td"), "cell");
+  }
+  tree.isAncestor(0, tables[0]); // labels are up to date from here on
+
+  auto batch = tree.batch();
+  int to = 1;
+  for (auto _ : state) {
+    const char *mark = (to ? "moved" : "back");
+    if (state.range(0)) {
+      for (dom_parser::DOMnodeUID row : uids) {
+        batch.setAttribute(row, "class", mark);
+        batch.moveSubtree(row, tables[to]);
+      }
+      if (!batch.commit())
+        state.SkipWithError("batch rejected");
+    } else {
+      for (dom_parser::DOMnodeUID row : uids) {
+        tree.getNode(row).setAttribute("class", mark);
+        tree.moveSubtree(row, tables[to]);
+      }
+    }
+    benchmark::DoNotOptimize(tree.getNode(tables[to]).getChildCount());
+    to = 1 - to;
+  }
+  state.SetItemsProcessed(state.iterations() * rows * 2);
+}
+BENCHMARK(BatchedRewrite)->ArgsProduct({{0, 1}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+// Builds rows with class and id attributes, with the secondary indexes
+// disabled (0) or enabled (1), to measure the cost of keeping them. With the
+// indexes an id and a class are looked up at the end, which adds the entries
+// queued by the build.
+static void IndexedBuild(benchmark::State &state) {
+  const int rows = 20000;
+  for (auto _ : state) {
+    dom_parser::DOMtree tree("root");
+    if (state.range(0))
+      tree.enableIndexes();
+    for (int i = 0; i < rows; i++) {
+      dom_parser::DOMnodeUID row = tree.addNode(0, "tr");
+      tree.getNode(row).setAttribute("class", (i % 2 ? "row odd" : "row even"));
+      tree.getNode(row).setAttribute("id", "r" + std::to_string(i));
+      for (int j = 0; j < 4; j++)
+        tree.addNode(row, "td");
+    }
+    if (state.range(0)) {
+      benchmark::DoNotOptimize(tree.getElementById("r0"));
+      benchmark::DoNotOptimize(tree.getElementsByClassName("odd").size());
+    }
+    benchmark::DoNotOptimize(tree.getNode(0).getChildCount());
+  }
+  state.SetItemsProcessed(state.iterations() * rows * 5);
+}
+BENCHMARK(IndexedBuild)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Looks up elements by id and by tag in part.xml, walking the tree (0) or
+// through the secondary indexes (1).
+static void IndexedLookup(benchmark::State &state) {
+  dom_parser::DOMparser parser;
+  parser.loadTree(std::filesystem::path("../include/test/part.xml"));
+  dom_parser::DOMtree tree = parser.takeTree();
+  if (state.range(0))
+    tree.enableIndexes();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tree.getElementById("none"));
+    benchmark::DoNotOptimize(tree.getElementsByTagName("T").size());
+  }
+}
+BENCHMARK(IndexedLookup)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// Runs a selector over a big tree by a serial walk (0), a walk split into
+// subtree tasks (1), and through the tag index with interval labels (2).
+static void SelectorQuery(benchmark::State &state) {
+  dom_parser::DOMtree tree("root");
+  for (int i = 0; i < 50; i++) {
+    dom_parser::DOMnodeUID table = tree.addNode(0, "table");
+    for (int j = 0; j < 500; j++) {
+      dom_parser::DOMnodeUID row = tree.addNode(table, "tr");
+      tree.getNode(row).setAttribute("class", (j % 10 ? "row" : "row marked"));
+      for (int k = 0; k < 3; k++)
+        tree.addInnerDataNode(tree.addNode(row, "td"), "cell");
+    }
+  }
+  if (state.range(0) == 2) {
+    tree.enableIndexes();
+    tree.enableIntervalLabels();
+  }
+  tf::Executor executor;
+  dom_parser::DOMselectorEngine engine(state.range(0) == 1 ? &executor : nullptr);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(engine.querySelectorAll(tree, "table > tr.marked td:nth-child(2)").size());
+}
+BENCHMARK(SelectorQuery)->DenseRange(0, 2, 1)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// Filters part.xml with an XPath expression by building the tree and
+// evaluating on it (0), and by streaming the file without a tree (1).
+static void XPathFilter(benchmark::State &state) {
+  std::filesystem::path file("../include/test/part.xml");
+  auto xpath = dom_parser::DOMxpath::compile("/table/T[P_SIZE>5]/P_NAME");
+  for (auto _ : state) {
+    std::size_t matches = 0;
+    if (state.range(0)) {
+      xpath->stream(file, [&matches](const dom_parser::DOMxpathMatch &) { matches++; });
+    } else {
+      dom_parser::DOMparser parser;
+      parser.loadTree(file);
+      matches = xpath->values(parser.getTree()).size();
+    }
+    benchmark::DoNotOptimize(matches);
+  }
+}
+BENCHMARK(XPathFilter)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Per-node work of a couple hundred nanoseconds.
+static std::size_t NodeWork(const dom_parser::DOMnode &node) {
+  std::size_t h = node.getUID();
+  for (int i = 0; i < 64; i++)
+    h = h * 1099511628211ull + (h >> 29) + i;
+  return h;
+}
+
+// Visits every node of part.xml with one task per node, as main.cpp
+// builds the graph (0), and with for_each_node over chunks (1).
+static void ParallelForEach(benchmark::State &state) {
+  dom_parser::DOMparser parser;
+  parser.loadTree(std::filesystem::path("../include/test/part.xml"));
+  dom_parser::DOMtree tree = parser.takeTree();
+  std::vector<dom_parser::DOMnodeUID> uids{0};
+  for (std::size_t i = 0; i < uids.size(); i++)
+    for (dom_parser::DOMnodeUID child : tree.getNode(uids[i]).getChildrenUID())
+      uids.push_back(child);
+  tf::Executor executor;
+  std::atomic<std::size_t> sum{0};
+  for (auto _ : state) {
+    if (state.range(0)) {
+      dom_parser::parallel::for_each_node(executor, tree, [&sum](dom_parser::DOMnode &node) {
+        sum.fetch_add(NodeWork(node), std::memory_order_relaxed);
+      });
+    } else {
+      tf::Taskflow taskflow;
+      for (dom_parser::DOMnodeUID uid : uids)
+        taskflow.emplace([&sum, &tree, uid]() {
+          sum.fetch_add(NodeWork(tree.getNode(uid)), std::memory_order_relaxed);
+        });
+      executor.run(taskflow).wait();
+    }
+  }
+  benchmark::DoNotOptimize(sum.load());
+  state.SetItemsProcessed(state.iterations() * tree.getNodeCount());
+}
+BENCHMARK(ParallelForEach)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Sums NodeWork bottom-up over part.xml with a pre and a post task per
+// node built on every run, as main.cpp used to (0), and with a cached
+// DOMtreePass (1).
+static void TreePass(benchmark::State &state) {
+  dom_parser::DOMparser parser;
+  parser.loadTree(std::filesystem::path("../include/test/part.xml"));
+  dom_parser::DOMtree tree = parser.takeTree();
+  tf::Executor executor;
+  dom_parser::DOMtreePass<std::size_t, std::size_t> pass(tree, 0, executor.num_workers());
+  std::vector<std::size_t> depths(tree.getNodeCount()), sums(tree.getNodeCount());
+  std::size_t total = 0;
+  for (auto _ : state) {
+    if (state.range(0)) {
+      total = pass.run(
+          executor, 0,
+          [](dom_parser::DOMnode &, const std::size_t &depth) { return depth + 1; },
+          [](dom_parser::DOMnode &node, const std::size_t &depth, std::vector<std::size_t> &children) {
+            std::size_t sum = NodeWork(node) * depth;
+            for (std::size_t child : children)
+              sum += child;
+            return sum;
+          });
+    } else {
+      // nodes in breadth-first order, children of a node are consecutive
+      tf::Taskflow taskflow;
+      std::vector<dom_parser::DOMnodeUID> uids{0};
+      std::vector<std::size_t> parents{0};
+      std::vector<tf::Task> pres, posts;
+      for (std::size_t i = 0; i < uids.size(); i++) {
+        std::size_t first = uids.size();
+        for (dom_parser::DOMnodeUID child : tree.getNode(uids[i]).getChildrenUID()) {
+          uids.push_back(child);
+          parents.push_back(i);
+        }
+        std::size_t last = uids.size(), parent = parents[i];
+        pres.push_back(taskflow.emplace([&depths, i, parent]() {
+          depths[i] = i == 0 ? 1 : depths[parent] + 1;
+        }));
+        posts.push_back(taskflow.emplace([&tree, &uids, &depths, &sums, i, first, last]() {
+          std::size_t sum = NodeWork(tree.getNode(uids[i])) * depths[i];
+          for (std::size_t c = first; c < last; c++)
+            sum += sums[c];
+          sums[i] = sum;
+        }));
+        pres[i].precede(posts[i]);
+        if (i > 0) {
+          pres[parent].precede(pres[i]);
+          posts[i].precede(posts[parent]);
+        }
+      }
+      executor.run(taskflow).wait();
+      total = sums[0];
+    }
+  }
+  benchmark::DoNotOptimize(total);
+  state.SetItemsProcessed(state.iterations() * tree.getNodeCount());
+}
+BENCHMARK(TreePass)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Minified serialization of the tree, to compare trees in the benches.
+static std::string serialize(const dom_parser::DOMtree &tree) {
+  std::string out;
+  char buffer[4096];
+  dom_parser::DOMoutputSink sink(buffer, sizeof(buffer), [&out](const char *data, std::size_t size) {
+    out.append(data, size);
+    return true;
+  });
+  dom_parser::DOMwriter(true).write(tree, 0, sink);
+  return out;
+}
+
+// Diffs part.xml against a revision with every 100th text changed and
+// patches a copy of the old tree with the script, which must give the
+// revision.
+static void DiffPatch(benchmark::State &state) {
+  dom_parser::DOMparser parser;
+  parser.loadTree(std::filesystem::path("../include/test/part.xml"));
+  dom_parser::DOMtree tree = parser.takeTree();
+  dom_parser::DOMtree revision = tree.clone();
+  std::vector<dom_parser::DOMnodeUID> uids{0};
+  for (std::size_t i = 0; i < uids.size(); i++)
+    for (dom_parser::DOMnodeUID child : revision.getNode(uids[i]).getChildrenUID())
+      uids.push_back(child);
+  for (std::size_t i = 0; i < uids.size(); i += 100)
+    if (revision.getNode(uids[i]).isInnerDataNode())
+      revision.getNode(uids[i]).setInnerData("changed");
+  const std::string expected = serialize(revision);
+  std::size_t edits = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    dom_parser::DOMtree patched = tree.clone();
+    state.ResumeTiming();
+    dom_parser::DOMdiff diff(patched, revision);
+    diff.patch();
+    edits = diff.getEdits().size();
+    state.PauseTiming();
+    if (serialize(patched) != expected) {
+      state.SkipWithError("patched tree differs from the revision");
+      break;
+    }
+    state.ResumeTiming();
+  }
+  state.counters["edits"] = edits;
+  state.SetItemsProcessed(state.iterations() * tree.getNodeCount());
+}
+BENCHMARK(DiffPatch)->Unit(benchmark::kMillisecond);
+
+// Hashes every subtree of part.xml (0), and rehashes the root after one
+// text changed (1).
+static void MerkleHash(benchmark::State &state) {
+  dom_parser::DOMparser parser;
+  parser.loadTree(std::filesystem::path("../include/test/part.xml"));
+  dom_parser::DOMtree tree = parser.takeTree();
+  tree.enableHashes();
+  dom_parser::DOMnodeUID text = 0;
+  while (!tree.getNode(text).isInnerDataNode())
+    text = tree.getNode(text).getLastChild();
+  int changes = 0;
+  for (auto _ : state) {
+    if (state.range(0)) {
+      tree.getNode(text).setInnerData(std::to_string(changes++ % 2));
+      benchmark::DoNotOptimize(tree.getHash());
+    } else {
+      tree.enableHashes();
+      benchmark::DoNotOptimize(tree.getHash());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(MerkleHash)->Arg(0)->Arg(1);
+
+// Walks part.xml in document order summing the text lengths, on the tree (0)
+// and on its compressed copy (1).
+static void CompressedTraversal(benchmark::State &state) {
+  dom_parser::DOMparser parser;
+  parser.loadTree(std::filesystem::path("../include/test/part.xml"));
+  dom_parser::DOMtree tree = parser.takeTree();
+  tree.compact();
+  dom_parser::DOMcompressedTree compressed(tree);
+  std::size_t length = 0;
+  for (auto _ : state) {
+    length = 0;
+    if (state.range(0)) {
+      dom_parser::DOMcompressedNode node = compressed.getRoot();
+      while (true) {
+        length += node.getInnerData().size();
+        if (node.toFirstChild())
+          continue;
+        while (!node.toNextSibling() && node.toParent())
+          ;
+        if (node.getDepth() == 0)
+          break;
+      }
+    } else {
+      const dom_parser::DOMnode *node = &tree.getNode(0);
+      while (true) {
+        length += node->getInnerData().size();
+        if (node->getFirstChild() != -1) {
+          node = &tree.getNode(node->getFirstChild());
+          continue;
+        }
+        while (node->getUID() != 0 && node->getNextSibling() == -1)
+          node = &tree.getNode(node->getParent());
+        if (node->getUID() == 0)
+          break;
+        node = &tree.getNode(node->getNextSibling());
+      }
+    }
+    benchmark::DoNotOptimize(length);
+  }
+  // nodes and text of the tree, without the attributes
+  state.counters["bytes"] = (state.range(0) ? compressed.getMemoryUsage()
+                                            : tree.getNodeCount() * sizeof(dom_parser::DOMnode) + length);
+  state.SetItemsProcessed(state.iterations() * tree.getNodeCount());
+}
+BENCHMARK(CompressedTraversal)->Arg(0)->Arg(1);
+
+// Copies the table of part.xml node by node with addNode and setAttribute
+// (0), and in one pass with graft (1).
+static void SubtreeGraft(benchmark::State &state) {
+  dom_parser::DOMparser parser;
+  parser.loadTree(std::filesystem::path("../include/test/part.xml"));
+  dom_parser::DOMtree source = parser.takeTree();
+  for (auto _ : state) {
+    dom_parser::DOMtree tree("copies");
+    if (state.range(0)) {
+      benchmark::DoNotOptimize(tree.graft(source, 0, 0));
+      continue;
+    }
+    std::vector<std::pair<dom_parser::DOMnodeUID, dom_parser::DOMnodeUID>> stack{{0, 0}};
+    while (!stack.empty()) {
+      auto [from, to] = stack.back();
+      stack.pop_back();
+      const dom_parser::DOMnode &node = source.getNode(from);
+      dom_parser::DOMnodeUID copy;
+      if (node.isInnerDataNode()) {
+        copy = tree.addInnerDataNode(to, node.getInnerData());
+      } else {
+        copy = tree.addNode(to, node.getTagName());
+        for (auto attribute : node.getAllAttributes())
+          tree.getNode(copy).setAttribute(attribute.first, attribute.second);
+      }
+      for (auto child = node.getLastChild(); child != -1; child = source.getNode(child).getPrevSibling())
+        stack.push_back({child, copy});
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * source.getNodeCount());
+}
+BENCHMARK(SubtreeGraft)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Finds the texts of part.xml holding a word by walking the nodes (0) and
+// with the text index (1).
+static void TextSearch(benchmark::State &state) {
+  dom_parser::DOMparser parser;
+  parser.loadTree(std::filesystem::path("../include/test/part.xml"));
+  dom_parser::DOMtree tree = parser.takeTree();
+  if (state.range(0))
+    tree.enableTextIndex();
+  std::size_t found = 0;
+  for (auto _ : state) {
+    found = tree.findText("goldenrod").size();
+    benchmark::DoNotOptimize(found);
+  }
+  state.counters["found"] = found;
+}
+BENCHMARK(TextSearch)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// Builds the text index of part.xml.
+static void TextIndexBuild(benchmark::State &state) {
+  dom_parser::DOMparser parser;
+  parser.loadTree(std::filesystem::path("../include/test/part.xml"));
+  dom_parser::DOMtree tree = parser.takeTree();
+  for (auto _ : state)
+    tree.enableTextIndex();
+  state.SetItemsProcessed(state.iterations() * tree.getNodeCount());
+}
+BENCHMARK(TextIndexBuild)->Unit(benchmark::kMillisecond);
+
+// Fills part.xml columns (key, size, price, brand and type) by parsing a tree
+// and walking its rows (0), and by reading them straight from the file (1).
+static void ColumnExtraction(benchmark::State &state) {
+  const std::filesystem::path path("../include/test/part.xml");
+  for (auto _ : state) {
+    if (state.range(0)) {
+      dom_parser::DOMcolumnReader reader("table/T");
+      reader.addColumn("P_PARTKEY", dom_parser::DOMcolumnType::INT64);
+      reader.addColumn("P_SIZE", dom_parser::DOMcolumnType::INT64);
+      reader.addColumn("P_RETAILPRICE", dom_parser::DOMcolumnType::DOUBLE);
+      reader.addColumn("P_BRAND", dom_parser::DOMcolumnType::STRING);
+      reader.addColumn("P_TYPE", dom_parser::DOMcolumnType::STRING);
+      dom_parser::DOMcolumnTable table;
+      reader.load(path, table);
+      benchmark::DoNotOptimize(table.getRowCount());
+      continue;
+    }
+    dom_parser::DOMparser parser;
+    parser.loadTree(path);
+    const dom_parser::DOMtree &tree = parser.getTree();
+    std::vector<int64_t> keys, sizes;
+    std::vector<double> prices;
+    std::vector<uint32_t> brands, types;
+    std::unordered_map<std::string, uint32_t> brandCodes, typeCodes;
+    for (auto row : tree.getNode(0).getChildrenUID()) {
+      for (auto field : tree.getNode(row).getChildrenUID()) {
+        const dom_parser::DOMnode &node = tree.getNode(field);
+        if (node.getChildCount() != 1)
+          continue;
+        std::string text(tree.getNode(node.getFirstChild()).getInnerData());
+        std::string_view tag = node.getTagName();
+        if (tag == "P_PARTKEY")
+          keys.push_back(std::stoll(text));
+        else if (tag == "P_SIZE")
+          sizes.push_back(std::stoll(text));
+        else if (tag == "P_RETAILPRICE")
+          prices.push_back(std::stod(text));
+        else if (tag == "P_BRAND")
+          brands.push_back(brandCodes.emplace(text, brandCodes.size()).first->second);
+        else if (tag == "P_TYPE")
+          types.push_back(typeCodes.emplace(text, typeCodes.size()).first->second);
+      }
+    }
+    benchmark::DoNotOptimize(keys.size());
+  }
+  state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(path));
+}
+BENCHMARK(ColumnExtraction)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Reads the prices and sizes of part.xml as numbers through std::stod and
+// std::stoll (0), the typed accessors of the tree (1) and the typed accessors
+// with a warm number cache (2).
+static void NumericAccess(benchmark::State &state) {
+  dom_parser::DOMparser parser;
+  parser.loadTree(std::filesystem::path("../include/test/part.xml"));
+  dom_parser::DOMtree &tree = parser.getTree();
+  std::vector<dom_parser::DOMnodeUID> prices = tree.getElementsByTagName("P_RETAILPRICE");
+  std::vector<dom_parser::DOMnodeUID> sizes = tree.getElementsByTagName("P_SIZE");
+  std::vector<double> priceValues;
+  std::vector<int64_t> sizeValues;
+  if (state.range(0) == 2) {
+    tree.enableNumberCache();
+    tree.getInnerDataAs(prices, priceValues);
+    tree.getInnerDataAs(sizes, sizeValues);
+  }
+  for (auto _ : state) {
+    if (state.range(0) == 0) {
+      priceValues.clear();
+      sizeValues.clear();
+      for (auto uid : prices)
+        priceValues.push_back(std::stod(std::string(tree.getNode(uid).getTextNode()->getInnerData())));
+      for (auto uid : sizes)
+        sizeValues.push_back(std::stoll(std::string(tree.getNode(uid).getTextNode()->getInnerData())));
+    } else {
+      tree.getInnerDataAs(prices, priceValues);
+      tree.getInnerDataAs(sizes, sizeValues);
+    }
+    benchmark::DoNotOptimize(priceValues.data());
+    benchmark::DoNotOptimize(sizeValues.data());
+  }
+  state.SetItemsProcessed(state.iterations() * (prices.size() + sizes.size()));
+}
+BENCHMARK(NumericAccess)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMicrosecond);
+
+// Serializes part.xml into a string with getOutput (0) and into a sink which
+// drops the data (1).
+static void Serialize(benchmark::State &state) {
+  dom_parser::DOMparser parser;
+  parser.loadTree(std::filesystem::path("../include/test/part.xml"));
+  std::size_t bytes = 0;
+  for (auto _ : state) {
+    if (state.range(0) == 0) {
+      bytes = parser.getOutput().size();
+      continue;
+    }
+    char buffer[dom_parser::DOMoutputSink::BUFFER_SIZE];
+    bytes = 0;
+    dom_parser::DOMoutputSink sink(buffer, sizeof(buffer), [&bytes](const char *data, std::size_t size) {
+      benchmark::DoNotOptimize(data);
+      bytes += size;
+      return true;
+    });
+    parser.writeOutput(sink);
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(Serialize)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Commits edits to a versioned copy of ebay.xml from one writer while the
+// given number of readers walk snapshots. Every commit sets attribute v of two
+// nodes to the same value and swaps a subtree; a reader seeing the two values
+// differ, a subtree without its text or an older version than before fails
+// the benchmark.
+static void SnapshotReaders(benchmark::State &state) {
+  dom_parser::DOMparser parser;
+  parser.loadTree(std::filesystem::path("../include/test/ebay.xml"));
+  dom_parser::DOMversionedTree versioned(parser.getTree());
+  dom_parser::DOMnodeUID a = versioned.addNode(0, "a"), b = versioned.addNode(0, "b");
+  versioned.commit();
+  const int commits = 2000;
+  for (auto _ : state) {
+    std::atomic<bool> done{false}, torn{false};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < state.range(0); r++)
+      readers.emplace_back([&]() {
+        std::uint64_t last = 0;
+        while (!done.load(std::memory_order_acquire)) {
+          dom_parser::DOMsnapshot snapshot = versioned.snapshot();
+          if (snapshot.getVersion() < last)
+            torn = true;
+          last = snapshot.getVersion();
+          std::string_view va, vb;
+          std::vector<const dom_parser::DOMpersistentNode *> stack{snapshot.getRoot()};
+          while (!stack.empty()) {
+            const dom_parser::DOMpersistentNode *node = stack.back();
+            stack.pop_back();
+            if (node->getUID() == a)
+              va = snapshot.getAttribute(*node, "v");
+            else if (node->getUID() == b)
+              vb = snapshot.getAttribute(*node, "v");
+            else if (snapshot.getTagName(*node) == "swap" && node->getChildCount() != 1)
+              torn = true;
+            for (std::size_t i = 0; i < node->getChildCount(); i++)
+              stack.push_back(node->getChild(i));
+          }
+          if (va != vb)
+            torn = true;
+        }
+      });
+    dom_parser::DOMnodeUID swapped = -1;
+    for (int i = 0; i < commits; i++) {
+      std::string value = std::to_string(i);
+      versioned.setAttribute(a, "v", value);
+      versioned.setAttribute(b, "v", value);
+      if (swapped != -1)
+        versioned.deleteSubtree(swapped);
+      swapped = versioned.addNode(0, "swap");
+      versioned.addInnerDataNode(swapped, value);
+      versioned.commit();
+    }
+    done = true;
+    for (auto &reader : readers)
+      reader.join();
+    if (torn) {
+      state.SkipWithError("a reader saw a torn snapshot");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * commits);
+}
+BENCHMARK(SnapshotReaders)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Sets an attribute on a row of a table with the given number of rows in a
+// versioned tree and commits, which path-copies the root, the table and the
+// row.
+static void VersionedEdit(benchmark::State &state) {
+  const int rows = state.range(0);
+  dom_parser::DOMtree tree("root");
+  dom_parser::DOMnodeUID table = tree.addNode(0, "table");
+  std::vector<dom_parser::DOMnodeUID> uids;
+  for (int i = 0; i < rows; i++)
+    uids.push_back(tree.addNode(table, "tr"));
+  dom_parser::DOMversionedTree versioned(tree);
+  std::size_t i = 0;
+  for (auto _ : state) {
+    i = (i * 7919 + 1) % uids.size();
+    versioned.setAttribute(uids[i], "v", "1");
+    benchmark::DoNotOptimize(versioned.commit());
+  }
+}
+BENCHMARK(VersionedEdit)->Arg(100)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// Builds one subtree per thread under a shared root through tree workers.
+static void ConcurrentBuild(benchmark::State &state) {
+  const int threads = state.range(0);
+  const int nodes = 200000 / threads;
+  for (auto _ : state) {
+    dom_parser::DOMtree tree("root");
+    dom_parser::DOMsymbol td = tree.getSymbols().intern("td");
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+      workers.emplace_back([&tree, td, nodes]() {
+        dom_parser::DOMtreeWorker worker(tree);
+        dom_parser::DOMnodeUID row = worker.addNode(0, "tr");
+        for (int i = 0; i < nodes; i++)
+          worker.addInnerDataNode(worker.addNode(row, td), "cell");
+      });
+    for (auto &worker : workers)
+      worker.join();
+    benchmark::DoNotOptimize(tree.getNode(0).getChildCount());
+  }
+  state.SetItemsProcessed(state.iterations() * threads * nodes * 2);
+}
+BENCHMARK(ConcurrentBuild)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -21,8 +21,10 @@ THE CODE HERE IS NOT DOCUMENTED.
 #include "DOMnode.hpp"
 #include "DOMparser.hpp"
 #include "DOMtree.hpp"
+#include "DOMtreePass.hpp"
 #include "taskflow/taskflow.hpp"
 #include <CLI11/CLI11.hpp>
+#include <cassert>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
@@ -39,49 +41,10 @@ std::atomic<size_t> counter{0};
 // #include "./test/test.hpp"
 // #undef DOM_PARSER_DEBUG_MODE
 
-void postTask(dom_parser::DOMnode &node) {
-  std::cout << node.getTagName() << std::endl;
-  std::cout << "post task\n";
-  // Post task based on child updates
-}
-
 inline void debug_print(string s) {
   std::cout << "\n\tloadTest: " << s << "\n";
 }
 
-void printNode(dom_parser::DOMnode &node, dom_parser::DOMtree &tree,
-               tf::Taskflow &taskflow, std::vector<tf::Task> &tasks,
-               tf::Task &parent, tf::Task *pre_parent) {
-  std::cout << node.getTagName() << std::endl;
-
-  tf::Task pretsk = taskflow
-                        .emplace([&]() {
-                          // task = task
-                          postTask(tree.getNode(node.getUID()));
-                        })
-                        .name("Pre|"+tree.getNode(node.getUID()).getTagName()+"|"+std::to_string(node.getUID()));
-
-  if (pre_parent != nullptr) {
-    pre_parent->precede(pretsk);
-  }
-
-  if (node.getChildrenUID().empty()) {
-    pretsk.precede(parent);
-  }
-
-  for (auto child : node.getChildrenUID()) {
-    tf::Task tsk = taskflow
-                       .emplace([&]() {
-                         // task = task
-                         postTask(tree.getNode(child));
-                       })
-                       .name("Pst|"+tree.getNode(child).getTagName()+"|"+std::to_string(tree.getNode(child).getUID()));
-    tasks.push_back(tsk);
-    tsk.precede(parent);
-    printNode(tree.getNode(child), tree, taskflow, tasks, tsk, &pretsk);
-  }
-}
-
 int main(int argc, char **argv) {
 
   CLI::App app{"BinaryTree"};
@@ -117,28 +80,41 @@ int main(int argc, char **argv) {
   //   debug_print("Output is present in: " + output_file);
   //std::cout << parser.getOutput();
   tf::Executor executor(2);
-  std::vector<tf::Task> tasks;
-  tf::Taskflow taskflow;
-
-  dom_parser::DOMtree domtree = parser.getTree();
-  dom_parser::DOMnodeUID uid = 0;
-
-  dom_parser::DOMnode node = domtree.getNode(uid);
 
-  tf::Task root =
-      taskflow
-          .emplace([&]() { counter.fetch_add(1, std::memory_order_relaxed); })
-          .name(node.getTagName());
-  printNode(node, domtree, taskflow, tasks, root, nullptr);
+  dom_parser::DOMtree domtree = parser.takeTree();
+  dom_parser::DOMtreePass<size_t, size_t> pass(domtree, 0, executor.num_workers());
+
+  // depth of every node on the way down, subtree sizes on the way up
+  size_t nodes = pass.run(
+      executor, 0,
+      [](dom_parser::DOMnode &, const size_t &depth) {
+        counter.fetch_add(1, std::memory_order_relaxed);
+        return depth + 1;
+      },
+      [](dom_parser::DOMnode &, vector<size_t> &children) {
+        size_t size = 1;
+        for (size_t child : children)
+          size += child;
+        return size;
+      });
+  std::cout << "\nNodes " << nodes << ", tasks " << pass.getTaskCount()
+            << std::endl;
+  assert(nodes == counter);
+
+  // a handle of a deleted node stays invalid once its slot is reused, also
+  // across compaction
+  dom_parser::DOMnodeUID stale = domtree.addNode(0, "stale");
+  domtree.deleteSubtree(stale);
+  dom_parser::DOMnodeUID reused = domtree.addNode(0, "reused");
+  std::vector<dom_parser::DOMnodeUID> renumbered = domtree.compact();
+  assert(!domtree.isValid(stale));
+  assert(domtree.getNode(renumbered[dom_parser::uidSlot(reused)]).getTagName() == "reused");
 
-  taskflow.dump(std::cout);
   // auto beg = std::chrono::high_resolution_clock::now();
   // executor.run(taskflow).get();
   // auto end = std::chrono::high_resolution_clock::now();
   // auto time = std::chrono::duration_cast<std::chrono::microseconds>(end - beg);
 
-  // std::cout << "Counter " << counter << std::endl;
-  // assert(counter + 1 == tasks.size());
 
   //   loadTest.set_file(model);
   //   //   int select_file = 2;